@@ -9,7 +9,7 @@ void ColorDetection::beginAutoMode(void) {
         .exposureTime = MS320 };
     ColorDetection::configure(DEFAULT_CONFIG);
 
-    Logger::getInstance().logTrace("Successfully started ColorDetection module");
+    DEZIBOT_LOG_TRACE("Successfully started ColorDetection module");
 };
 
 void ColorDetection::configure(VEML_CONFIG config) {
@@ -66,12 +66,7 @@ uint16_t ColorDetection::getColorValue(color color){
             break;
     }
 
-    Logger::getInstance().logInfo(
-        "Getting color value for color Sensor "
-        + std::to_string(color)
-        + " with value: "
-        + std::to_string(value)
-    );
+    DEZIBOT_LOG_FORMAT(LogEntry::INFO, LogEntry::FMT_COLOR_VALUE, nullptr, color, value);
 
     return value;
 };
@@ -79,10 +74,7 @@ uint16_t ColorDetection::getColorValue(color color){
 float ColorDetection::getAmbientLight() {
     float value = rgbwSensor.getAmbientLight();
 
-    Logger::getInstance().logInfo(
-        "Getting ambient light with value: "
-        + std::to_string(value)
-    );
+    DEZIBOT_LOG_FORMAT(LogEntry::INFO, LogEntry::FMT_AMBIENT_LIGHT, nullptr, value);
 
     return value;
 };
@@ -0,0 +1,82 @@
+/**
+ * @file ChunkedResponse.cpp
+ * @author Tim Dietrich, Felix Herrling
+ * @brief Implementation of the ChunkedResponse class.
+ * @version 1.0
+ * @date 2025-03-23
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "ChunkedResponse.h"
+
+ChunkedResponse::ChunkedResponse(WebServer* server, const int code, const char* contentType)
+    : serverPointer(server) {
+    // without a content length the server switches to chunked transfer encoding
+    serverPointer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+    serverPointer->send(code, contentType, "");
+}
+
+ChunkedResponse::~ChunkedResponse() {
+    end();
+}
+
+size_t ChunkedResponse::write(const uint8_t byte) {
+    if (used == BUFFER_SIZE) {
+        flush();
+    }
+    buffer[used++] = static_cast<char>(byte);
+    return 1;
+}
+
+size_t ChunkedResponse::write(const uint8_t* data, const size_t length) {
+    size_t written = 0;
+    while (written < length) {
+        if (used == BUFFER_SIZE) {
+            flush();
+        }
+        size_t count = length - written;
+        if (count > BUFFER_SIZE - used) {
+            count = BUFFER_SIZE - used;
+        }
+        memcpy(buffer + used, data + written, count);
+        used += count;
+        written += count;
+    }
+    return written;
+}
+
+void ChunkedResponse::beginArray() {
+    firstElement = true;
+    write('[');
+}
+
+void ChunkedResponse::addArrayElement(const JsonDocument& element) {
+    if (!firstElement) {
+        write(',');
+    }
+    firstElement = false;
+    serializeJson(element, *this);
+}
+
+void ChunkedResponse::endArray() {
+    write(']');
+}
+
+void ChunkedResponse::end() {
+    if (ended) {
+        return;
+    }
+    flush();
+    // an empty chunk terminates the response
+    serverPointer->sendContent("");
+    ended = true;
+}
+
+void ChunkedResponse::flush() {
+    if (used > 0) {
+        serverPointer->sendContent(buffer, used);
+        used = 0;
+    }
+}
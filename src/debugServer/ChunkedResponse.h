@@ -0,0 +1,74 @@
+/**
+ * @file ChunkedResponse.h
+ * @author Tim Dietrich, Felix Herrling
+ * @brief Streams a response body to the client using chunked transfer encoding.
+ * Data written through the Print interface is collected in a small fixed buffer and
+ * sent as one chunk whenever the buffer is full, so the memory needed per request does
+ * not depend on the size of the response. Usable as target of ArduinoJson's serializeJson.
+ * @version 1.0
+ * @date 2025-03-23
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef CHUNKEDRESPONSE_H
+#define CHUNKEDRESPONSE_H
+
+#include <WebServer.h>
+#include <ArduinoJson.h>
+
+class ChunkedResponse : public Print {
+public:
+    /**
+     * @brief Sends the status line and headers. Additional headers have to be set with
+     * sendHeader() before the response is created.
+     */
+    ChunkedResponse(WebServer* server, int code, const char* contentType);
+
+    /**
+     * @brief Finishes the response if end() has not been called yet.
+     */
+    ~ChunkedResponse() override;
+
+    size_t write(uint8_t byte) override;
+    size_t write(const uint8_t* data, size_t length) override;
+
+    /**
+     * @brief Starts a JSON array, elements are added with addArrayElement().
+     */
+    void beginArray();
+
+    /**
+     * @brief Serializes one element of the array started by beginArray().
+     * @param element a document holding just this element, it can be cleared and reused
+     * for the next one.
+     */
+    void addArrayElement(const JsonDocument& element);
+
+    /**
+     * @brief Closes the array started by beginArray().
+     */
+    void endArray();
+
+    /**
+     * @brief Sends the remaining buffered data and the terminating chunk.
+     */
+    void end();
+
+private:
+    void flush();
+
+    ChunkedResponse(const ChunkedResponse&) = delete;
+    ChunkedResponse& operator=(const ChunkedResponse&) = delete;
+
+    static constexpr size_t BUFFER_SIZE = 512; ///< Size of a single chunk
+
+    WebServer* serverPointer;
+    char buffer[BUFFER_SIZE];
+    size_t used = 0;
+    bool firstElement = true;
+    bool ended = false;
+};
+
+#endif //CHUNKEDRESPONSE_H
@@ -17,6 +17,9 @@
 #include <WebServer.h>
 #include <WiFi.h>
 #include <SPIFFS.h>
+#include <logger/LogDatabase.h>
+#include <logger/LogFlashStore.h>
+#include <logger/Logger.h>
 
 WebServer server;
 extern Dezibot dezibot;
@@ -32,7 +35,16 @@ DebugServer::DebugServer() : server(80)
 
 void DebugServer::setup()
 {
-    SPIFFS.begin();
+    // keep a copy of the logs on flash so they survive a reset, the drain task only writes
+    // to flash once a store is set
+    if (!SPIFFS.begin())
+    {
+        DEZIBOT_LOG_ERROR("SPIFFS mount failed, logs are kept in RAM only");
+    }
+    else if (LogFlashStore::getInstance().begin(SPIFFS))
+    {
+        LogDatabase::getInstance().setFlashStore(&LogFlashStore::getInstance());
+    }
 
     const char *SSID = "Debug-Server";
     const char *PSK = "PW4studProj";
@@ -1,8 +1,11 @@
 #include "LiveDataPage.h"
+#include "ChunkedResponse.h"
 #include <Dezibot.h>
 #include <ArduinoJson.h>
 #include <logger/Logger.h>
 #include <shared/SenderMap.h>
+#include <shared/TelemetryHistory.h>
+#include <vector>
 
 extern Dezibot dezibot;
 
@@ -10,6 +13,8 @@ LiveDataPage::LiveDataPage(WebServer *server) : serverPointer(server)
 {
     server->on("/getEnabledSensorValues", [this]()
                { getEnabledSensorValues(); });
+    server->on("/getHistory", [this]()
+               { getHistory(); });
 }
 
 void LiveDataPage::handler()
@@ -17,69 +22,86 @@ void LiveDataPage::handler()
     serveFileFromSpiffs(serverPointer, "/index.html", "text/html");
 }
 
-static void addSensorJson(JsonArray &arr, const char *name, const String &value)
+// fields names the history fields behind the value, in the order they appear in it, see getHistory()
+static void addSensorJson(ChunkedResponse &response, JsonDocument &obj, const char *name, const String &value,
+                          const char *fields = nullptr)
 {
-    JsonObject obj = arr.add<JsonObject>();
+    obj.clear();
     obj["name"] = name;
     obj["value"] = value;
+    if (fields != nullptr)
+        obj["fields"] = fields;
+    response.addArrayElement(obj);
 }
 
 void LiveDataPage::getRemoteSensorValues(const String &mac)
 {
-    JsonDocument jsonDoc;
-    JsonArray sensorArray = jsonDoc.to<JsonArray>();
+    // copy the message, then stream; the receive path is never held up
+    SensorMessage m;
+    bool found = false;
 
-    auto &senderMap = getSenderMap();
-    SemaphoreHandle_t mutex = getSenderMapMutex();
+    DeviceTable &table = getDeviceTable();
 
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(50)) == pdTRUE)
+    uint64_t key;
+    if (DeviceTable::parseMac(mac.c_str(), key))
     {
-        auto it = senderMap.find(mac);
-        if (it != senderMap.end())
+        int slot = table.find(key);
+        if (slot >= 0)
         {
-            const SensorMessage &m = it->second.msg;
-
-            addSensorJson(sensorArray, "getAmbientLight()",
-                          String(m.ambientLight));
-            addSensorJson(sensorArray, "getRGB()",
-                          "blue: " + String(m.colorB) + ", red: " + String(m.colorR) + ", green: " + String(m.colorG));
-            addSensorJson(sensorArray, "getColorValue(RED)", String(m.colorR));
-            addSensorJson(sensorArray, "getColorValue(GREEN)", String(m.colorG));
-            addSensorJson(sensorArray, "getColorValue(BLUE)", String(m.colorB));
-            addSensorJson(sensorArray, "getColorValue(WHITE)", String(m.colorW));
-
-            addSensorJson(sensorArray, "getValue(IR_FRONT)", String(m.irFront));
-            addSensorJson(sensorArray, "getValue(IR_LEFT)", String(m.irLeft));
-            addSensorJson(sensorArray, "getValue(IR_RIGHT)", String(m.irRight));
-            addSensorJson(sensorArray, "getValue(IR_BACK)", String(m.irBack));
-            addSensorJson(sensorArray, "getValue(DL_BOTTOM)", String(m.dlBottom));
-            addSensorJson(sensorArray, "getValue(DL_FRONT)", String(m.dlFront));
-
-            addSensorJson(sensorArray, "left.getSpeed()", String(m.motorLeft));
-            addSensorJson(sensorArray, "right.getSpeed()", String(m.motorRight));
-
-            addSensorJson(sensorArray, "getAcceleration()",
-                          "x: " + String(m.accelX) + ", y: " + String(m.accelY) + ", z: " + String(m.accelZ));
-            addSensorJson(sensorArray, "getRotation()",
-                          "x: " + String(m.gyroX) + ", y: " + String(m.gyroY) + ", z: " + String(m.gyroZ));
-            addSensorJson(sensorArray, "getTemperature()", String(m.temperature));
-            addSensorJson(sensorArray, "getWhoAmI()", String(m.whoAmI));
-            addSensorJson(sensorArray, "getTilt()",
-                          "x: " + String(m.tiltX) + ", y: " + String(m.tiltY));
-            addSensorJson(sensorArray, "getTiltDirection()", String(m.tiltDirection));
-
-            addSensorJson(sensorArray, "freeHeap", String(m.freeHeap));
-            addSensorJson(sensorArray, "minFreeHeap", String(m.minFreeHeap));
-            addSensorJson(sensorArray, "taskCount", String(m.taskCount));
-            addSensorJson(sensorArray, "chipTemp", String(m.chipTemp));
-            addSensorJson(sensorArray, "estimatedPower (mW)", String(m.estimatedPowerMw));
+            table.read(slot, [&m](const SenderInfo &info)
+                       { m = info.msg; });
+            found = true;
         }
-        xSemaphoreGive(mutex);
     }
 
-    String jsonResponse;
-    serializeJson(jsonDoc, jsonResponse);
-    serverPointer->send(200, "application/json", jsonResponse);
+    JsonDocument obj;
+    ChunkedResponse response(serverPointer, 200, "application/json");
+    response.beginArray();
+
+    if (found)
+    {
+        addSensorJson(response, obj, "getAmbientLight()",
+                      String(m.ambientLight), "ambientLight");
+        addSensorJson(response, obj, "getRGB()",
+                      "blue: " + String(m.colorB) + ", red: " + String(m.colorR) + ", green: " + String(m.colorG),
+                      "colorB,colorR,colorG");
+        addSensorJson(response, obj, "getColorValue(RED)", String(m.colorR), "colorR");
+        addSensorJson(response, obj, "getColorValue(GREEN)", String(m.colorG), "colorG");
+        addSensorJson(response, obj, "getColorValue(BLUE)", String(m.colorB), "colorB");
+        addSensorJson(response, obj, "getColorValue(WHITE)", String(m.colorW), "colorW");
+
+        addSensorJson(response, obj, "getValue(IR_FRONT)", String(m.irFront), "irFront");
+        addSensorJson(response, obj, "getValue(IR_LEFT)", String(m.irLeft), "irLeft");
+        addSensorJson(response, obj, "getValue(IR_RIGHT)", String(m.irRight), "irRight");
+        addSensorJson(response, obj, "getValue(IR_BACK)", String(m.irBack), "irBack");
+        addSensorJson(response, obj, "getValue(DL_BOTTOM)", String(m.dlBottom), "dlBottom");
+        addSensorJson(response, obj, "getValue(DL_FRONT)", String(m.dlFront), "dlFront");
+
+        addSensorJson(response, obj, "left.getSpeed()", String(m.motorLeft), "motorLeft");
+        addSensorJson(response, obj, "right.getSpeed()", String(m.motorRight), "motorRight");
+
+        addSensorJson(response, obj, "getAcceleration()",
+                      "x: " + String(m.accelX) + ", y: " + String(m.accelY) + ", z: " + String(m.accelZ),
+                      "accelX,accelY,accelZ");
+        addSensorJson(response, obj, "getRotation()",
+                      "x: " + String(m.gyroX) + ", y: " + String(m.gyroY) + ", z: " + String(m.gyroZ),
+                      "gyroX,gyroY,gyroZ");
+        addSensorJson(response, obj, "getTemperature()", String(m.temperature), "temperature");
+        addSensorJson(response, obj, "getWhoAmI()", String(m.whoAmI));
+        addSensorJson(response, obj, "getTilt()",
+                      "x: " + String(m.tiltX) + ", y: " + String(m.tiltY),
+                      "tiltX,tiltY");
+        addSensorJson(response, obj, "getTiltDirection()", String(m.tiltDirection));
+
+        addSensorJson(response, obj, "freeHeap", String(m.freeHeap), "freeHeap");
+        addSensorJson(response, obj, "minFreeHeap", String(m.minFreeHeap));
+        addSensorJson(response, obj, "taskCount", String(m.taskCount));
+        addSensorJson(response, obj, "chipTemp", String(m.chipTemp), "chipTemp");
+        addSensorJson(response, obj, "estimatedPower (mW)", String(m.estimatedPowerMw), "estimatedPowerMw");
+    }
+
+    response.endArray();
+    response.end();
 }
 
 void LiveDataPage::getEnabledSensorValues()
@@ -90,8 +112,9 @@ void LiveDataPage::getEnabledSensorValues()
         return;
     }
 
-    JsonDocument jsonDoc;
-    JsonArray sensorArray = jsonDoc.to<JsonArray>();
+    JsonDocument sensorJson;
+    ChunkedResponse response(serverPointer, 200, "application/json");
+    response.beginArray();
 
     Logger::getInstance().setLoggingEnabled(false);
 
@@ -102,16 +125,139 @@ void LiveDataPage::getEnabledSensorValues()
         {
             if (sensorFunction.getSensorState())
             {
-                JsonObject sensorJson = sensorArray.add<JsonObject>();
+                sensorJson.clear();
                 sensorJson["name"] = sensorFunction.getFunctionName();
                 sensorJson["value"] = sensorFunction.getStringValue();
+                response.addArrayElement(sensorJson);
             }
         }
     }
 
     Logger::getInstance().setLoggingEnabled(true);
 
-    String jsonResponse;
-    serializeJson(jsonDoc, jsonResponse);
-    serverPointer->send(200, "application/json", jsonResponse);
+    response.endArray();
+    response.end();
+}
+
+void LiveDataPage::getHistory()
+{
+    uint64_t key;
+    if (!DeviceTable::parseMac(serverPointer->arg("mac").c_str(), key))
+    {
+        serverPointer->send(400, "application/json", "{\"error\":\"invalid mac parameter\"}");
+        return;
+    }
+
+    // field is one name or a comma separated list, e.g. field=accelX,accelY,accelZ
+    HistoryField fields[HISTORY_QUERY_FIELDS];
+    size_t fieldCount = 0;
+    const String fieldList = serverPointer->arg("field");
+    const char *name = fieldList.c_str();
+    while (*name != '\0')
+    {
+        const char *end = strchr(name, ',');
+        const size_t length = end != nullptr ? (size_t)(end - name) : strlen(name);
+        if (fieldCount == HISTORY_QUERY_FIELDS || !TelemetryHistory::fieldByName(name, length, fields[fieldCount]))
+        {
+            serverPointer->send(400, "application/json", "{\"error\":\"invalid field parameter\"}");
+            return;
+        }
+        fieldCount++;
+        name += length;
+        if (*name == ',')
+            name++;
+    }
+    if (fieldCount == 0)
+    {
+        serverPointer->send(400, "application/json", "{\"error\":\"missing field parameter\"}");
+        return;
+    }
+    // a chart that includes a field without rollups is answered from the raw samples only
+    bool rolledUp = true;
+    for (size_t f = 0; f < fieldCount; f++)
+        rolledUp = rolledUp && TelemetryHistory::hasRollups(fields[f]);
+
+    // only entries newer than since are returned, so a client polls with the last timestamp it got;
+    // points caps the answer, longer ranges are answered from coarser rollups
+    const bool hasSince = serverPointer->hasArg("since");
+    const uint32_t since = hasSince ? strtoul(serverPointer->arg("since").c_str(), nullptr, 10) : 0;
+    size_t points = TELEMETRY_HISTORY_SAMPLES;
+    if (serverPointer->hasArg("points"))
+        points = strtoul(serverPointer->arg("points").c_str(), nullptr, 10);
+    if (points == 0 || points > TELEMETRY_HISTORY_SAMPLES)
+        points = TELEMETRY_HISTORY_SAMPLES;
+
+    DeviceTable &table = getDeviceTable();
+    const int slot = table.find(key);
+    if (slot < 0)
+    {
+        serverPointer->send(404, "application/json", "{\"error\":\"unknown device\"}");
+        return;
+    }
+    // the first query of a device starts its recording, later ones keep it going
+    watchHistory(slot);
+
+    // copy the window, then serialize; the receive path is never held up. The buffers are
+    // sized before the read, so a callback that runs again only overwrites them and never allocates
+    std::vector<uint32_t> timestamps(points);
+    std::vector<float> values(points * fieldCount * 3); ///< Per field the means, then for rollups the minimums and maximums
+    size_t samples = 0;
+    uint32_t latest = 0;
+    size_t resolution = 0;
+    // The callback follows info.history into memory outside the slot. The copy is still
+    // consistent: watchHistory() sets the pointer and the receive path adds to the history only
+    // between beginWrite() and endWrite() of this slot, so read() runs the callback again whenever the
+    // history changed under it. Histories are never freed, a stale pointer stays readable.
+    table.read(slot, [&](const SenderInfo &info)
+               {
+                   samples = 0;
+                   latest = 0;
+                   resolution = 0;
+                   const TelemetryHistory *history = info.history;
+                   if (history == nullptr)
+                       return;
+                   if (history->size(0) > 0)
+                       latest = history->timestampAt(0, history->size(0) - 1);
+                   resolution = rolledUp ? history->chooseResolution(hasSince ? since : 0, points) : 0;
+                   const size_t count = history->size(resolution);
+                   size_t first = hasSince ? history->firstAfter(resolution, since) : 0;
+                   // a torn copy is thrown away, it only must not write out of bounds
+                   if (first > count)
+                       first = count;
+                   if (count - first > points)
+                       first = count - points;
+                   samples = count - first;
+                   for (size_t i = 0; i < samples; i++)
+                       timestamps[i] = history->timestampAt(resolution, first + i);
+                   const HistoryStat stats[] = {HISTORY_MEAN, HISTORY_MIN, HISTORY_MAX};
+                   for (size_t s = 0; s < (resolution == 0 ? 1 : 3); s++)
+                       for (size_t f = 0; f < fieldCount; f++)
+                           for (size_t i = 0; i < samples; i++)
+                               values[(s * fieldCount + f) * samples + i] =
+                                   history->valueAt(fields[f], resolution, first + i, stats[s]);
+               });
+
+    // latest lets a polling client notice that the sender restarted and its uptime went back
+    JsonDocument doc;
+    doc["latest"] = latest;
+    doc["resolutionMs"] = TelemetryHistory::resolutionMs(resolution);
+    JsonArray t = doc["t"].to<JsonArray>();
+    for (size_t i = 0; i < samples; i++)
+        t.add(timestamps[i]);
+    const char *const statNames[] = {"fields", "min", "max"};
+    for (size_t s = 0; s < (resolution == 0 ? 1 : 3); s++)
+    {
+        JsonObject columns = doc[statNames[s]].to<JsonObject>();
+        for (size_t f = 0; f < fieldCount; f++)
+        {
+            JsonArray column = columns[TelemetryHistory::fieldName(fields[f])].to<JsonArray>();
+            const float *first = values.data() + (s * fieldCount + f) * samples;
+            for (size_t i = 0; i < samples; i++)
+                column.add(first[i]);
+        }
+    }
+
+    ChunkedResponse response(serverPointer, 200, "application/json");
+    serializeJson(doc, response);
+    response.end();
 }
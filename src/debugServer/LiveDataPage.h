@@ -16,6 +16,13 @@
 #include <ArduinoJson.h>
 #include "PageProvider.h"
 
+/**
+ * @brief Fields a single /getHistory request may ask for.
+ */
+#ifndef HISTORY_QUERY_FIELDS
+#define HISTORY_QUERY_FIELDS 4
+#endif
+
 class LiveDataPage: public PageProvider {
 private:
     WebServer* serverPointer;
@@ -24,6 +31,7 @@ public:
     void handler() override;
     void getEnabledSensorValues();
     void getRemoteSensorValues(const String &mac);
+    void getHistory();
 };
 
 #endif //LIVEDATAPAGE_H
@@ -10,9 +10,12 @@
  */
 
 #include "LoggingPage.h"
+#include "ChunkedResponse.h"
 #include "logger/LogDatabase.h"
+#include "logger/LogFlashStore.h"
+#include "logger/LogFormatter.h"
 #include <ArduinoJson.h>
-#include "Utility.h"
+#include <algorithm>
 
 LoggingPage::LoggingPage(WebServer* server): serverPointer(server) {
     serverPointer->on("/logging/getLogs", [this]() {
@@ -22,44 +25,191 @@ LoggingPage::LoggingPage(WebServer* server): serverPointer(server) {
     serverPointer->on("/logging/getNewLogs", [this]() {
         sendNewLogs();
     });
+
+    serverPointer->on("/logging/getBoots", [this]() {
+        sendBoots();
+    });
 }
 
 void LoggingPage::handler() {
     serveFileFromSpiffs(serverPointer, "/index.html", "text/html");
 }
 
-void LoggingPage::sendLogs() const {
-    String logLevel = serverPointer->arg("level");
-    String macFilter = serverPointer->arg("mac");
-    auto& logs = LogDatabase::getInstance().getLogs();
-    processLogs(logs, logLevel, macFilter);
+void LoggingPage::sendLogs() {
+    if (serverPointer->hasArg("boot") || serverPointer->hasArg("from") || serverPointer->hasArg("to")) {
+        sendStoredLogs();
+        return;
+    }
+
+    LogDatabase::Filter filter;
+    if (!parseFilter(filter)) {
+        serverPointer->send(200, "application/json", "[]");
+        return;
+    }
+    std::vector<LogEntry::Record> logs;
+    const uint32_t nextSeq = LogDatabase::getInstance().getLogsSince(0, filter, logs);
+    legacyCursor = nextSeq;
+    sendSeqHeader(nextSeq);
+    processLogs(logs);
 }
 
-void LoggingPage::sendNewLogs() const {
-    String logLevel = serverPointer->arg("level");
-    String macFilter = serverPointer->arg("mac");
-    auto logs = LogDatabase::getInstance().getNewLogs();
-    processLogs(logs, logLevel, macFilter);
+void LoggingPage::sendNewLogs() {
+    LogDatabase::Filter filter;
+    if (!parseFilter(filter)) {
+        serverPointer->send(200, "application/json", "[]");
+        return;
+    }
+
+    // clients pass the X-Log-Seq value of their previous response, older clients without
+    // it share a single cursor
+    const bool hasCursor = serverPointer->hasArg("since");
+    const uint32_t since = hasCursor
+        ? static_cast<uint32_t>(strtoul(serverPointer->arg("since").c_str(), nullptr, 10))
+        : legacyCursor;
+
+    std::vector<LogEntry::Record> logs;
+    const uint32_t nextSeq = LogDatabase::getInstance().getLogsSince(since, filter, logs);
+    if (!hasCursor) {
+        legacyCursor = nextSeq;
+    }
+    sendSeqHeader(nextSeq);
+    processLogs(logs);
 }
 
-void LoggingPage::processLogs(const std::vector<LogEntry::Entry>& logs, const String& logLevel, const String& macFilter) const {
-    JsonDocument jsonDocument;
-    JsonArray logsJson = jsonDocument.to<JsonArray>();
+void LoggingPage::sendStoredLogs() {
+    LogDatabase::Filter filter;
+    if (!parseFilter(filter)) {
+        serverPointer->send(200, "application/json", "[]");
+        return;
+    }
 
-    for (const auto& log : logs) {
-        const bool matchesLevel = logLevel == "ALL" || logLevel == Utility::logLevelToString(log.level);
-        const bool matchesMac = macFilter.length() == 0 || macFilter == String(log.sourceMac.c_str());
-
-        if (matchesLevel && matchesMac) {
-            JsonObject logJson = logsJson.add<JsonObject>();
-            logJson["level"] = Utility::logLevelToString(log.level);
-            logJson["timestamp"] = log.timestamp;
-            logJson["message"] = log.message;
-            logJson["mac"] = log.sourceMac;
+    LogFlashStore& store = LogFlashStore::getInstance();
+    const uint32_t bootId = serverPointer->hasArg("boot")
+        ? static_cast<uint32_t>(strtoul(serverPointer->arg("boot").c_str(), nullptr, 10))
+        : store.getBootId();
+    const uint32_t fromMs = serverPointer->hasArg("from")
+        ? static_cast<uint32_t>(strtoul(serverPointer->arg("from").c_str(), nullptr, 10))
+        : 0;
+    const uint32_t toMs = serverPointer->hasArg("to")
+        ? static_cast<uint32_t>(strtoul(serverPointer->arg("to").c_str(), nullptr, 10))
+        : UINT32_MAX;
+
+    char timestamp[16];
+    char message[LogDatabase::MAX_TEXT_LENGTH + 1];
+    char mac[18];
+
+    // records are streamed while the segments are read, nothing is collected in memory
+    JsonDocument logJson;
+    ChunkedResponse response(serverPointer, 200, "application/json");
+    response.beginArray();
+
+    store.query(bootId, fromMs, toMs, [&](const uint32_t boot, const LogEntry::Record& log, const char* text) {
+        if ((filter.byLevel && log.level != filter.level)
+            || (filter.byMac && LogEntry::packMac(log.mac) != filter.mac)) {
+            return;
+        }
+        LogFormatter::formatTimestamp(log.timestampMs, timestamp, sizeof(timestamp));
+        LogFormatter::formatMessage(log, text, message, sizeof(message));
+        LogFormatter::formatMac(log.mac, mac, sizeof(mac));
+
+        logJson.clear();
+        logJson["boot"] = boot;
+        logJson["level"] = LogFormatter::levelName(log.level);
+        logJson["timestamp"] = timestamp;
+        logJson["message"] = message;
+        logJson["mac"] = mac;
+        response.addArrayElement(logJson);
+    });
+
+    response.endArray();
+    response.end();
+}
+
+void LoggingPage::sendBoots() {
+    LogFlashStore& store = LogFlashStore::getInstance();
+    const std::vector<LogFlashStore::SegmentInfo> segments = store.getSegments();
+
+    // one entry per boot, segments of a boot are consecutive
+    JsonDocument jsonDocument;
+    JsonArray boots = jsonDocument.to<JsonArray>();
+    for (size_t i = 0; i < segments.size();) {
+        const uint32_t bootId = segments[i].bootId;
+        uint32_t fromMs = UINT32_MAX;
+        uint32_t toMs = 0;
+        uint32_t records = 0;
+        for (; i < segments.size() && segments[i].bootId == bootId; ++i) {
+            if (segments[i].recordCount > 0) {
+                fromMs = std::min(fromMs, segments[i].firstTimestampMs);
+                toMs = std::max(toMs, segments[i].lastTimestampMs);
+                records += segments[i].recordCount;
+            }
+        }
+        if (records == 0) {
+            continue;
         }
+
+        JsonObject boot = boots.add<JsonObject>();
+        boot["boot"] = bootId;
+        boot["from"] = fromMs;
+        boot["to"] = toMs;
+        boot["records"] = records;
+        boot["current"] = bootId == store.getBootId();
     }
 
     String jsonResponse;
     serializeJson(jsonDocument, jsonResponse);
     serverPointer->send(200, "application/json", jsonResponse);
 }
+
+bool LoggingPage::parseFilter(LogDatabase::Filter& filter) const {
+    const String logLevel = serverPointer->arg("level");
+    if (logLevel != "ALL") {
+        filter.byLevel = true;
+        if (!LogFormatter::parseLevel(logLevel.c_str(), filter.level)) {
+            return false;
+        }
+    }
+
+    const String macFilter = serverPointer->arg("mac");
+    if (macFilter.length() > 0) {
+        uint8_t mac[6];
+        filter.byMac = true;
+        if (!LogFormatter::parseMac(macFilter.c_str(), mac)) {
+            return false;
+        }
+        filter.mac = LogEntry::packMac(mac);
+    }
+    return true;
+}
+
+void LoggingPage::sendSeqHeader(const uint32_t nextSeq) const {
+    serverPointer->sendHeader("X-Log-Seq", String(nextSeq));
+}
+
+void LoggingPage::processLogs(const std::vector<LogEntry::Record>& logs) const {
+    // records are only turned into text here, when a client actually asks for them, and
+    // streamed one entry at a time so the response is never held in memory as a whole
+    char timestamp[16];
+    char message[LogDatabase::MAX_TEXT_LENGTH + 1];
+    char mac[18];
+
+    JsonDocument logJson;
+    ChunkedResponse response(serverPointer, 200, "application/json");
+    response.beginArray();
+
+    for (const auto& log : logs) {
+        LogFormatter::formatTimestamp(log.timestampMs, timestamp, sizeof(timestamp));
+        LogFormatter::formatMessage(log, message, sizeof(message));
+        LogFormatter::formatMac(log.mac, mac, sizeof(mac));
+
+        logJson.clear();
+        logJson["level"] = LogFormatter::levelName(log.level);
+        logJson["timestamp"] = timestamp;
+        logJson["message"] = message;
+        logJson["mac"] = mac;
+        response.addArrayElement(logJson);
+    }
+
+    response.endArray();
+    response.end();
+}
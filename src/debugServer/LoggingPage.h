@@ -2,7 +2,11 @@
  * @file LoggingPage.h
  * @author Tim Dietrich, Felix Herrling
  * @brief This component implements the logging page for the webserver.
- * Log entries are read from the logdatabase and sent to the client.
+ * Log entries are read from the logdatabase and sent to the client. Every response carries
+ * an X-Log-Seq header; passing it back as /logging/getNewLogs?since=<seq> returns only
+ * entries logged after the previous response. Logs of the current and earlier boots that were
+ * persisted to flash are returned for /logging/getLogs?boot=<id>&from=<ms>&to=<ms>, the
+ * available boots are listed by /logging/getBoots.
  * @version 1.0
  * @date 2025-03-23
  *
@@ -20,10 +24,15 @@
 class LoggingPage : public PageProvider {
 private:
     WebServer* serverPointer;
+    uint32_t legacyCursor = 0; ///< Cursor for clients that do not pass ?since=
 
-    void sendLogs() const;
-    void sendNewLogs() const;
-    void processLogs(const std::vector<LogEntry::Entry>& logs, const String& logLevel, const String& macFilter) const;
+    void sendLogs();
+    void sendNewLogs();
+    void sendStoredLogs();
+    void sendBoots();
+    void sendSeqHeader(uint32_t nextSeq) const;
+    bool parseFilter(LogDatabase::Filter& filter) const;
+    void processLogs(const std::vector<LogEntry::Record>& logs) const;
 
 public:
     explicit LoggingPage(WebServer* server);
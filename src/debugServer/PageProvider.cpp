@@ -21,7 +21,7 @@ void PageProvider::serveFileFromSpiffs(
 ) {
     // Validate inputs
     if (!server || !filename || !contentType) {
-        Logger::getInstance().logError("Invalid parameters for serveFileFromSpiffs");
+        DEZIBOT_LOG_ERROR("Invalid parameters for serveFileFromSpiffs");
         return;
     }
 
@@ -29,7 +29,7 @@ void PageProvider::serveFileFromSpiffs(
 
     // File open failure
     if (!file) {
-        Logger::getInstance().logError(
+        DEZIBOT_LOG_ERROR(
             std::string("Failed to open file: ")
             + filename
         );
@@ -39,7 +39,7 @@ void PageProvider::serveFileFromSpiffs(
 
     // Directory check
     if (file.isDirectory()) {
-        Logger::getInstance().logError(
+        DEZIBOT_LOG_ERROR(
             std::string("Path is directory: ")
             + filename
         );
@@ -52,7 +52,7 @@ void PageProvider::serveFileFromSpiffs(
     const size_t fileSize = file.size();
 
     // Stream the file
-    Logger::getInstance().logTrace(
+    DEZIBOT_LOG_TRACE(
         std::string("Streaming ")
             + filename
             + " ("
@@ -66,7 +66,7 @@ void PageProvider::serveFileFromSpiffs(
 
     // Post-stream validation, make sure that the streamed size matches the actual size
     if (bytesStreamed != fileSize) {
-        Logger::getInstance().logError(
+        DEZIBOT_LOG_ERROR(
             std::string("Streaming incomplete for ")
             + filename
             + "\nExpected: "
@@ -1,9 +1,35 @@
 #include "SwarmPage.h"
+#include "ChunkedResponse.h"
 #include <Arduino.h>
 #include <ArduinoJson.h>
 #include <shared/SenderMap.h>
 #include <shared/CommandSender.h>
 #include <shared/CommandMessage.h>
+#include <transport/EspNowPeerManager.h>
+#include <vector>
+
+// macs is a comma separated list of at most CMD_GROUP_MAX_MACS, e.g. F4:12:FA:44:65:A8,F4:12:FA:44:65:B0
+static bool parseMacList(const char *text, std::vector<uint64_t> &macs)
+{
+    while (*text != '\0')
+    {
+        const char *end = strchr(text, ',');
+        const size_t length = end != nullptr ? (size_t)(end - text) : strlen(text);
+        char macText[18];
+        uint64_t mac;
+        if (length != 17 || macs.size() == CMD_GROUP_MAX_MACS)
+            return false;
+        memcpy(macText, text, length);
+        macText[length] = '\0';
+        if (!DeviceTable::parseMac(macText, mac))
+            return false;
+        macs.push_back(mac);
+        text += length;
+        if (*text == ',')
+            text++;
+    }
+    return !macs.empty();
+}
 
 SwarmPage::SwarmPage(WebServer *server) : serverPointer(server)
 {
@@ -15,6 +41,10 @@ SwarmPage::SwarmPage(WebServer *server) : serverPointer(server)
                { forwardDevice(); });
     server->on("/command/stop", HTTP_POST, [this]()
                { stopDevice(); });
+    server->on("/command/batch", HTTP_POST, [this]()
+               { sendBatchCommand(); });
+    server->on("/command/peers", HTTP_GET, [this]()
+               { getPeerStats(); });
 }
 
 void SwarmPage::handler()
@@ -24,31 +54,72 @@ void SwarmPage::handler()
 
 void SwarmPage::getSwarmData()
 {
-    JsonDocument jsonDoc;
-    JsonArray arr = jsonDoc.to<JsonArray>();
+    // copy the few fields needed from each slot, then stream; the receive path is never held up
+    struct SwarmEntry
+    {
+        uint64_t mac;
+        uint32_t counter;
+        uint32_t uptime;
+        unsigned long lastSeenMs;
+        uint32_t powerMw;
+        uint32_t received;
+        uint32_t dropped;
+        uint32_t duplicates;
+        uint32_t reordered;
+        uint32_t crcErrors;
+    };
+    std::vector<SwarmEntry> entries;
 
-    auto &senderMap = getSenderMap();
-    SemaphoreHandle_t mutex = getSenderMapMutex();
+    DeviceTable &table = getDeviceTable();
+    const size_t count = table.size();
+    entries.reserve(count);
+    for (size_t slot = 0; slot < count; slot++)
+    {
+        SwarmEntry swarmEntry;
+        swarmEntry.mac = table.macAt(slot);
+        table.read(slot, [&swarmEntry](const SenderInfo &info)
+                   {
+                       swarmEntry.counter = info.msg.counter;
+                       swarmEntry.uptime = info.msg.uptimeMs;
+                       swarmEntry.lastSeenMs = info.lastSeenMs;
+                       swarmEntry.powerMw = info.msg.estimatedPowerMw;
+                       const LinkStats &link = info.link;
+                       const LinkStats &imuLink = info.imuLink;
+                       swarmEntry.received = link.received + imuLink.received;
+                       swarmEntry.dropped = link.dropped + imuLink.dropped;
+                       swarmEntry.duplicates = link.duplicates + imuLink.duplicates;
+                       swarmEntry.reordered = link.reordered + imuLink.reordered;
+                       swarmEntry.crcErrors = link.crcErrors + imuLink.crcErrors;
+                   });
+        entries.push_back(swarmEntry);
+    }
 
-    if (xSemaphoreTake(mutex, pdMS_TO_TICKS(50)) == pdTRUE)
+    JsonDocument obj;
+    ChunkedResponse response(serverPointer, 200, "application/json");
+    response.beginArray();
+
+    unsigned long now = millis();
+    for (auto &entry : entries)
     {
-        unsigned long now = millis();
-        for (auto &entry : senderMap)
-        {
-            JsonObject obj = arr.add<JsonObject>();
-            obj["mac"] = entry.first;
-            obj["counter"] = entry.second.msg.counter;
-            obj["uptime"] = entry.second.msg.uptimeMs;
-            obj["lastSeen"] = now - entry.second.lastSeenMs;
-            obj["online"] = (now - entry.second.lastSeenMs) < 5000;
-            obj["powerMw"] = entry.second.msg.estimatedPowerMw;
-        }
-        xSemaphoreGive(mutex);
+        char mac[18];
+        DeviceTable::formatMac(entry.mac, mac, sizeof(mac));
+        obj.clear();
+        obj["mac"] = mac;
+        obj["counter"] = entry.counter;
+        obj["uptime"] = entry.uptime;
+        obj["lastSeen"] = now - entry.lastSeenMs;
+        obj["online"] = (now - entry.lastSeenMs) < 5000;
+        obj["powerMw"] = entry.powerMw;
+        obj["received"] = entry.received;
+        obj["dropped"] = entry.dropped;
+        obj["duplicates"] = entry.duplicates;
+        obj["reordered"] = entry.reordered;
+        obj["crcErrors"] = entry.crcErrors;
+        response.addArrayElement(obj);
     }
 
-    String response;
-    serializeJson(jsonDoc, response);
-    serverPointer->send(200, "application/json", response);
+    response.endArray();
+    response.end();
 }
 
 void SwarmPage::locateDevice()
@@ -69,11 +140,9 @@ void SwarmPage::locateDevice()
         return;
     }
 
-    bool ok = sendCommandToDevice(macBytes, CMD_LOCATE);
-    if (ok)
-        serverPointer->send(200, "application/json", "{\"status\":\"sent\"}");
-    else
-        serverPointer->send(500, "application/json", "{\"error\":\"send failed\"}");
+    CommandResult result;
+    sendCommandToDevice(macBytes, CMD_LOCATE, result);
+    sendCommandResult(result);
 }
 
 void SwarmPage::forwardDevice()
@@ -104,9 +173,131 @@ void SwarmPage::sendCommand(uint8_t cmd)
         return;
     }
 
-    bool ok = sendCommandToDevice(macBytes, cmd);
+    CommandResult result;
+    sendCommandToDevice(macBytes, cmd, result);
+    sendCommandResult(result);
+}
+
+void SwarmPage::sendCommandResult(const CommandResult &result)
+{
+    JsonDocument doc;
+    if (result.acked)
+    {
+        doc["status"] = "acked";
+        doc["rttUs"] = result.rttUs;
+    }
+    else
+    {
+        doc["error"] = result.attempts > 0 ? "no ack" : "send failed";
+    }
+    doc["attempts"] = result.attempts;
+    doc["totalUs"] = result.totalUs;
+
+    String body;
+    serializeJson(doc, body);
+    // a command the device never confirmed is reported as such, STOP in particular
+    serverPointer->send(result.acked ? 200 : (result.attempts > 0 ? 504 : 500), "application/json", body);
+}
+
+void SwarmPage::sendBatchCommand()
+{
+    static const struct
+    {
+        const char *name;
+        uint8_t command;
+    } commands[] = {{"locate", CMD_LOCATE}, {"forward", CMD_FORWARD}, {"stop", CMD_STOP}};
+
+    const String name = serverPointer->arg("command");
+    int command = -1;
+    for (const auto &entry : commands)
+    {
+        if (strcmp(name.c_str(), entry.name) == 0)
+            command = entry.command;
+    }
+    if (command < 0)
+    {
+        serverPointer->send(400, "application/json", "{\"error\":\"invalid command parameter\"}");
+        return;
+    }
+
+    // without macs or groups the command goes to every sender
+    CommandTarget target;
+    target.type = TARGET_ALL;
+    if (serverPointer->hasArg("macs") && serverPointer->hasArg("groups"))
+    {
+        serverPointer->send(400, "application/json", "{\"error\":\"macs and groups are exclusive\"}");
+        return;
+    }
+    if (serverPointer->hasArg("groups"))
+    {
+        const unsigned long groups = strtoul(serverPointer->arg("groups").c_str(), nullptr, 0);
+        if (groups == 0 || groups > 0xFF)
+        {
+            serverPointer->send(400, "application/json", "{\"error\":\"invalid groups parameter\"}");
+            return;
+        }
+        target.type = TARGET_GROUPS;
+        target.groups = (uint8_t)groups;
+    }
+    if (serverPointer->hasArg("macs"))
+    {
+        target.type = TARGET_MACS;
+        if (!parseMacList(serverPointer->arg("macs").c_str(), target.macs))
+        {
+            serverPointer->send(400, "application/json", "{\"error\":\"invalid macs parameter\"}");
+            return;
+        }
+    }
+
+    GroupCommandResult result;
+    const bool ok = sendCommandToGroup(target, (uint8_t)command, result);
+
+    JsonDocument doc;
     if (ok)
-        serverPointer->send(200, "application/json", "{\"status\":\"sent\"}");
+        doc["status"] = "acked";
     else
-        serverPointer->send(500, "application/json", "{\"error\":\"send failed\"}");
+        doc["error"] = result.acked.empty() ? "no ack" : "partial ack";
+    doc["attempts"] = result.attempts;
+    doc["totalUs"] = result.totalUs;
+    doc["espNowUs"] = result.espNowUs;
+    doc["bleUs"] = result.bleUs;
+    char mac[18];
+    JsonArray acked = doc["acked"].to<JsonArray>();
+    for (uint64_t key : result.acked)
+    {
+        DeviceTable::formatMac(key, mac, sizeof(mac));
+        acked.add(mac);
+    }
+    JsonArray missing = doc["missing"].to<JsonArray>();
+    for (uint64_t key : result.missing)
+    {
+        DeviceTable::formatMac(key, mac, sizeof(mac));
+        missing.add(mac);
+    }
+
+    String body;
+    serializeJson(doc, body);
+    serverPointer->send(ok ? 200 : 504, "application/json", body);
+}
+
+void SwarmPage::getPeerStats()
+{
+    PeerStats stats;
+    if (!getCommandPeerStats(stats))
+    {
+        serverPointer->send(404, "application/json", "{\"error\":\"no ESP-NOW command path\"}");
+        return;
+    }
+
+    JsonDocument doc;
+    doc["peers"] = stats.peers;
+    doc["slots"] = ESPNOW_PEER_SLOTS;
+    doc["hits"] = stats.hits;
+    doc["misses"] = stats.misses;
+    doc["evictions"] = stats.evictions;
+    doc["failures"] = stats.failures;
+
+    String body;
+    serializeJson(doc, body);
+    serverPointer->send(200, "application/json", body);
 }
@@ -6,6 +6,7 @@
 #include <map>
 
 struct SenderInfo;
+struct CommandResult;
 
 class SwarmPage : public PageProvider {
 private:
@@ -14,6 +15,9 @@ private:
     void forwardDevice();
     void stopDevice();
     void sendCommand(uint8_t cmd);
+    void sendCommandResult(const CommandResult& result);
+    void sendBatchCommand();
+    void getPeerStats();
 public:
     explicit SwarmPage(WebServer* server);
     void handler() override;
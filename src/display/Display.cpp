@@ -35,7 +35,7 @@ void Display::begin(void){
     sendDisplayCMD(activateDisplay);
     this->clear();
 
-    Logger::getInstance().logTrace("Successfully started display module");
+    DEZIBOT_LOG_TRACE("Successfully started display module");
 
     return;
 };
@@ -67,7 +67,7 @@ void Display::clear(void){
     this -> charsOnCurrLine = 0;
     this -> currLine = 0;
 
-    Logger::getInstance().logInfo("Cleared display");
+    DEZIBOT_LOG_INFO("Cleared display");
 
     return;
 };
@@ -88,7 +88,7 @@ void Display::updateLine(uint charAmount)
 void Display::print(char *value){
     char *nextchar;
 	/* write data to the buffer */
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Printing to display with text: "
             + std::string(value)
         );
@@ -141,7 +141,7 @@ void Display::print(String value){
 
     this->print(msgBuffer);
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Printed to display with value: "
         + std::string(value.c_str())
     );
@@ -154,7 +154,7 @@ void Display::println(String value){
 
     this->println(msgBuffer);
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Printed line to display with value: "
         + std::string(value.c_str())
     );
@@ -165,7 +165,7 @@ void Display::print(int value){
 
     this->print(itoa(value, cstr, 10));
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Printed integer to display with value: "
         + std::to_string(value)
     );
@@ -176,7 +176,7 @@ void Display::println(int value){
 
     this->println(itoa(value, cstr, 10));
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Printed integer line to display with value: "
         + std::to_string(value)
     );
@@ -186,7 +186,7 @@ void Display::println(char *value){
     this -> print(value);
     this -> print("\n");
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Printed character to display with value: "
         + std::string(value)
     );
@@ -202,7 +202,7 @@ void Display::flipOrientation(void){
     }
     this->orientationFlipped = !this->orientationFlipped;
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Flipped display orientation"
     );
 };
@@ -215,7 +215,7 @@ void Display::invertColor(void){
     }
     this->colorInverted = !this->colorInverted;
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Inverted display color"
     );
 };
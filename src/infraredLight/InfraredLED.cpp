@@ -36,7 +36,7 @@ void InfraredLED::begin(void){
 void InfraredLED::turnOn(void){
     InfraredLED::setState(true);
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Turned on InfraredLED"
     );
 };
@@ -44,7 +44,7 @@ void InfraredLED::turnOn(void){
 void InfraredLED::turnOff(void){
     InfraredLED::setState(false);
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Turned off InfraredLED"
     );
 };
@@ -58,7 +58,7 @@ void InfraredLED::setState(bool state){
     }
     ledc_update_duty(pwmSpeedMode,channel);
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Set state of InfraredLED to state: "
         + state
     );
@@ -69,7 +69,7 @@ void InfraredLED::sendFrequency(uint16_t frequency){
     ledc_set_duty(pwmSpeedMode,channel,512);
     ledc_update_duty(pwmSpeedMode,channel);
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
     "Sending Frequency to InfraredLED with value: "
         + std::to_string(frequency)
     );
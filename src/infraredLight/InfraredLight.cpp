@@ -6,5 +6,5 @@ void InfraredLight::begin(void){
     bottom.begin();
     front.begin();
 
-    Logger::getInstance().logTrace("Successfully started InfraredLight module");
+    DEZIBOT_LOG_TRACE("Successfully started InfraredLight module");
 }
@@ -6,7 +6,7 @@ void LightDetection::begin(void){
     LightDetection::beginInfrared();
     LightDetection::beginDaylight();
 
-    Logger::getInstance().logTrace("Successfully started LightDetection module");
+    DEZIBOT_LOG_TRACE("Successfully started LightDetection module");
 };
 
 uint16_t LightDetection::getValue(photoTransistors sensor){
@@ -29,11 +29,7 @@ uint16_t LightDetection::getValue(photoTransistors sensor){
             break;
     }
 
-    Logger::getInstance().logInfo(
-        "Getting LightDetection Value for sensor: "
-        + std::to_string(sensor)
-        + "with value: " + std::to_string(value)
-    );
+    DEZIBOT_LOG_FORMAT(LogEntry::INFO, LogEntry::FMT_LIGHT_VALUE, nullptr, sensor, value);
 
     return value;
 };
@@ -62,12 +58,7 @@ photoTransistors LightDetection::getBrightest(ptType type){
             }
         }
     }
-    Logger::getInstance().logInfo(
-        "Getting brightest sensor for type: "
-        + std::to_string(type)
-        + " with result: "
-        + std::to_string(maxReading)
-    );
+    DEZIBOT_LOG_FORMAT(LogEntry::INFO, LogEntry::FMT_LIGHT_BRIGHTEST, nullptr, type, maxReading);
 
     return maxSensor;
 };
@@ -81,7 +72,7 @@ uint32_t LightDetection::getAverageValue(photoTransistors sensor, uint32_t measu
         xTaskDelayUntil(&xLastWakeTime,frequency);
     }
 
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Getting average value for sensor: "
         + std::to_string(sensor)
         + "with measurements: "
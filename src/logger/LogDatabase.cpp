@@ -3,6 +3,78 @@
 //
 
 #include "LogDatabase.h"
+#include "LogFlashStore.h"
+#include "Logger.h"
+#include <algorithm>
+#include <pthread.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+namespace {
+    // staging buffer claimed by the calling task, see stageForCurrentTask()
+    thread_local LogStage* currentTaskStage = nullptr;
+
+    // its destructor runs when a task that claimed a stage is deleted; ESP-IDF calls pthread
+    // key destructors from the FreeRTOS TLS deletion callback, also for tasks not started as pthreads
+    pthread_key_t stageOwnerKey;
+    pthread_once_t stageOwnerKeyOnce = PTHREAD_ONCE_INIT;
+
+    constexpr bool isPowerOfTwo(const size_t value) {
+        return value > 0 && (value & (value - 1)) == 0;
+    }
+
+    constexpr bool isPoolSize(const size_t records) {
+        return records >= 16 && isPowerOfTwo(records);
+    }
+
+    static_assert(isPoolSize(DEZIBOT_LOG_POOL_INFO) && isPoolSize(DEZIBOT_LOG_POOL_WARNING)
+                  && isPoolSize(DEZIBOT_LOG_POOL_ERROR) && isPoolSize(DEZIBOT_LOG_POOL_DEBUG)
+                  && isPoolSize(DEZIBOT_LOG_POOL_TRACE),
+                  "log pool sizes must be powers of two of at least 16 records");
+    static_assert(isPowerOfTwo(DEZIBOT_LOG_TEXT_INFO) && isPowerOfTwo(DEZIBOT_LOG_TEXT_WARNING)
+                  && isPowerOfTwo(DEZIBOT_LOG_TEXT_ERROR) && isPowerOfTwo(DEZIBOT_LOG_TEXT_DEBUG)
+                  && isPowerOfTwo(DEZIBOT_LOG_TEXT_TRACE),
+                  "log text bytes per record must be powers of two");
+
+    constexpr bool fitsLongestMessage(const size_t records, const size_t textPerRecord) {
+        return records * textPerRecord >= LogDatabase::MAX_TEXT_LENGTH;
+    }
+
+    static_assert(fitsLongestMessage(DEZIBOT_LOG_POOL_INFO, DEZIBOT_LOG_TEXT_INFO)
+                  && fitsLongestMessage(DEZIBOT_LOG_POOL_WARNING, DEZIBOT_LOG_TEXT_WARNING)
+                  && fitsLongestMessage(DEZIBOT_LOG_POOL_ERROR, DEZIBOT_LOG_TEXT_ERROR)
+                  && fitsLongestMessage(DEZIBOT_LOG_POOL_DEBUG, DEZIBOT_LOG_TEXT_DEBUG)
+                  && fitsLongestMessage(DEZIBOT_LOG_POOL_TRACE, DEZIBOT_LOG_TEXT_TRACE),
+                  "the text ring of every pool must fit a message of MAX_TEXT_LENGTH");
+}
+
+LogDatabase::LogDatabase() {
+    // indexed by LogEntry::Level
+    const uint32_t capacities[LogEntry::LEVEL_COUNT] = {
+        DEZIBOT_LOG_POOL_INFO, DEZIBOT_LOG_POOL_WARNING, DEZIBOT_LOG_POOL_ERROR,
+        DEZIBOT_LOG_POOL_DEBUG, DEZIBOT_LOG_POOL_TRACE
+    };
+    const uint32_t textPerRecord[LogEntry::LEVEL_COUNT] = {
+        DEZIBOT_LOG_TEXT_INFO, DEZIBOT_LOG_TEXT_WARNING, DEZIBOT_LOG_TEXT_ERROR,
+        DEZIBOT_LOG_TEXT_DEBUG, DEZIBOT_LOG_TEXT_TRACE
+    };
+
+    size_t offset = 0;
+    size_t textOffset = 0;
+    for (uint8_t level = 0; level < LogEntry::LEVEL_COUNT; ++level) {
+        const size_t textCapacity = capacities[level] * textPerRecord[level];
+        Pool& pool = pools_[level];
+        pool.entries = &entries_[offset];
+        pool.text = &text_[textOffset];
+        pool.mask = capacities[level] - 1;
+        pool.textMask = textCapacity - 1;
+        pool.head = 0;
+        pool.textHead = 0;
+        pool.chainsCompleteFrom = 0;
+        offset += capacities[level];
+        textOffset += textCapacity;
+    }
+}
 
 // Get the singleton instance of LogDatabase
 LogDatabase& LogDatabase::getInstance() {
@@ -10,48 +82,356 @@ LogDatabase& LogDatabase::getInstance() {
     return instance;
 }
 
-// Add a log entry to the database
-void LogDatabase::addLog(const LogEntry::Entry& entry) {
+// Queue a log record in the staging buffer of the calling task
+void LogDatabase::addLog(const LogEntry::Record& record) {
+    stage(record, nullptr);
+}
+
+void LogDatabase::addLog(LogEntry::Record record, const char* text, size_t length) {
+    if (length > MAX_TEXT_LENGTH) {
+        length = MAX_TEXT_LENGTH;
+    }
+    record.formatId = LogEntry::FMT_TEXT;
+    record.args[0] = 0;
+    record.args[1] = static_cast<uint32_t>(length);
+    stage(record, text);
+}
+
+LogStage* LogDatabase::stageForCurrentTask() {
+    if (currentTaskStage) {
+        return currentTaskStage;
+    }
+    pthread_once(&stageOwnerKeyOnce, [] { pthread_key_create(&stageOwnerKey, releaseStage); });
+    for (auto& taskStage : taskStages_) {
+        uint8_t expected = STAGE_FREE;
+        if (taskStage.state.compare_exchange_strong(expected, STAGE_OWNED, std::memory_order_acq_rel)) {
+            pthread_setspecific(stageOwnerKey, &taskStage);
+            currentTaskStage = &taskStage.stage;
+            return currentTaskStage;
+        }
+    }
+    return nullptr;
+}
+
+void LogDatabase::releaseStage(void* taskStage) {
+    // records still staged are drained before the stage is claimed again
+    static_cast<TaskStage*>(taskStage)->state.store(STAGE_ORPHANED, std::memory_order_release);
+}
+
+void LogDatabase::stage(const LogEntry::Record& record, const char* text) {
+    LogStage* taskStage = stageForCurrentTask();
+    if (taskStage) {
+        taskStage->push(record, text);
+        return;
+    }
+    // more logging tasks than stages, these few share one stage
+    std::lock_guard<std::mutex> lock(sharedStageMutex_);
+    sharedStage_.push(record, text);
+}
+
+void LogDatabase::drain() {
     std::lock_guard<std::mutex> lock(mutex_);
-    logEntries_.emplace_back(entry);
+    drainLocked();
+}
+
+void LogDatabase::drainLocked() {
+    LogStage* stages[TASK_STAGE_COUNT + 1];
+    size_t stageCount = 0;
+    for (auto& taskStage : taskStages_) {
+        if (taskStage.state.load(std::memory_order_acquire) != STAGE_FREE) {
+            stages[stageCount++] = &taskStage.stage;
+        }
+    }
+    stages[stageCount++] = &sharedStage_;
+
+    uint32_t dropped = 0;
+    LogEntry::Record heads[TASK_STAGE_COUNT + 1];
+    bool hasHead[TASK_STAGE_COUNT + 1];
+    for (size_t i = 0; i < stageCount; ++i) {
+        dropped += stages[i]->takeDropped();
+        hasHead[i] = stages[i]->peek(heads[i]);
+    }
+
+    // k-way merge by timestamp, every stage is already ordered on its own.
+    // Bounded so producers that keep logging cannot stall readers.
+    char text[MAX_TEXT_LENGTH];
+    uint32_t lastTimestampMs = 0;
+    for (size_t merged = 0; merged < LOG_CAPACITY; ++merged) {
+        size_t next = stageCount;
+        for (size_t i = 0; i < stageCount; ++i) {
+            if (hasHead[i] && (next == stageCount || heads[i].timestampMs < heads[next].timestampMs)) {
+                next = i;
+            }
+        }
+        if (next == stageCount) {
+            break;
+        }
+
+        LogEntry::Record record;
+        stages[next]->pop(record, text);
+        append(record, text);
+        lastTimestampMs = record.timestampMs;
+        hasHead[next] = stages[next]->peek(heads[next]);
+    }
+
+    // stages of deleted tasks are free again once they are empty
+    LogEntry::Record pending;
+    for (auto& taskStage : taskStages_) {
+        if (taskStage.state.load(std::memory_order_acquire) == STAGE_ORPHANED && !taskStage.stage.peek(pending)) {
+            taskStage.state.store(STAGE_FREE, std::memory_order_release);
+        }
+    }
 
-    if (logEntries_.size() > MAX_LOG_ENTRIES) {
-        size_t excess = logEntries_.size() - MAX_LOG_ENTRIES;
-        logEntries_.erase(logEntries_.begin(),
-                          logEntries_.begin() + static_cast<std::ptrdiff_t>(excess));
-        if (lastSentIndex_ > excess)
-            lastSentIndex_ -= excess;
-        else
-            lastSentIndex_ = 0;
+    if (dropped > 0) {
+        LogEntry::Record record = {};
+        record.timestampMs = lastTimestampMs;
+        record.level = LogEntry::WARNING;
+        record.formatId = LogEntry::FMT_LOGS_DROPPED;
+        record.args[0] = dropped;
+        append(record, nullptr);
     }
 }
 
-// Retrieve all log entries
-const std::vector<LogEntry::Entry>& LogDatabase::getLogs() {
+void LogDatabase::append(LogEntry::Record record, const char* text) {
+    LogFlashStore* store = flashStore_.load(std::memory_order_acquire);
+    if (store) {
+        store->append(record, text);
+    }
+
+    const uint8_t level = record.level % LogEntry::LEVEL_COUNT;
+    Pool& pool = pools_[level];
+    if (record.formatId == LogEntry::FMT_TEXT) {
+        const size_t length = record.args[1];
+        record.args[0] = pool.textHead;
+
+        // copy in at most two parts when the text wraps around the end of the ring
+        const size_t start = pool.textHead & pool.textMask;
+        const size_t firstPart = std::min<size_t>(length, pool.textMask + 1 - start);
+        memcpy(&pool.text[start], text, firstPart);
+        memcpy(&pool.text[0], text + firstPart, length - firstPart);
+        pool.textHead += static_cast<uint32_t>(length);
+    }
+
+    // link the record into the index chain of its device
+    const uint32_t position = pool.head;
+    Entry& entry = pool.entries[position & pool.mask];
+    DeviceHead& device = deviceHead(LogEntry::packMac(record.mac));
+    entry.prevSameMac = device.newest[level];
+    device.newest[level] = position;
+    device.newestSeq = nextSeq_;
+
+    entry.record = record;
+    entry.seq = nextSeq_;
+    ++pool.head;
+    ++nextSeq_;
+}
+
+LogDatabase::DeviceHead& LogDatabase::deviceHead(const uint64_t mac) {
+    DeviceHead* victim = nullptr;
+    for (auto& head : deviceHeads_) {
+        if (!head.used) {
+            if (!victim || victim->used) {
+                victim = &head;
+            }
+            continue;
+        }
+        if (head.mac == mac) {
+            return head;
+        }
+        if (!victim || (victim->used && head.newestSeq < victim->newestSeq)) {
+            victim = &head;
+        }
+    }
+
+    for (uint8_t level = 0; level < LogEntry::LEVEL_COUNT; ++level) {
+        Pool& pool = pools_[level];
+        const uint32_t newest = victim->newest[level];
+        if (victim->used && newest != NO_POS && newest >= pool.oldest()) {
+            // the recycled device still has records in the pool that no chain reaches anymore
+            pool.chainsCompleteFrom = std::max(pool.chainsCompleteFrom, newest + 1);
+        }
+        victim->newest[level] = NO_POS;
+    }
+    victim->used = true;
+    victim->mac = mac;
+    return *victim;
+}
+
+void LogDatabase::startDrainTask() {
     std::lock_guard<std::mutex> lock(mutex_);
-    // Mark all logs as "sent"
-    lastSentIndex_ = logEntries_.size();
-    return logEntries_;
+    if (drainTaskStarted_) {
+        return;
+    }
+    drainTaskStarted_ = xTaskCreate(drainTask, "log_drain", 4096, this, 1, nullptr) == pdPASS;
+}
+
+void LogDatabase::setFlashStore(LogFlashStore* store) {
+    flashStore_.store(store, std::memory_order_release);
 }
 
-std::vector<LogEntry::Entry> LogDatabase::getNewLogs() {
+void LogDatabase::drainTask(void* parameter) {
+    auto* database = static_cast<LogDatabase*>(parameter);
+    uint32_t sinceFlushMs = 0;
+    while (true) {
+        // call sites that went quiet still owe their repeat counts, checked once a second
+        sinceFlushMs += DRAIN_INTERVAL_MS;
+        if (sinceFlushMs >= SITE_FLUSH_INTERVAL_MS) {
+            sinceFlushMs = 0;
+            Logger::getInstance().flushSites();
+        }
+        database->drain();
+        LogFlashStore* store = database->flashStore_.load(std::memory_order_acquire);
+        if (store) {
+            store->writePending();
+        }
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_INTERVAL_MS));
+    }
+}
+
+uint32_t LogDatabase::getLogsSince(uint32_t sinceSeq, std::vector<LogEntry::Record>& out) {
     std::lock_guard<std::mutex> lock(mutex_);
-    const size_t currentSize = logEntries_.size();
+    drainLocked();
+    if (sinceSeq > nextSeq_) {
+        // cursor of an earlier boot
+        sinceSeq = 0;
+    }
 
-    // no new entries
-    if (lastSentIndex_ >= currentSize) {
-        return {};
+    uint32_t positions[LogEntry::LEVEL_COUNT];
+    size_t count = 0;
+    for (uint8_t level = 0; level < LogEntry::LEVEL_COUNT; ++level) {
+        positions[level] = firstPositionSince(pools_[level], sinceSeq);
+        count += pools_[level].head - positions[level];
     }
+    out.reserve(out.size() + count);
 
-    // Safe conversion with static_cast
-    const auto diffTypeIndex = static_cast<std::vector<LogEntry::Entry>::difference_type>(lastSentIndex_);
+    // k-way merge of the pools by sequence number
+    while (true) {
+        const Entry* next = nullptr;
+        uint8_t nextLevel = 0;
+        for (uint8_t level = 0; level < LogEntry::LEVEL_COUNT; ++level) {
+            const Pool& pool = pools_[level];
+            if (positions[level] == pool.head) {
+                continue;
+            }
+            const Entry& entry = pool.entries[positions[level] & pool.mask];
+            if (!next || entry.seq < next->seq) {
+                next = &entry;
+                nextLevel = level;
+            }
+        }
+        if (!next) {
+            break;
+        }
+        out.push_back(next->record);
+        ++positions[nextLevel];
+    }
+    return nextSeq_;
+}
 
-    std::vector<LogEntry::Entry> newEntries(
-        // starts from 0 + the last sent index
-        logEntries_.begin() + diffTypeIndex,
-        logEntries_.end()
-    );
+uint32_t LogDatabase::getLogsSince(uint32_t sinceSeq, const Filter& filter,
+                                   std::vector<LogEntry::Record>& out) {
+    if (!filter.byMac && !filter.byLevel) {
+        return getLogsSince(sinceSeq, out);
+    }
 
-    lastSentIndex_ = currentSize;
-    return newEntries;
-}
\ No newline at end of file
+    std::lock_guard<std::mutex> lock(mutex_);
+    drainLocked();
+    if (sinceSeq > nextSeq_) {
+        sinceSeq = 0;
+    }
+
+    if (!filter.byMac) {
+        // a single pool is already in sequence order
+        const Pool& pool = pools_[filter.level % LogEntry::LEVEL_COUNT];
+        const uint32_t from = firstPositionSince(pool, sinceSeq);
+        out.reserve(out.size() + (pool.head - from));
+        for (uint32_t position = from; position != pool.head; ++position) {
+            out.push_back(pool.entries[position & pool.mask].record);
+        }
+        return nextSeq_;
+    }
+
+    const DeviceHead* device = nullptr;
+    for (const auto& head : deviceHeads_) {
+        if (head.used && head.mac == filter.mac) {
+            device = &head;
+            break;
+        }
+    }
+
+    std::vector<const Entry*> matches;
+    for (uint8_t level = 0; level < LogEntry::LEVEL_COUNT; ++level) {
+        if (filter.byLevel && level != filter.level) {
+            continue;
+        }
+        const Pool& pool = pools_[level];
+        const uint32_t from = firstPositionSince(pool, sinceSeq);
+        const uint32_t chainFrom = std::max(from, pool.chainsCompleteFrom);
+
+        uint32_t position = device ? device->newest[level] : NO_POS;
+        while (position != NO_POS && position >= chainFrom && position < pool.head) {
+            const Entry& entry = pool.entries[position & pool.mask];
+            matches.push_back(&entry);
+            position = entry.prevSameMac;
+        }
+
+        // records older than a recycled device head are not linked, scan that range instead
+        for (position = from; position < chainFrom && position < pool.head; ++position) {
+            const Entry& entry = pool.entries[position & pool.mask];
+            if (LogEntry::packMac(entry.record.mac) == filter.mac) {
+                matches.push_back(&entry);
+            }
+        }
+    }
+
+    std::sort(matches.begin(), matches.end(), [](const Entry* a, const Entry* b) {
+        return a->seq < b->seq;
+    });
+    out.reserve(out.size() + matches.size());
+    for (const Entry* entry : matches) {
+        out.push_back(entry->record);
+    }
+    return nextSeq_;
+}
+
+bool LogDatabase::readText(const LogEntry::Record& record, char* out, const size_t capacity) {
+    if (capacity == 0) {
+        return false;
+    }
+    out[0] = '\0';
+    if (record.formatId != LogEntry::FMT_TEXT) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const Pool& pool = pools_[record.level % LogEntry::LEVEL_COUNT];
+    const uint32_t position = record.args[0];
+    const size_t length = std::min<size_t>(record.args[1], capacity - 1);
+
+    // the text has been overwritten once the writer moved more than a full ring past it
+    if (pool.textHead - position > pool.textMask + 1) {
+        return false;
+    }
+
+    const size_t start = position & pool.textMask;
+    const size_t firstPart = std::min<size_t>(length, pool.textMask + 1 - start);
+    memcpy(out, &pool.text[start], firstPart);
+    memcpy(out + firstPart, &pool.text[0], length - firstPart);
+    out[length] = '\0';
+    return true;
+}
+
+uint32_t LogDatabase::firstPositionSince(const Pool& pool, const uint32_t sinceSeq) {
+    // sequence numbers increase with the position, binary search the retained range
+    uint32_t low = pool.oldest();
+    uint32_t high = pool.head;
+    while (low < high) {
+        const uint32_t middle = low + (high - low) / 2;
+        if (pool.entries[middle & pool.mask].seq < sinceSeq) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
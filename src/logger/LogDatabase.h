@@ -1,10 +1,13 @@
 /**
 * @file LogDatabase.h
  * @author Tim Dietrich, Felix Herrling
- * @brief The log database class saves all logs in a vector which can then be accessed
- * to read out all existing/new logs. It should not be directly accessed, as logs should
- * be written via the logger class.
- * @version 1.0
+ * @brief The log database class saves all logs as binary records in fixed-size rings, one
+ * retention pool per level, which can then be accessed to read out all existing/new logs. A
+ * chatty level only overwrites its own pool, so rare errors are kept much longer than routine
+ * info messages. Free-form message text is kept in a separate character ring per pool.
+ * Loggers write into per-task staging buffers without locking; a single drain step merges them
+ * into the pools. It should not be directly accessed, as logs should be written via the logger class.
+ * @version 1.3
  * @date 2025-03-30
  *
  * @copyright Copyright (c) 2025
@@ -15,11 +18,71 @@
 #define LOGDATABASE_H
 
 #include "LogEntry.h"
+#include "LogStage.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
 #include <mutex>
 
+/**
+ * @brief Records kept per level, e.g. -DDEZIBOT_LOG_POOL_INFO=128. Each has to be a power of two
+ * of at least 16.
+ */
+#ifndef DEZIBOT_LOG_POOL_INFO
+#define DEZIBOT_LOG_POOL_INFO 256
+#endif
+#ifndef DEZIBOT_LOG_POOL_WARNING
+#define DEZIBOT_LOG_POOL_WARNING 64
+#endif
+#ifndef DEZIBOT_LOG_POOL_ERROR
+#define DEZIBOT_LOG_POOL_ERROR 64
+#endif
+#ifndef DEZIBOT_LOG_POOL_DEBUG
+#define DEZIBOT_LOG_POOL_DEBUG 64
+#endif
+#ifndef DEZIBOT_LOG_POOL_TRACE
+#define DEZIBOT_LOG_POOL_TRACE 64
+#endif
+
+/**
+ * @brief Text bytes per record slot of a level, e.g. -DDEZIBOT_LOG_TEXT_ERROR=128. Each has to be
+ * a power of two. Errors are mostly free-form text and rare, so their pool gets more room per
+ * record than the formatted routine levels; a pool always fits one message of
+ * LogDatabase::MAX_TEXT_LENGTH. The defaults take 8 KB of text space, as much as the single
+ * ring before the pools.
+ */
+#ifndef DEZIBOT_LOG_TEXT_INFO
+#define DEZIBOT_LOG_TEXT_INFO 8
+#endif
+#ifndef DEZIBOT_LOG_TEXT_WARNING
+#define DEZIBOT_LOG_TEXT_WARNING 16
+#endif
+#ifndef DEZIBOT_LOG_TEXT_ERROR
+#define DEZIBOT_LOG_TEXT_ERROR 64
+#endif
+#ifndef DEZIBOT_LOG_TEXT_DEBUG
+#define DEZIBOT_LOG_TEXT_DEBUG 8
+#endif
+#ifndef DEZIBOT_LOG_TEXT_TRACE
+#define DEZIBOT_LOG_TEXT_TRACE 8
+#endif
+
+class LogFlashStore;
+
 class LogDatabase {
 public:
+    /**
+     * @brief Restricts a query to one source device and/or one level.
+     */
+    struct Filter {
+        bool byMac = false;
+        uint64_t mac = 0; ///< see LogEntry::packMac()
+        bool byLevel = false;
+        LogEntry::Level level = LogEntry::INFO;
+    };
+
     /**
      * @brief Returns a reference to the instance of the LogDatabase, used to call functions
      * @return LogDatabase
@@ -27,33 +90,83 @@ public:
     static LogDatabase& getInstance();
 
     /**
-     * @brief Adds a log to the vector stored in the instance
-     * @param entry a log entry created by the logger class.
+     * @brief Queues a log record in the staging buffer of the calling task.
+     * @details Does not lock. The record becomes visible to readers after the next drain()
+     * and is then assigned the next sequence number.
+     * @param record a log record created by the logger class.
+     * @return void
+     */
+    void addLog(const LogEntry::Record& record);
+
+    /**
+     * @brief Queues a free-form text record in the staging buffer of the calling task.
+     * @param record a log record created by the logger class, args are overwritten.
+     * @param text message text, does not need to be null terminated.
+     * @param length number of characters, longer messages are truncated to MAX_TEXT_LENGTH.
+     * @return void
+     */
+    void addLog(LogEntry::Record record, const char* text, size_t length);
+
+    /**
+     * @brief Moves all staged records into the ring, merged in timestamp order.
+     * @note Runs periodically in its own task (see startDrainTask()) and before every read.
      * @return void
      */
-    void addLog(const LogEntry::Entry& entry);
+    void drain();
 
     /**
-     * @brief Retrieves all log entries stored in the database.
-     * @note This marks all logs as "sent" by updating the lastSentIndex_ to the current size.
-     * @return const std::vector<LogEntry::Entry>& A reference to the vector containing all log entries.
+     * @brief Starts the background task that periodically calls drain().
+     * @note Called by Logger::startTimer(), calling it again has no effect.
+     * @return void
+     */
+    void startDrainTask();
+
+    /**
+     * @brief Additionally persists every drained record in store, nullptr to stop.
+     * @details Records are handed over while draining, the flash writes themselves happen
+     * in the drain task.
+     * @return void
+     */
+    void setFlashStore(LogFlashStore* store);
+
+    /**
+     * @brief Copies all retained records with a sequence number >= sinceSeq into out.
+     * @details Records of all levels are merged in sequence order. Records that were already
+     * overwritten are skipped, so a slow reader simply resumes at the oldest retained record. Readers keep their own cursor (the returned
+     * high-water mark), the database holds no per-reader state.
+     * @param sinceSeq First sequence number the caller has not seen yet.
+     * @param out Vector the records are appended to.
+     * @return uint32_t The sequence number the next record will get (the new high-water mark).
+     */
+    uint32_t getLogsSince(uint32_t sinceSeq, std::vector<LogEntry::Record>& out);
+
+    /**
+     * @brief Like getLogsSince(), but only returns records matching filter.
+     * @details A level filter reads only the pool of that level, a device filter follows the
+     * per-device index chains, so they only touch matching records instead of scanning everything.
+     * @param sinceSeq First sequence number the caller has not seen yet.
+     * @param filter Device and/or level to return.
+     * @param out Vector the records are appended to, oldest first.
+     * @return uint32_t The sequence number the next record will get (the new high-water mark).
      */
-    const std::vector<LogEntry::Entry>& getLogs();
+    uint32_t getLogsSince(uint32_t sinceSeq, const Filter& filter, std::vector<LogEntry::Record>& out);
 
     /**
-     * @brief Retrieves only new log entries that haven't been sent before.
-     * @details This function returns all log entries added since the last call to either
-     * getLogs() or getNewLogs(). It updates the lastSentIndex_ to the current size after retrieval.
-     * @return std::vector<LogEntry::Entry> A vector containing only the new log entries.
+     * @brief Copies the text of a FMT_TEXT record into out and null terminates it.
+     * @param record a record returned by one of the getters.
+     * @param out destination buffer.
+     * @param capacity size of out in bytes.
+     * @return false if the text has already been overwritten by newer messages.
      */
-    std::vector<LogEntry::Entry> getNewLogs();
+    bool readText(const LogEntry::Record& record, char* out, size_t capacity);
+
+    static constexpr size_t MAX_TEXT_LENGTH = 192; ///< Longer messages are truncated
 
 private:
     /**
-     * @brief Private constructor to enforce singleton pattern.
-     * Initializes lastSentIndex_ to 0.
+     * @brief Private constructor to enforce singleton pattern, divides the storage into pools.
      */
-    LogDatabase() : lastSentIndex_(0) {};
+    LogDatabase();
 
     /**
      * @brief Default destructor.
@@ -64,10 +177,126 @@ private:
     LogDatabase(const LogDatabase&) = delete;
     LogDatabase& operator=(const LogDatabase&) = delete;
 
-    static constexpr size_t MAX_LOG_ENTRIES = 500;
-    std::vector<LogEntry::Entry> logEntries_; ///< Vector storing all log entries
-    std::mutex mutex_; ///< Mutex for thread-safe operations
-    size_t lastSentIndex_; ///< Index tracking the last sent log entry
+    /**
+     * @brief Lifecycle of a task stage. A stage whose task was deleted is drained once more
+     * and then handed to the next task that logs.
+     */
+    enum StageState : uint8_t {
+        STAGE_FREE,
+        STAGE_OWNED,
+        STAGE_ORPHANED,
+    };
+
+    /**
+     * @brief A staging buffer that is owned by one task once claimed.
+     */
+    struct TaskStage {
+        std::atomic<uint8_t> state{STAGE_FREE};
+        LogStage stage;
+    };
+
+    /**
+     * @brief A stored record with its global sequence number.
+     */
+    struct Entry {
+        LogEntry::Record record;
+        uint32_t seq;
+        uint32_t prevSameMac; ///< Pool position of the previous record of the same device, or NO_POS
+    };
+
+    /**
+     * @brief Retention pool of one level, a ring of entries plus a ring of text.
+     * @details Positions count every record ever appended to the pool, the record at position
+     * n lives in entries[n & mask]. Sequence numbers increase with the position.
+     */
+    struct Pool {
+        Entry* entries;
+        char* text;
+        uint32_t mask;
+        uint32_t textMask;
+        uint32_t head;               ///< Position of the next record
+        uint32_t textHead;           ///< Total number of text bytes ever written
+        uint32_t chainsCompleteFrom; ///< Device chains miss older records of recycled heads
+
+        uint32_t oldest() const { return head > mask ? head - mask - 1 : 0; }
+    };
+
+    /**
+     * @brief Start of the index chains of one device, one chain per pool.
+     */
+    struct DeviceHead {
+        bool used;
+        uint64_t mac;
+        uint32_t newestSeq;                        ///< Sequence of the newest record, picks the head to recycle
+        uint32_t newest[LogEntry::LEVEL_COUNT];    ///< Newest position per pool, or NO_POS
+    };
+
+    /**
+     * @brief Returns the stage of the calling task, claiming a free one on first use.
+     * @return LogStage* nullptr if all stages are taken.
+     */
+    LogStage* stageForCurrentTask();
+
+    /**
+     * @brief Called when a task that owns a stage is deleted, see stageForCurrentTask().
+     * @param taskStage the TaskStage of the task.
+     */
+    static void releaseStage(void* taskStage);
+
+    /**
+     * @brief Stages a record, falling back to the shared stage if the task has none.
+     */
+    void stage(const LogEntry::Record& record, const char* text);
+
+    /**
+     * @brief drain() without locking. Caller must hold mutex_.
+     */
+    void drainLocked();
+
+    /**
+     * @brief Appends a record to the pool of its level, storing its text in the pool's text ring.
+     * Caller must hold mutex_.
+     */
+    void append(LogEntry::Record record, const char* text);
+
+    /**
+     * @brief First retained position of a pool whose sequence number is >= sinceSeq. Caller must hold mutex_.
+     */
+    static uint32_t firstPositionSince(const Pool& pool, uint32_t sinceSeq);
+
+    /**
+     * @brief Returns the index chain head for a device, adding one if needed. Caller must hold mutex_.
+     * @details When all heads are taken, the device whose newest record is oldest is replaced.
+     */
+    DeviceHead& deviceHead(uint64_t mac);
+
+    static void drainTask(void* parameter);
+
+    static constexpr uint32_t NO_POS = UINT32_MAX; ///< End of an index chain
+    static constexpr size_t DEVICE_HEAD_COUNT = 32; ///< Devices with their own index chains
+
+    static constexpr size_t LOG_CAPACITY = DEZIBOT_LOG_POOL_INFO + DEZIBOT_LOG_POOL_WARNING
+        + DEZIBOT_LOG_POOL_ERROR + DEZIBOT_LOG_POOL_DEBUG + DEZIBOT_LOG_POOL_TRACE; ///< Record slots of all pools
+    static constexpr size_t TEXT_CAPACITY = DEZIBOT_LOG_POOL_INFO * DEZIBOT_LOG_TEXT_INFO
+        + DEZIBOT_LOG_POOL_WARNING * DEZIBOT_LOG_TEXT_WARNING + DEZIBOT_LOG_POOL_ERROR * DEZIBOT_LOG_TEXT_ERROR
+        + DEZIBOT_LOG_POOL_DEBUG * DEZIBOT_LOG_TEXT_DEBUG
+        + DEZIBOT_LOG_POOL_TRACE * DEZIBOT_LOG_TEXT_TRACE; ///< Text bytes of all pools
+
+    static constexpr size_t TASK_STAGE_COUNT = 8; ///< Tasks beyond this share sharedStage_
+    static constexpr uint32_t DRAIN_INTERVAL_MS = 50;
+    static constexpr uint32_t SITE_FLUSH_INTERVAL_MS = 1000; ///< How often quiet log sites are flushed
+
+    std::array<Entry, LOG_CAPACITY> entries_; ///< Preallocated storage of all pools
+    std::array<char, TEXT_CAPACITY> text_; ///< Preallocated text storage of all pools
+    std::array<Pool, LogEntry::LEVEL_COUNT> pools_; ///< Indexed by LogEntry::Level
+    std::array<DeviceHead, DEVICE_HEAD_COUNT> deviceHeads_ = {}; ///< Newest records per device
+    std::array<TaskStage, TASK_STAGE_COUNT> taskStages_; ///< Per-task staging buffers
+    LogStage sharedStage_; ///< Staging buffer for tasks that did not get their own
+    std::mutex sharedStageMutex_; ///< Serializes producers on sharedStage_ only
+    std::mutex mutex_; ///< Guards the pools for the drain step and readers, never taken by loggers
+    bool drainTaskStarted_ = false;
+    std::atomic<LogFlashStore*> flashStore_{nullptr}; ///< Optional persistent copy of the pools
+    uint32_t nextSeq_ = 0; ///< Sequence number of the next record, counted across all pools
 };
 
-#endif // LOGDATABASE_H
\ No newline at end of file
+#endif // LOGDATABASE_H
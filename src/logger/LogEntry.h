@@ -1,9 +1,10 @@
 /**
 * @file LogEntry.h
  * @author Tim Dietrich, Felix Herrling
- * @brief This struct serves as the basic structure of every log entry, where
- * every log entry contains an enum based log level, a timestamp and a message.
- * @version 1.0
+ * @brief This struct serves as the basic structure of every log entry. Entries are stored
+ * as compact binary records (timestamp, level, source MAC, format id and raw arguments);
+ * they are only turned into text when a client requests them.
+ * @version 1.1
  * @date 2025-03-30
  *
  * @copyright Copyright (c) 2025
@@ -13,10 +14,20 @@
 #ifndef LOGENTRY_H
 #define LOGENTRY_H
 
-#include <string>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief Lowest level that is compiled in, e.g. -DDEZIBOT_LOG_LEVEL=WARNING.
+ * Calls through the DEZIBOT_LOG_* macros below this level are removed entirely.
+ */
+#ifndef DEZIBOT_LOG_LEVEL
+#define DEZIBOT_LOG_LEVEL TRACE
+#endif
 
 namespace LogEntry {
-    enum Level {
+    enum Level : uint8_t {
         INFO,
         WARNING,
         ERROR,
@@ -24,12 +35,94 @@ namespace LogEntry {
         TRACE
     };
 
-    struct Entry {
+    /**
+     * @brief Orders levels by importance, the enum values themselves are not ordered.
+     * @return uint8_t TRACE = 0 up to ERROR = 4.
+     */
+    constexpr uint8_t severity(const Level level) {
+        return level == ERROR ? 4 : level == WARNING ? 3 : level == INFO ? 2 : level == DEBUG ? 1 : 0;
+    }
+
+    constexpr Level COMPILED_LEVEL = DEZIBOT_LOG_LEVEL;
+
+    /**
+     * @brief True if messages of this level are compiled in, see DEZIBOT_LOG_LEVEL.
+     */
+    constexpr bool isCompiledIn(const Level level) {
+        return severity(level) >= severity(COMPILED_LEVEL);
+    }
+
+    /**
+     * @brief Identifies the format string used to render a record, see LogFormatter.
+     * @note Ids are stored in records, append new formats at the end.
+     */
+    enum Format : uint8_t {
+        FMT_TEXT,               ///< free-form text, args[0] = text position, args[1] = text length
+        FMT_TELEMETRY_ESPNOW,   ///< args: counter, uptimeMs
+        FMT_TELEMETRY_BLE,      ///< args: counter, uptimeMs
+        FMT_LIGHT_VALUE,        ///< args: sensor, value
+        FMT_LIGHT_BRIGHTEST,    ///< args: type, value
+        FMT_COLOR_VALUE,        ///< args: color, value
+        FMT_AMBIENT_LIGHT,      ///< args: value (float)
+        FMT_TILT,               ///< args: x, y
+        FMT_TILT_DIRECTION,     ///< args: direction
+        FMT_LED_COLOR,          ///< args: leds, color
+        FMT_TOP_LED_COLOR,      ///< args: color
+        FMT_TOP_LED_RGB,        ///< args: red, green, blue
+        FMT_LOGS_DROPPED,       ///< args: number of records lost to full staging buffers
+        FMT_REPEATED,           ///< args: number of identical messages collapsed at one call site
+        FMT_RATE_LIMITED,       ///< args: number of messages one call site was not allowed to store
+        FMT_GROUP_COMMAND,      ///< args: command, acknowledged senders, missing senders
+        FMT_PEER_ADD_FAILED,    ///< no args, the device is the source MAC
+        FMT_DEVICE_TABLE_FULL,  ///< args: capacity, frames refused so far; the device is the source MAC
+        FMT_COUNT
+    };
+
+    static constexpr uint8_t MAX_ARGS = 3;
+
+    struct Record {
+        uint32_t timestampMs;       ///< milliseconds since Logger::startTimer()
         Level level;
-        std::string timestamp;
-        std::string message;
-        std::string sourceMac;
+        uint8_t formatId;           ///< one of LogEntry::Format
+        uint8_t mac[6];             ///< source device, all zero for local logs
+        uint32_t args[MAX_ARGS];    ///< raw format arguments
     };
+
+    static_assert(sizeof(Record) == 24, "LogEntry::Record must stay 24 bytes");
+
+    static constexpr uint8_t LEVEL_COUNT = TRACE + 1;
+
+    /**
+     * @brief Packs a 6 byte MAC address into a 48 bit integer for cheap comparisons.
+     */
+    inline uint64_t packMac(const uint8_t* mac) {
+        uint64_t packed = 0;
+        for (uint8_t i = 0; i < 6; ++i) {
+            packed = (packed << 8) | mac[i];
+        }
+        return packed;
+    }
+
+    /**
+     * @brief Stores a format argument as its raw 32 bit representation.
+     * Floats keep their bit pattern and are decoded again by the %f conversion.
+     */
+    inline uint32_t toArg(const float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    inline uint32_t toArg(const double value) {
+        return toArg(static_cast<float>(value));
+    }
+
+    template <typename T>
+    inline uint32_t toArg(const T value) {
+        static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                      "log arguments must be numeric");
+        return static_cast<uint32_t>(value);
+    }
 }
 
 #endif //LOGENTRY_H
@@ -0,0 +1,377 @@
+/**
+ * @file LogFlashStore.cpp
+ * @author Tim Dietrich, Felix Herrling
+ * @brief Implementation of the LogFlashStore class.
+ * @version 1.0
+ * @date 2025-03-30
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "LogFlashStore.h"
+#include "LogDatabase.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    const char* const LOG_DIRECTORY = "/log";
+    const char* const HEAD_PATH = "/log/head";
+}
+
+LogFlashStore& LogFlashStore::getInstance() {
+    static LogFlashStore instance;
+    return instance;
+}
+
+bool LogFlashStore::begin(fs::FS& fileSystem) {
+    Head head = {};
+    {
+        std::lock_guard<std::mutex> fileLock(fileMutex_);
+        // needed on LittleFS, SPIFFS has no directories and simply ignores it
+        fileSystem.mkdir(LOG_DIRECTORY);
+
+        // an unmounted file system refuses every open, the store then stays disabled
+        File probe = fileSystem.open(HEAD_PATH, "a");
+        if (!probe) {
+            return false;
+        }
+        probe.close();
+        fileSystem_ = &fileSystem;
+
+        File headFile = fileSystem_->open(HEAD_PATH, "r");
+        if (headFile) {
+            if (headFile.read(reinterpret_cast<uint8_t*>(&head), sizeof(head)) != sizeof(head)
+                || head.magic != HEAD_MAGIC) {
+                head = {};
+            }
+            headFile.close();
+        }
+    }
+
+    // rebuild the index before taking pageMutex_, appends must not wait for the scan
+    std::array<SegmentInfo, SEGMENT_COUNT> segments = {};
+    const uint32_t oldestId = head.newestSegmentId >= SEGMENT_COUNT
+        ? head.newestSegmentId - SEGMENT_COUNT + 1
+        : 1;
+    for (uint32_t id = oldestId; id != 0 && id <= head.newestSegmentId; ++id) {
+        SegmentInfo info = {};
+        if (scanSegment(id, info, nullptr)) {
+            segments[id % SEGMENT_COUNT] = info;
+        }
+    }
+
+    std::lock_guard<std::mutex> fileLock(fileMutex_);
+    std::lock_guard<std::mutex> pageLock(pageMutex_);
+    segments_ = segments;
+    newestSegmentId_ = head.newestSegmentId;
+    bootId_ = head.bootId + 1;
+    fillIndex_ = 0;
+    writeIndex_ = 0;
+    fullPages_ = 0;
+    pages_[0] = {};
+    ready_ = true;
+    // every boot starts its own segment, so a segment never mixes boots
+    startSegment();
+    return true;
+}
+
+void LogFlashStore::append(const LogEntry::Record& record, const char* text) {
+    const size_t textLength = record.formatId == LogEntry::FMT_TEXT && text ? record.args[1] : 0;
+    const size_t length = sizeof(record) + textLength;
+
+    std::lock_guard<std::mutex> pageLock(pageMutex_);
+    if (!ready_) {
+        return;
+    }
+
+    const bool rotate = segmentBytes_ + length > SEGMENT_SIZE;
+    // rotating may leave the rest of the current page unused
+    const size_t needed = length + (rotate ? sizeof(SegmentHeader) + PAGE_SIZE : 0);
+    if (needed > freeBytes()) {
+        ++dropped_;
+        return;
+    }
+    if (rotate) {
+        startSegment();
+    }
+
+    LogEntry::Record stored = record;
+    if (record.formatId == LogEntry::FMT_TEXT) {
+        // the text ring position is meaningless on flash, the text follows the record
+        stored.args[0] = 0;
+        stored.args[1] = static_cast<uint32_t>(textLength);
+    }
+    put(&stored, sizeof(stored));
+    put(text, textLength);
+
+    if (record.level == LogEntry::ERROR) {
+        pages_[fillIndex_].urgent = true;
+    }
+
+    SegmentInfo& info = segments_[newestSegmentId_ % SEGMENT_COUNT];
+    if (info.recordCount == 0 || record.timestampMs < info.firstTimestampMs) {
+        info.firstTimestampMs = record.timestampMs;
+    }
+    if (info.recordCount == 0 || record.timestampMs > info.lastTimestampMs) {
+        info.lastTimestampMs = record.timestampMs;
+    }
+    ++info.recordCount;
+}
+
+void LogFlashStore::startSegment() {
+    if (pages_[fillIndex_].used > 0) {
+        closePage();
+    }
+
+    ++newestSegmentId_;
+    segments_[newestSegmentId_ % SEGMENT_COUNT] = {newestSegmentId_, bootId_, 0, 0, 0};
+    segmentBytes_ = 0;
+
+    Page& page = pages_[fillIndex_];
+    page.segmentId = newestSegmentId_;
+    page.startsSegment = true;
+
+    const SegmentHeader header = {SEGMENT_MAGIC, bootId_, newestSegmentId_};
+    put(&header, sizeof(header));
+}
+
+void LogFlashStore::put(const void* data, size_t length) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    segmentBytes_ += length;
+    while (length > 0) {
+        if (pages_[fillIndex_].used == PAGE_SIZE) {
+            closePage();
+        }
+        Page& page = pages_[fillIndex_];
+        if (page.used == 0) {
+            pageStarted_ = std::chrono::steady_clock::now();
+        }
+        const size_t count = std::min(length, PAGE_SIZE - page.used);
+        memcpy(page.data + page.used, bytes, count);
+        page.used = static_cast<uint16_t>(page.used + count);
+        bytes += count;
+        length -= count;
+    }
+}
+
+void LogFlashStore::closePage() {
+    ++fullPages_;
+    fillIndex_ = (fillIndex_ + 1) % PAGE_COUNT;
+    Page& page = pages_[fillIndex_];
+    page.segmentId = newestSegmentId_;
+    page.used = 0;
+    page.startsSegment = false;
+    page.urgent = false;
+}
+
+size_t LogFlashStore::freeBytes() const {
+    return (PAGE_SIZE - pages_[fillIndex_].used) + (PAGE_COUNT - 1 - fullPages_) * PAGE_SIZE;
+}
+
+void LogFlashStore::writePending(const bool force) {
+    std::unique_lock<std::mutex> fileLock(fileMutex_, std::defer_lock);
+    if (force) {
+        fileLock.lock();
+    } else if (!fileLock.try_lock()) {
+        // a query is reading, the pages wait for the next round
+        return;
+    }
+    if (!ready_) {
+        return;
+    }
+
+    while (true) {
+        const Page* page;
+        {
+            std::lock_guard<std::mutex> pageLock(pageMutex_);
+            if (fullPages_ == 0) {
+                const Page& current = pages_[fillIndex_];
+                const auto waitingMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - pageStarted_).count();
+                const bool due = force || current.urgent || waitingMs >= FLUSH_INTERVAL_MS;
+                if (current.used == 0 || !due) {
+                    return;
+                }
+                closePage();
+            }
+            page = &pages_[writeIndex_];
+        }
+
+        // full pages are not touched by append(), so they are written without pageMutex_
+        writePage(*page);
+
+        std::lock_guard<std::mutex> pageLock(pageMutex_);
+        writeIndex_ = (writeIndex_ + 1) % PAGE_COUNT;
+        --fullPages_;
+    }
+}
+
+void LogFlashStore::writePage(const Page& page) {
+    char path[24];
+    segmentPath(page.segmentId, path, sizeof(path));
+
+    const char* mode = "a";
+    if (page.startsSegment) {
+        if (page.segmentId > SEGMENT_COUNT) {
+            char oldestPath[24];
+            segmentPath(page.segmentId - SEGMENT_COUNT, oldestPath, sizeof(oldestPath));
+            fileSystem_->remove(oldestPath);
+        }
+        // head first, a reset in between then leaves a missing segment instead of an orphaned one
+        writeHead(page.segmentId);
+        mode = "w";
+    }
+
+    File file = fileSystem_->open(path, mode);
+    if (!file) {
+        return;
+    }
+    file.write(page.data, page.used);
+    file.close();
+}
+
+void LogFlashStore::writeHead(const uint32_t newestSegmentId) {
+    const Head head = {HEAD_MAGIC, newestSegmentId, bootId_};
+    File file = fileSystem_->open(HEAD_PATH, "w");
+    if (!file) {
+        return;
+    }
+    file.write(reinterpret_cast<const uint8_t*>(&head), sizeof(head));
+    file.close();
+}
+
+size_t LogFlashStore::query(const uint32_t bootId, const uint32_t fromMs, const uint32_t toMs,
+                            const Visitor& visitor) {
+    writePending(true);
+
+    size_t count = 0;
+    for (const auto& segment : getSegments()) {
+        if (segment.bootId != bootId || segment.recordCount == 0
+            || segment.lastTimestampMs < fromMs || segment.firstTimestampMs > toMs) {
+            continue;
+        }
+        SegmentInfo info;
+        scanSegment(segment.id, info, [&](const LogEntry::Record& record, const char* text) {
+            if (record.timestampMs >= fromMs && record.timestampMs <= toMs) {
+                visitor(bootId, record, text);
+                ++count;
+            }
+        });
+    }
+    return count;
+}
+
+std::vector<LogFlashStore::SegmentInfo> LogFlashStore::getSegments() {
+    std::lock_guard<std::mutex> pageLock(pageMutex_);
+    std::vector<SegmentInfo> segments;
+    const uint32_t oldestId = newestSegmentId_ >= SEGMENT_COUNT ? newestSegmentId_ - SEGMENT_COUNT + 1 : 1;
+    for (uint32_t id = oldestId; id != 0 && id <= newestSegmentId_; ++id) {
+        const SegmentInfo& info = segments_[id % SEGMENT_COUNT];
+        if (info.id == id) {
+            segments.push_back(info);
+        }
+    }
+    return segments;
+}
+
+size_t LogFlashStore::readSegment(const uint32_t segmentId, const size_t offset, uint8_t* out,
+                                  const size_t capacity) {
+    char path[24];
+    segmentPath(segmentId, path, sizeof(path));
+    if (!fileSystem_->exists(path)) {
+        return 0;
+    }
+    File file = fileSystem_->open(path, "r");
+    if (!file) {
+        return 0;
+    }
+    size_t length = 0;
+    if (file.seek(offset)) {
+        length = file.read(out, capacity);
+    }
+    file.close();
+    return length;
+}
+
+size_t LogFlashStore::decodeRecord(const uint8_t* data, const size_t length, LogEntry::Record& record,
+                                   char* text) {
+    if (length < sizeof(record)) {
+        return 0;
+    }
+    memcpy(&record, data, sizeof(record));
+    if (record.level >= LogEntry::LEVEL_COUNT || record.formatId >= LogEntry::FMT_COUNT) {
+        return 0;
+    }
+    if (record.formatId != LogEntry::FMT_TEXT) {
+        return sizeof(record);
+    }
+    const size_t textLength = record.args[1];
+    if (textLength > LogDatabase::MAX_TEXT_LENGTH || length - sizeof(record) < textLength) {
+        return 0;
+    }
+    memcpy(text, data + sizeof(record), textLength);
+    text[textLength] = '\0';
+    return sizeof(record) + textLength;
+}
+
+bool LogFlashStore::scanSegment(const uint32_t segmentId, SegmentInfo& info,
+                                const std::function<void(const LogEntry::Record&, const char*)>& visitor) {
+    static_assert(SCAN_CHUNK_SIZE >= sizeof(SegmentHeader) + sizeof(LogEntry::Record) + LogDatabase::MAX_TEXT_LENGTH,
+                  "a scan chunk has to hold the segment header and the largest record");
+    uint8_t chunk[SCAN_CHUNK_SIZE];
+    char text[LogDatabase::MAX_TEXT_LENGTH + 1];
+    size_t offset = 0;
+    while (true) {
+        size_t length;
+        {
+            // only the copy is made under the lock, a slow visitor must not stall the writer
+            std::lock_guard<std::mutex> fileLock(fileMutex_);
+            length = readSegment(segmentId, offset, chunk, sizeof(chunk));
+        }
+
+        size_t used = 0;
+        if (offset == 0) {
+            SegmentHeader header;
+            if (length < sizeof(header)) {
+                return false;
+            }
+            memcpy(&header, chunk, sizeof(header));
+            if (header.magic != SEGMENT_MAGIC || header.segmentId != segmentId) {
+                return false;
+            }
+            info = {segmentId, header.bootId, 0, 0, 0};
+            used = sizeof(header);
+        }
+
+        // stops at the first incomplete or invalid record, e.g. one cut off by a reset
+        LogEntry::Record record;
+        size_t recordLength;
+        while ((recordLength = decodeRecord(chunk + used, length - used, record, text)) > 0) {
+            used += recordLength;
+
+            if (info.recordCount == 0 || record.timestampMs < info.firstTimestampMs) {
+                info.firstTimestampMs = record.timestampMs;
+            }
+            if (info.recordCount == 0 || record.timestampMs > info.lastTimestampMs) {
+                info.lastTimestampMs = record.timestampMs;
+            }
+            ++info.recordCount;
+
+            if (visitor) {
+                visitor(record, record.formatId == LogEntry::FMT_TEXT ? text : nullptr);
+            }
+        }
+
+        // a chunk always holds a complete record, so a short chunk is the end of the file
+        if (length < sizeof(chunk) || used == 0) {
+            return true;
+        }
+        offset += used;
+    }
+}
+
+void LogFlashStore::segmentPath(const uint32_t segmentId, char* out, const size_t capacity) {
+    snprintf(out, capacity, "%s/%08lx", LOG_DIRECTORY, static_cast<unsigned long>(segmentId));
+}
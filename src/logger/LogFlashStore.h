@@ -0,0 +1,226 @@
+/**
+ * @file LogFlashStore.h
+ * @author Tim Dietrich, Felix Herrling
+ * @brief Persists log records to flash so they survive a reset. Records are appended in the
+ * binary format to segment files of a fixed size; when the last segment is full a new one is
+ * started and the oldest one removed. Writes are collected in page sized buffers and written
+ * from the log drain task, never from the logging task itself.
+ * @version 1.0
+ * @date 2025-03-30
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef LOGFLASHSTORE_H
+#define LOGFLASHSTORE_H
+
+#include "LogEntry.h"
+#include <FS.h>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+class LogFlashStore {
+public:
+    /**
+     * @brief Index entry of one segment file, kept in RAM.
+     */
+    struct SegmentInfo {
+        uint32_t id;
+        uint32_t bootId;
+        uint32_t firstTimestampMs;
+        uint32_t lastTimestampMs;
+        uint32_t recordCount;
+    };
+
+    /**
+     * @brief Called for every record found by query(). text is only set for FMT_TEXT records.
+     */
+    using Visitor = std::function<void(uint32_t bootId, const LogEntry::Record& record, const char* text)>;
+
+    /**
+     * @brief Returns a reference to the instance of the LogFlashStore.
+     * @return LogFlashStore
+     */
+    static LogFlashStore& getInstance();
+
+    /**
+     * @brief Rebuilds the segment index from flash and starts a new boot.
+     * @note The file system has to be mounted already.
+     * @param fileSystem file system the segments are stored on, e.g. SPIFFS.
+     * @return true if the store is ready for writing, false if the file system cannot be
+     * written, e.g. because mounting it failed.
+     */
+    bool begin(fs::FS& fileSystem);
+
+    /**
+     * @brief Copies a record into the page buffer. Does not touch flash.
+     * @details Called by the log database for every record it stores. If the page buffers are
+     * full because flash is too slow, the record is dropped from flash only.
+     * @param record the record to store.
+     * @param text message text of FMT_TEXT records (args[1] bytes), otherwise ignored.
+     */
+    void append(const LogEntry::Record& record, const char* text);
+
+    /**
+     * @brief Writes all full pages to flash, and the current page as well once it has been
+     * waiting for FLUSH_INTERVAL_MS or holds an ERROR record.
+     * @param force write the current page regardless of its age, and wait for a running
+     * query instead of skipping this round.
+     */
+    void writePending(bool force = false);
+
+    /**
+     * @brief Reads all stored records of one boot with a timestamp in [fromMs, toMs].
+     * @details The segments are read in chunks, file access is only blocked while a chunk is
+     * copied, not while visitor runs.
+     * @param bootId boot to read, see getBootId() and getSegments().
+     * @param fromMs first timestamp (milliseconds since that boot) to return.
+     * @param toMs last timestamp to return.
+     * @param visitor called for every matching record, oldest first.
+     * @return size_t Number of records passed to visitor.
+     */
+    size_t query(uint32_t bootId, uint32_t fromMs, uint32_t toMs, const Visitor& visitor);
+
+    /**
+     * @brief Returns the index of all stored segments, oldest first.
+     */
+    std::vector<SegmentInfo> getSegments();
+
+    /**
+     * @brief Returns the id of the current boot, 0 before begin() was called.
+     */
+    uint32_t getBootId() const { return bootId_; }
+
+    /**
+     * @brief Returns the number of records that were not persisted because the page buffers were full.
+     */
+    uint32_t getDroppedRecords() const { return dropped_; }
+
+private:
+    LogFlashStore() = default;
+    ~LogFlashStore() = default;
+
+    LogFlashStore(const LogFlashStore&) = delete;
+    LogFlashStore& operator=(const LogFlashStore&) = delete;
+
+    /**
+     * @brief A batch of bytes for one segment file.
+     */
+    struct Page {
+        uint32_t segmentId;
+        uint16_t used;
+        bool startsSegment; ///< data begins with the segment header, the file is created
+        bool urgent; ///< holds an ERROR record, written without waiting
+        uint8_t data[256]; ///< one SPIFFS flash page
+    };
+
+    /**
+     * @brief First bytes of every segment file.
+     */
+    struct SegmentHeader {
+        uint32_t magic;
+        uint32_t bootId;
+        uint32_t segmentId;
+    };
+
+    /**
+     * @brief Contents of the head file, which points to the newest segment.
+     */
+    struct Head {
+        uint32_t magic;
+        uint32_t newestSegmentId;
+        uint32_t bootId;
+    };
+
+    /**
+     * @brief Starts a new segment and queues its header. Caller must hold pageMutex_.
+     */
+    void startSegment();
+
+    /**
+     * @brief Queues bytes for the current segment. Caller must hold pageMutex_ and have
+     * checked that they fit.
+     */
+    void put(const void* data, size_t length);
+
+    /**
+     * @brief Hands the page being filled to the writer. Caller must hold pageMutex_.
+     */
+    void closePage();
+
+    /**
+     * @brief Number of bytes that can still be queued. Caller must hold pageMutex_.
+     */
+    size_t freeBytes() const;
+
+    /**
+     * @brief Writes one page to its segment file. Caller must hold fileMutex_.
+     */
+    void writePage(const Page& page);
+
+    /**
+     * @brief Copies up to capacity bytes of a segment file, starting at offset. Caller must
+     * hold fileMutex_.
+     * @return size_t Number of bytes copied, 0 if the file does not exist.
+     */
+    size_t readSegment(uint32_t segmentId, size_t offset, uint8_t* out, size_t capacity);
+
+    /**
+     * @brief Decodes the record at the start of data.
+     * @param text receives the terminated message text of FMT_TEXT records.
+     * @return size_t Bytes taken by the record, 0 if data holds no complete valid record.
+     */
+    static size_t decodeRecord(const uint8_t* data, size_t length, LogEntry::Record& record, char* text);
+
+    /**
+     * @brief Reads the header and all records of a segment file. Takes fileMutex_ for every
+     * chunk read, so the caller must not hold it.
+     * @param info receives the header data and timestamp range.
+     * @param visitor called for every valid record without fileMutex_ held, may be empty.
+     * @return false if the file does not exist or has no valid header.
+     */
+    bool scanSegment(uint32_t segmentId, SegmentInfo& info,
+                     const std::function<void(const LogEntry::Record&, const char*)>& visitor);
+
+    /**
+     * @brief Points the head file to a new newest segment. Caller must hold fileMutex_.
+     */
+    void writeHead(uint32_t newestSegmentId);
+
+    static void segmentPath(uint32_t segmentId, char* out, size_t capacity);
+
+    static constexpr uint32_t SEGMENT_MAGIC = 0x444C4F47; ///< "DLOG"
+    static constexpr uint32_t HEAD_MAGIC = 0x444C4844; ///< "DLHD"
+    static constexpr size_t PAGE_SIZE = sizeof(Page::data); ///< Flash page size of SPIFFS
+    static constexpr size_t PAGE_COUNT = 8; ///< Pages waiting for the writer
+    static constexpr size_t SEGMENT_SIZE = 16384; ///< Bytes per segment file
+    static constexpr size_t SEGMENT_COUNT = 8; ///< Segments kept on flash
+    static constexpr size_t SCAN_CHUNK_SIZE = 2 * PAGE_SIZE; ///< Bytes read per lock, fits the largest record
+    static constexpr uint32_t FLUSH_INTERVAL_MS = 1000; ///< Maximum time a record waits in RAM
+
+    fs::FS* fileSystem_ = nullptr;
+    bool ready_ = false;
+    uint32_t bootId_ = 0;
+    uint32_t dropped_ = 0;
+
+    std::array<Page, PAGE_COUNT> pages_; ///< Ring of pages, fillIndex_ is being filled
+    size_t fillIndex_ = 0;
+    size_t writeIndex_ = 0;
+    size_t fullPages_ = 0;
+    std::chrono::steady_clock::time_point pageStarted_; ///< When the first byte went into the current page
+
+    std::array<SegmentInfo, SEGMENT_COUNT> segments_ = {}; ///< Segment n is at segments_[n % SEGMENT_COUNT]
+    uint32_t newestSegmentId_ = 0; ///< 0 means no segment yet
+    size_t segmentBytes_ = 0; ///< Bytes queued for the newest segment
+
+    std::mutex pageMutex_; ///< Guards the pages and the index, held only for copying
+    std::mutex fileMutex_; ///< Serializes file access, taken before pageMutex_
+};
+
+#endif // LOGFLASHSTORE_H
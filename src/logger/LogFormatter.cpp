@@ -0,0 +1,213 @@
+/**
+ * @file LogFormatter.cpp
+ * @author Tim Dietrich, Felix Herrling
+ * @brief Implementation of the LogFormatter class.
+ * @version 1.0
+ * @date 2025-03-30
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "LogFormatter.h"
+#include "LogDatabase.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+    // indexed by LogEntry::Format
+    const char* const FORMAT_STRINGS[LogEntry::FMT_COUNT] = {
+        nullptr, // FMT_TEXT, stored in the text ring of the database
+        "Telemetry [ESP-NOW]: counter=%u uptime=%u",
+        "Telemetry [BLE]: counter=%u uptime=%u",
+        "Getting LightDetection Value for sensor: %u with value: %u",
+        "Getting brightest sensor for type: %u with result: %u",
+        "Getting color value for color Sensor %u with value: %u",
+        "Getting ambient light with value: %f",
+        "Getting tilt with values: x= %d y= %d",
+        "Getting tilt direction with value %u",
+        "Setting LED %u to color value: %u",
+        "Setting Top LED to color value: %u",
+        "Setting Top LED to RGB value: (%u, %u, %u)",
+        "%u log entries dropped, staging buffer full",
+        "Last message repeated %u times",
+        "%u messages suppressed by rate limit",
+        "Group command 0x%02X: %u acknowledged, %u missing",
+        "Command not sent, ESP-NOW peer could not be added",
+        "Device table full (%u senders), frame dropped, %u refused so far",
+    };
+
+    // indexed by LogEntry::Level
+    const char* const LEVEL_NAMES[LogEntry::LEVEL_COUNT] = {
+        "INFO", "WARNING", "ERROR", "DEBUG", "TRACE"
+    };
+
+    // appends a snprintf result, keeping track of truncation
+    size_t appended(const int written, const size_t used, const size_t capacity) {
+        if (written < 0) {
+            return used;
+        }
+        const size_t total = used + static_cast<size_t>(written);
+        return total < capacity ? total : capacity - 1;
+    }
+}
+
+const char* LogFormatter::formatString(const uint8_t formatId) {
+    return formatId < LogEntry::FMT_COUNT ? FORMAT_STRINGS[formatId] : nullptr;
+}
+
+size_t LogFormatter::formatMessage(const LogEntry::Record& record, const char* text,
+                                   char* out, const size_t capacity) {
+    if (record.formatId != LogEntry::FMT_TEXT || !text) {
+        return formatMessage(record, out, capacity);
+    }
+    if (capacity == 0) {
+        return 0;
+    }
+    const size_t length = std::min<size_t>(record.args[1], capacity - 1);
+    memcpy(out, text, length);
+    out[length] = '\0';
+    return length;
+}
+
+size_t LogFormatter::formatMessage(const LogEntry::Record& record, char* out, const size_t capacity) {
+    if (capacity == 0) {
+        return 0;
+    }
+    out[0] = '\0';
+
+    if (record.formatId == LogEntry::FMT_TEXT) {
+        if (!LogDatabase::getInstance().readText(record, out, capacity)) {
+            return appended(snprintf(out, capacity, "<message overwritten>"), 0, capacity);
+        }
+        return strlen(out);
+    }
+
+    const char* format = formatString(record.formatId);
+    if (!format) {
+        return appended(snprintf(out, capacity, "<unknown format %u>", record.formatId), 0, capacity);
+    }
+
+    size_t used = 0;
+    uint8_t argIndex = 0;
+    for (const char* p = format; *p && used + 1 < capacity; ++p) {
+        if (*p != '%') {
+            out[used++] = *p;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[used++] = '%';
+            ++p;
+            continue;
+        }
+
+        // copy "%[flags][width][.precision]" and let snprintf do the actual work
+        char spec[16];
+        size_t specLength = 0;
+        const char* q = p;
+        while (*q && specLength < sizeof(spec) - 3 && strchr("%-+ 0#.123456789", *q)) {
+            spec[specLength++] = *q++;
+        }
+
+        const char conversion = *q;
+        const uint32_t arg = argIndex < LogEntry::MAX_ARGS ? record.args[argIndex] : 0;
+        ++argIndex;
+        int written;
+        switch (conversion) {
+            case 'd':
+                spec[specLength++] = 'l';
+                spec[specLength++] = 'd';
+                spec[specLength] = '\0';
+                written = snprintf(out + used, capacity - used, spec, static_cast<long>(static_cast<int32_t>(arg)));
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+                spec[specLength++] = 'l';
+                spec[specLength++] = conversion;
+                spec[specLength] = '\0';
+                written = snprintf(out + used, capacity - used, spec, static_cast<unsigned long>(arg));
+                break;
+            case 'f': {
+                float value;
+                memcpy(&value, &arg, sizeof(value));
+                spec[specLength++] = 'f';
+                spec[specLength] = '\0';
+                written = snprintf(out + used, capacity - used, spec, static_cast<double>(value));
+                break;
+            }
+            default:
+                // unsupported conversion, emit it verbatim without consuming an argument
+                --argIndex;
+                if (conversion != '\0') {
+                    spec[specLength++] = conversion;
+                } else {
+                    --q;
+                }
+                spec[specLength] = '\0';
+                written = snprintf(out + used, capacity - used, "%s", spec);
+                break;
+        }
+        used = appended(written, used, capacity);
+        p = q;
+    }
+    out[used] = '\0';
+    return used;
+}
+
+const char* LogFormatter::levelName(const LogEntry::Level level) {
+    return level < LogEntry::LEVEL_COUNT ? LEVEL_NAMES[level] : "UNKNOWN";
+}
+
+bool LogFormatter::parseLevel(const char* text, LogEntry::Level& level) {
+    for (uint8_t i = 0; i < LogEntry::LEVEL_COUNT; ++i) {
+        if (strcmp(text, LEVEL_NAMES[i]) == 0) {
+            level = static_cast<LogEntry::Level>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t LogFormatter::formatTimestamp(const uint32_t timestampMs, char* out, const size_t capacity) {
+    if (capacity == 0) {
+        return 0;
+    }
+    const unsigned long hours = timestampMs / (1000UL * 60 * 60);
+    const unsigned long minutes = (timestampMs / (1000UL * 60)) % 60;
+    const unsigned long seconds = (timestampMs / 1000UL) % 60;
+    const unsigned long milliseconds = timestampMs % 1000UL;
+    return appended(snprintf(out, capacity, "%02lu:%02lu:%02lu.%02lu", hours, minutes, seconds, milliseconds),
+                    0, capacity);
+}
+
+size_t LogFormatter::formatMac(const uint8_t* mac, char* out, const size_t capacity) {
+    if (capacity == 0) {
+        return 0;
+    }
+    static const uint8_t NO_MAC[6] = {};
+    if (memcmp(mac, NO_MAC, sizeof(NO_MAC)) == 0) {
+        out[0] = '\0';
+        return 0;
+    }
+    return appended(snprintf(out, capacity, "%02X:%02X:%02X:%02X:%02X:%02X",
+                             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]),
+                    0, capacity);
+}
+
+bool LogFormatter::parseMac(const char* text, uint8_t* out) {
+    memset(out, 0, 6);
+    if (!text || !*text) {
+        return false;
+    }
+    unsigned int bytes[6];
+    if (sscanf(text, "%x:%x:%x:%x:%x:%x",
+               &bytes[0], &bytes[1], &bytes[2], &bytes[3], &bytes[4], &bytes[5]) != 6) {
+        return false;
+    }
+    for (size_t i = 0; i < 6; ++i) {
+        out[i] = static_cast<uint8_t>(bytes[i]);
+    }
+    return true;
+}
@@ -0,0 +1,79 @@
+/**
+ * @file LogFormatter.h
+ * @author Tim Dietrich, Felix Herrling
+ * @brief Turns binary log records into text. Formatting is deferred until a client
+ * actually requests the logs, so writing a log entry never builds strings.
+ * @version 1.0
+ * @date 2025-03-30
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef LOGFORMATTER_H
+#define LOGFORMATTER_H
+
+#include "LogEntry.h"
+#include <cstddef>
+#include <cstdint>
+
+class LogFormatter {
+public:
+    /**
+     * @brief Returns the printf-style format string registered for a format id.
+     * @details Supported conversions are %d, %u, %x, %X and %f (float stored via LogEntry::toArg),
+     * each with optional flags, width and precision.
+     * @param formatId one of LogEntry::Format.
+     * @return const char* The format string, or nullptr for unknown ids.
+     */
+    static const char* formatString(uint8_t formatId);
+
+    /**
+     * @brief Renders the message of a record.
+     * @param record the record to render.
+     * @param out destination buffer, always null terminated.
+     * @param capacity size of out in bytes.
+     * @return size_t Number of characters written.
+     */
+    static size_t formatMessage(const LogEntry::Record& record, char* out, size_t capacity);
+
+    /**
+     * @brief Same as above, but takes the text of FMT_TEXT records from text instead of
+     * the log database, e.g. for records read back from flash.
+     * @param text args[1] characters of message text, may be nullptr for other formats.
+     */
+    static size_t formatMessage(const LogEntry::Record& record, const char* text, char* out, size_t capacity);
+
+    /**
+     * @brief Returns the name of a level, e.g. "WARNING".
+     */
+    static const char* levelName(LogEntry::Level level);
+
+    /**
+     * @brief Parses a level name as returned by levelName().
+     * @return false if text is not a known level name.
+     */
+    static bool parseLevel(const char* text, LogEntry::Level& level);
+
+    /**
+     * @brief Renders a millisecond timestamp in HH:MM:SS.mm format.
+     * @return size_t Number of characters written.
+     */
+    static size_t formatTimestamp(uint32_t timestampMs, char* out, size_t capacity);
+
+    /**
+     * @brief Renders a MAC address as AA:BB:CC:DD:EE:FF, or an empty string for an all zero MAC.
+     * @return size_t Number of characters written.
+     */
+    static size_t formatMac(const uint8_t* mac, char* out, size_t capacity);
+
+    /**
+     * @brief Parses a MAC address in AA:BB:CC:DD:EE:FF format.
+     * @param text the string to parse, may be nullptr or empty.
+     * @param out receives the 6 address bytes, all zero if parsing failed.
+     * @return true if text contained a valid MAC address.
+     */
+    static bool parseMac(const char* text, uint8_t* out);
+};
+
+#endif //LOGFORMATTER_H
@@ -0,0 +1,92 @@
+/**
+ * @file LogSite.cpp
+ * @author Tim Dietrich, Felix Herrling
+ * @brief Implementation of the LogSite class.
+ * @version 1.0
+ * @date 2025-03-30
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "LogSite.h"
+
+std::atomic<LogSite*> LogSite::pendingSites_{nullptr};
+
+LogSite::Decision LogSite::check(const uint32_t hash, const LogEntry::Level level, const uint32_t nowMs) {
+    Decision decision = {true, 0, 0, level};
+
+    // another task is logging from the same site right now, let this message through
+    // instead of waiting, the limit only has to hold on average
+    if (busy_.exchange(true, std::memory_order_acquire)) {
+        return decision;
+    }
+
+    const uint32_t elapsedMs = nowMs - lastRefillMs_;
+    lastRefillMs_ = nowMs;
+    const uint32_t refill = elapsedMs < MAX_MILLI_TOKENS / DEZIBOT_LOG_SITE_RATE
+        ? elapsedMs * DEZIBOT_LOG_SITE_RATE
+        : MAX_MILLI_TOKENS;
+    milliTokens_ = MAX_MILLI_TOKENS - milliTokens_ > refill ? milliTokens_ + refill : MAX_MILLI_TOKENS;
+
+    if (hasLast_ && hash == lastHash_ && nowMs - lastStoredMs_ < REPEAT_WINDOW_MS) {
+        // repeats are only counted, they cost no tokens
+        ++repeated_;
+        decision.store = false;
+    } else if (milliTokens_ < MILLI_TOKENS_PER_MESSAGE) {
+        ++suppressed_;
+        decision.store = false;
+    } else {
+        milliTokens_ -= MILLI_TOKENS_PER_MESSAGE;
+        decision.repeated = repeated_;
+        decision.repeatedLevel = lastLevel_;
+        decision.suppressed = suppressed_;
+        repeated_ = 0;
+        suppressed_ = 0;
+        hasLast_ = true;
+        lastHash_ = hash;
+        lastStoredMs_ = nowMs;
+        lastLevel_ = level;
+    }
+
+    // a site that holds counts has to be found by flushAll() in case it goes quiet
+    if (!decision.store && !listed_) {
+        listed_ = true;
+        next_ = pendingSites_.load(std::memory_order_relaxed);
+        while (!pendingSites_.compare_exchange_weak(next_, this, std::memory_order_release,
+                                                    std::memory_order_relaxed)) {
+        }
+    }
+
+    busy_.store(false, std::memory_order_release);
+    return decision;
+}
+
+void LogSite::flushAll(const uint32_t nowMs, const std::function<void(const Decision&)>& emit) {
+    for (LogSite* site = pendingSites_.load(std::memory_order_acquire); site; site = site->next_) {
+        // a site that is logging right now hands out its counts with the next stored message
+        if (site->busy_.exchange(true, std::memory_order_acquire)) {
+            continue;
+        }
+        Decision decision = {false, 0, 0, site->lastLevel_};
+        if ((site->repeated_ > 0 || site->suppressed_ > 0) && nowMs - site->lastStoredMs_ >= REPEAT_WINDOW_MS) {
+            decision.repeated = site->repeated_;
+            decision.suppressed = site->suppressed_;
+            site->repeated_ = 0;
+            site->suppressed_ = 0;
+        }
+        site->busy_.store(false, std::memory_order_release);
+
+        if (decision.repeated > 0 || decision.suppressed > 0) {
+            emit(decision);
+        }
+    }
+}
+
+uint32_t LogSite::hash(const void* data, const size_t length, uint32_t seed) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < length; ++i) {
+        seed = (seed ^ bytes[i]) * 16777619u;
+    }
+    return seed;
+}
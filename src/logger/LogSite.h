@@ -0,0 +1,97 @@
+/**
+ * @file LogSite.h
+ * @author Tim Dietrich, Felix Herrling
+ * @brief State of a single logging call site. Every DEZIBOT_LOG_* macro owns one, it limits how
+ * many messages the site may store per second (token bucket) and collapses identical consecutive
+ * messages into a "last message repeated N times" entry, so one chatty sensor getter cannot
+ * push everything else out of the log. Counts a site is still holding when it goes quiet are
+ * written by flushAll() once the repeat window has passed.
+ * @version 1.0
+ * @date 2025-03-30
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef LOGSITE_H
+#define LOGSITE_H
+
+#include "LogEntry.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+/**
+ * @brief Messages per second a call site may store on average, e.g. -DDEZIBOT_LOG_SITE_RATE=10.
+ */
+#ifndef DEZIBOT_LOG_SITE_RATE
+#define DEZIBOT_LOG_SITE_RATE 5
+#endif
+
+/**
+ * @brief Messages a call site may store in a burst before the rate applies.
+ */
+#ifndef DEZIBOT_LOG_SITE_BURST
+#define DEZIBOT_LOG_SITE_BURST 10
+#endif
+
+class LogSite {
+public:
+    /**
+     * @brief Result of check(). Pending counts have to be logged before the message itself.
+     */
+    struct Decision {
+        bool store;                    ///< false if the message is a repeat or over the rate
+        uint32_t repeated;             ///< identical messages collapsed since the last stored one
+        uint32_t suppressed;           ///< messages dropped by the rate limit since the last stored one
+        LogEntry::Level repeatedLevel; ///< level of the message that was repeated
+    };
+
+    constexpr LogSite() = default;
+
+    /**
+     * @brief Decides whether a message of this call site is stored.
+     * @param hash identifies the message content, see hash().
+     * @param level level of the message.
+     * @param nowMs current log timestamp.
+     */
+    Decision check(uint32_t hash, LogEntry::Level level, uint32_t nowMs);
+
+    /**
+     * @brief Hands out the counts of every site that has been holding them for longer than the
+     * repeat window. Called periodically by the log drain task, see Logger::flushSites().
+     * @param nowMs current log timestamp.
+     * @param emit called with the counts of one site, store is always false.
+     */
+    static void flushAll(uint32_t nowMs, const std::function<void(const Decision&)>& emit);
+
+    /**
+     * @brief FNV-1a hash used to detect repeated messages, chain calls via seed.
+     */
+    static uint32_t hash(const void* data, size_t length, uint32_t seed = 2166136261u);
+
+private:
+    LogSite(const LogSite&) = delete;
+    LogSite& operator=(const LogSite&) = delete;
+
+    static constexpr uint32_t MILLI_TOKENS_PER_MESSAGE = 1000;
+    static constexpr uint32_t MAX_MILLI_TOKENS = DEZIBOT_LOG_SITE_BURST * MILLI_TOKENS_PER_MESSAGE;
+    static constexpr uint32_t REPEAT_WINDOW_MS = 10000; ///< A repeat after this long is stored again
+
+    static std::atomic<LogSite*> pendingSites_; ///< Sites that have held counts, linked by next_
+
+    std::atomic<bool> busy_{false}; ///< Set while one task updates the site
+    bool hasLast_ = false;
+    uint32_t lastHash_ = 0;
+    uint32_t lastStoredMs_ = 0;
+    LogEntry::Level lastLevel_ = LogEntry::INFO;
+    uint32_t repeated_ = 0;
+    uint32_t suppressed_ = 0;
+    uint32_t milliTokens_ = MAX_MILLI_TOKENS; ///< Token bucket, in thousandths of a message
+    uint32_t lastRefillMs_ = 0;
+    bool listed_ = false; ///< Already in pendingSites_, sites are never removed
+    LogSite* next_ = nullptr;
+};
+
+#endif // LOGSITE_H
@@ -0,0 +1,77 @@
+/**
+ * @file LogStage.cpp
+ * @author Tim Dietrich, Felix Herrling
+ * @brief Implementation of the LogStage class.
+ * @version 1.0
+ * @date 2025-03-30
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "LogStage.h"
+#include <algorithm>
+
+uint32_t LogStage::textLength(const LogEntry::Record& record) {
+    return record.formatId == LogEntry::FMT_TEXT ? record.args[1] : 0;
+}
+
+bool LogStage::push(const LogEntry::Record& record, const char* text) {
+    const uint32_t head = head_.load(std::memory_order_relaxed);
+    const uint32_t tail = tail_.load(std::memory_order_acquire);
+    const uint32_t length = sizeof(record) + textLength(record);
+
+    if (CAPACITY - (head - tail) < length) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    copyIn(head, &record, sizeof(record));
+    copyIn(head + sizeof(record), text, textLength(record));
+    // publish the frame only after it has been written completely
+    head_.store(head + length, std::memory_order_release);
+    return true;
+}
+
+bool LogStage::peek(LogEntry::Record& record) const {
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    if (head_.load(std::memory_order_acquire) == tail) {
+        return false;
+    }
+    copyOut(tail, &record, sizeof(record));
+    return true;
+}
+
+bool LogStage::pop(LogEntry::Record& record, char* text) {
+    if (!peek(record)) {
+        return false;
+    }
+    const uint32_t tail = tail_.load(std::memory_order_relaxed);
+    copyOut(tail + sizeof(record), text, textLength(record));
+    tail_.store(tail + sizeof(record) + textLength(record), std::memory_order_release);
+    return true;
+}
+
+uint32_t LogStage::takeDropped() {
+    return dropped_.exchange(0, std::memory_order_relaxed);
+}
+
+void LogStage::copyIn(const uint32_t position, const void* data, const size_t length) {
+    if (length == 0) {
+        return;
+    }
+    const size_t start = position & MASK;
+    const size_t firstPart = std::min(length, CAPACITY - start);
+    memcpy(&buffer_[start], data, firstPart);
+    memcpy(&buffer_[0], static_cast<const uint8_t*>(data) + firstPart, length - firstPart);
+}
+
+void LogStage::copyOut(const uint32_t position, void* data, const size_t length) const {
+    if (length == 0) {
+        return;
+    }
+    const size_t start = position & MASK;
+    const size_t firstPart = std::min(length, CAPACITY - start);
+    memcpy(data, &buffer_[start], firstPart);
+    memcpy(static_cast<uint8_t*>(data) + firstPart, &buffer_[0], length - firstPart);
+}
@@ -0,0 +1,68 @@
+/**
+ * @file LogStage.h
+ * @author Tim Dietrich, Felix Herrling
+ * @brief Single-producer/single-consumer staging buffer for log records. Every task logs into
+ * its own stage without locking; the log database drains all stages into the central store.
+ * @version 1.0
+ * @date 2025-03-30
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef LOGSTAGE_H
+#define LOGSTAGE_H
+
+#include "LogEntry.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+class LogStage {
+public:
+    static constexpr size_t CAPACITY = 1024; ///< Size in bytes, must be a power of two
+
+    /**
+     * @brief Appends a record and, for FMT_TEXT records, its text. Producer side only.
+     * @param record the record to stage, for FMT_TEXT records args[1] holds the text length.
+     * @param text message text for FMT_TEXT records, nullptr otherwise.
+     * @return false if the stage is full; the record is dropped and counted.
+     */
+    bool push(const LogEntry::Record& record, const char* text);
+
+    /**
+     * @brief Reads the next record without consuming it. Consumer side only.
+     * @param record receives the record.
+     * @return false if the stage is empty.
+     */
+    bool peek(LogEntry::Record& record) const;
+
+    /**
+     * @brief Consumes the next record, copying its text into text if it has any.
+     * @param record receives the record.
+     * @param text buffer of at least MAX_TEXT_LENGTH bytes, not null terminated.
+     * @return false if the stage is empty.
+     */
+    bool pop(LogEntry::Record& record, char* text);
+
+    /**
+     * @brief Returns and resets the number of records dropped because the stage was full.
+     */
+    uint32_t takeDropped();
+
+private:
+    static constexpr uint32_t MASK = CAPACITY - 1;
+    static_assert((CAPACITY & MASK) == 0, "LogStage::CAPACITY must be a power of two");
+
+    static uint32_t textLength(const LogEntry::Record& record);
+    void copyIn(uint32_t position, const void* data, size_t length);
+    void copyOut(uint32_t position, void* data, size_t length) const;
+
+    std::array<uint8_t, CAPACITY> buffer_;
+    std::atomic<uint32_t> head_{0}; ///< Total bytes written by the producer
+    std::atomic<uint32_t> tail_{0}; ///< Total bytes consumed by the drain
+    std::atomic<uint32_t> dropped_{0};
+};
+
+#endif //LOGSTAGE_H
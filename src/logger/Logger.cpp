@@ -4,9 +4,8 @@
 
 #include "Logger.h"
 #include "LogDatabase.h"
+#include "LogFormatter.h"
 #include <chrono>
-#include <sstream>
-#include <iomanip>
 
 std::chrono::steady_clock::time_point startTime;
 
@@ -14,7 +13,7 @@ std::chrono::steady_clock::time_point startTime;
 void Logger::startTimer() {
 	using namespace std::chrono;
 	startTime = steady_clock::now();
-    return;
+    LogDatabase::getInstance().startDrainTask();
 }
 
 // Get the singleton instance of Logger
@@ -25,16 +24,13 @@ Logger& Logger::getInstance() {
 
 // Log a message with a given level
 void Logger::log(const LogEntry::Level level, const std::string& message, const std::string& sourceMac) const {
-    if (!loggingEnabled) {
+    if (!isEnabled(level)) {
         return;
     }
-    const LogEntry::Entry entry = {
-        .level = level,
-        .timestamp = getCurrentTimestamp(),
-        .message = message,
-        .sourceMac = sourceMac
-    };
-    LogDatabase::getInstance().addLog(entry);
+    uint8_t mac[6];
+    LogFormatter::parseMac(sourceMac.c_str(), mac);
+    const LogEntry::Record record = makeRecord(level, LogEntry::FMT_TEXT, mac);
+    LogDatabase::getInstance().addLog(record, message.data(), message.size());
 }
 
 void Logger::logInfo(const std::string& message, const std::string& sourceMac) const {
@@ -57,28 +53,73 @@ void Logger::logTrace(const std::string& message, const std::string& sourceMac)
 	  log(LogEntry::TRACE, message, sourceMac);
 }
 
-// Generate a placeholder timestamp (to be replaced with actual implementation)
-std::string Logger::getCurrentTimestamp() const {
-    using namespace std::chrono;
+void Logger::logAt(LogSite& site, const LogEntry::Level level, const std::string& message,
+                   const std::string& sourceMac) const {
+    if (!isEnabled(level)) {
+        return;
+    }
+    uint32_t hash = LogSite::hash(&level, sizeof(level));
+    hash = LogSite::hash(sourceMac.data(), sourceMac.size(), hash);
+    hash = LogSite::hash(message.data(), message.size(), hash);
+    if (admit(site, level, hash, getTimestampMs())) {
+        log(level, message, sourceMac);
+    }
+}
 
-    auto now = steady_clock::now();
-    auto elapsed = duration_cast<milliseconds>(now - startTime);
+bool Logger::admit(LogSite& site, const LogEntry::Level level, const uint32_t hash,
+                   const uint32_t timestampMs) const {
+    const LogSite::Decision decision = site.check(hash, level, timestampMs);
+    commitCounts(decision, level);
+    return decision.store;
+}
 
-    // Create timestamp with HH:MM:SS.mm format
-    int hours = static_cast<int>(elapsed.count() / (1000 * 60 * 60));
-    int minutes = static_cast<int>((elapsed.count() / (1000 * 60)) % 60);
-    int seconds = static_cast<int>((elapsed.count() / 1000) % 60);
-    int milliseconds = static_cast<int>(elapsed.count() % 1000);
+void Logger::flushSites() const {
+    LogSite::flushAll(getTimestampMs(), [this](const LogSite::Decision& decision) {
+        commitCounts(decision, decision.repeatedLevel);
+    });
+}
 
-    std::ostringstream timestamp;
-    timestamp << std::setfill('0') << std::setw(2) << hours << ":"
-              << std::setfill('0') << std::setw(2) << minutes << ":"
-              << std::setfill('0') << std::setw(2) << seconds << "."
-              << std::setfill('0') << std::setw(2) << milliseconds;
+void Logger::commitCounts(const LogSite::Decision& decision, const LogEntry::Level level) const {
+    if (decision.repeated > 0) {
+        LogEntry::Record record = makeRecord(decision.repeatedLevel, LogEntry::FMT_REPEATED, nullptr);
+        record.args[0] = decision.repeated;
+        commit(record);
+    }
+    if (decision.suppressed > 0) {
+        LogEntry::Record record = makeRecord(level, LogEntry::FMT_RATE_LIMITED, nullptr);
+        record.args[0] = decision.suppressed;
+        commit(record);
+    }
+}
 
-    return timestamp.str();
+// Milliseconds since startTimer(), rendered as text only when the logs are requested
+uint32_t Logger::getTimestampMs() const {
+    using namespace std::chrono;
+
+    const auto elapsed = duration_cast<milliseconds>(steady_clock::now() - startTime);
+    return static_cast<uint32_t>(elapsed.count());
+}
+
+LogEntry::Record Logger::makeRecord(const LogEntry::Level level, const LogEntry::Format format,
+                                    const uint8_t* sourceMac) const {
+    LogEntry::Record record = {};
+    record.timestampMs = getTimestampMs();
+    record.level = level;
+    record.formatId = format;
+    if (sourceMac) {
+        memcpy(record.mac, sourceMac, sizeof(record.mac));
+    }
+    return record;
+}
+
+void Logger::commit(const LogEntry::Record& record) const {
+    LogDatabase::getInstance().addLog(record);
 }
 
 void Logger::setLoggingEnabled(bool enabled) {
     loggingEnabled = enabled;
 }
+
+void Logger::setLogLevel(const LogEntry::Level level) {
+    minimumLevel = level;
+}
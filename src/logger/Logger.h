@@ -12,13 +12,52 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+#include <cstdint>
 #include <string>
 #include "LogEntry.h"
+#include "LogSite.h"
+
+/**
+ * @brief Logging front end for hot paths. The level is checked before the message or any
+ * argument is evaluated, and levels below DEZIBOT_LOG_LEVEL are removed at compile time.
+ * Every call site is rate limited on its own and collapses identical consecutive messages,
+ * see LogSite.
+ * Usage: DEZIBOT_LOG_INFO("Moved for " + std::to_string(ms));
+ */
+#define DEZIBOT_LOG_ENABLED(level) \
+    (LogEntry::isCompiledIn(level) && Logger::getInstance().isEnabled(level))
+
+#define DEZIBOT_LOG_TEXT(level, ...) \
+    do { \
+        if (DEZIBOT_LOG_ENABLED(level)) { \
+            static LogSite dezibotLogSite; \
+            Logger::getInstance().logAt(dezibotLogSite, level, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define DEZIBOT_LOG_INFO(...) DEZIBOT_LOG_TEXT(LogEntry::INFO, __VA_ARGS__)
+#define DEZIBOT_LOG_WARNING(...) DEZIBOT_LOG_TEXT(LogEntry::WARNING, __VA_ARGS__)
+#define DEZIBOT_LOG_ERROR(...) DEZIBOT_LOG_TEXT(LogEntry::ERROR, __VA_ARGS__)
+#define DEZIBOT_LOG_DEBUG(...) DEZIBOT_LOG_TEXT(LogEntry::DEBUG, __VA_ARGS__)
+#define DEZIBOT_LOG_TRACE(...) DEZIBOT_LOG_TEXT(LogEntry::TRACE, __VA_ARGS__)
+
+/**
+ * @brief Same as above for registered formats, see Logger::logFormat().
+ * Usage: DEZIBOT_LOG_FORMAT(LogEntry::INFO, LogEntry::FMT_LIGHT_VALUE, nullptr, sensor, value);
+ */
+#define DEZIBOT_LOG_FORMAT(level, format, sourceMac, ...) \
+    do { \
+        if (DEZIBOT_LOG_ENABLED(level)) { \
+            static LogSite dezibotLogSite; \
+            Logger::getInstance().logFormat(dezibotLogSite, level, format, sourceMac, ##__VA_ARGS__); \
+        } \
+    } while (0)
 
 class Logger {
 public:
     /**
-     * @brief Starts the internal timer used for log entry timestamps.
+     * @brief Starts the internal timer used for log entry timestamps and the task that
+     * moves staged log entries into the log database.
      * @note This should be called once before any logging operations.
      */
     void startTimer();
@@ -59,12 +98,89 @@ public:
      */
     void logTrace(const std::string& message, const std::string& sourceMac = "") const;
 
+    /**
+     * @brief Logs a message using a registered format instead of a prebuilt string.
+     * @details Only the format id and the raw argument values are stored, the message text
+     * is rendered by LogFormatter when a client requests the logs. This does not allocate.
+     * @param level The severity level of the log entry.
+     * @param format The format id, see LogEntry::Format and LogFormatter::formatString().
+     * @param sourceMac MAC address of the device the entry belongs to (6 bytes), or nullptr.
+     * @param args Up to LogEntry::MAX_ARGS numeric format arguments.
+     */
+    template <typename... Args>
+    void logFormat(const LogEntry::Level level, const LogEntry::Format format,
+                   const uint8_t* sourceMac, const Args... args) const {
+        static_assert(sizeof...(Args) <= LogEntry::MAX_ARGS, "too many log arguments");
+        if (!isEnabled(level)) {
+            return;
+        }
+        LogEntry::Record record = makeRecord(level, format, sourceMac);
+        const uint32_t rawArgs[] = {LogEntry::toArg(args)..., 0};
+        memcpy(record.args, rawArgs, sizeof...(Args) * sizeof(uint32_t));
+        commit(record);
+    }
+
+    /**
+     * @brief Logs a message on behalf of a call site, applying its rate limit and
+     * collapsing repeats. Used by the DEZIBOT_LOG_* macros.
+     * @param site state of the calling site.
+     * @param level The severity level of the log entry.
+     * @param message The message to be logged.
+     */
+    void logAt(LogSite& site, LogEntry::Level level, const std::string& message,
+               const std::string& sourceMac = "") const;
+
+    /**
+     * @brief logFormat() on behalf of a call site, see logAt().
+     */
+    template <typename... Args>
+    void logFormat(LogSite& site, const LogEntry::Level level, const LogEntry::Format format,
+                   const uint8_t* sourceMac, const Args... args) const {
+        static_assert(sizeof...(Args) <= LogEntry::MAX_ARGS, "too many log arguments");
+        if (!isEnabled(level)) {
+            return;
+        }
+        LogEntry::Record record = makeRecord(level, format, sourceMac);
+        const uint32_t rawArgs[] = {LogEntry::toArg(args)..., 0};
+        memcpy(record.args, rawArgs, sizeof...(Args) * sizeof(uint32_t));
+        // everything but the timestamp identifies a repeat
+        const uint32_t hash = LogSite::hash(reinterpret_cast<const uint8_t*>(&record) + sizeof(record.timestampMs),
+                                            sizeof(record) - sizeof(record.timestampMs));
+        if (admit(site, level, hash, record.timestampMs)) {
+            commit(record);
+        }
+    }
+
+    /**
+     * @brief Stores the repeat and rate limit counts of call sites that went quiet, see
+     * LogSite::flushAll(). Called by the log drain task.
+     */
+    void flushSites() const;
+
     /**
      * @brief Enables or disables logging globally.
      * @param enabled If true, enables logging; if false, disables all logging.
      */
     void setLoggingEnabled(bool enabled);
 
+    /**
+     * @brief Sets the lowest level that is stored at runtime.
+     * @note Levels below DEZIBOT_LOG_LEVEL stay disabled regardless of this setting.
+     * @param level The least important level that should still be logged.
+     */
+    void setLogLevel(LogEntry::Level level);
+
+    /**
+     * @brief Cheap check whether a message of the given level would be stored.
+     * @param level The severity level to check.
+     * @return true if logging is enabled and level is at or above the runtime and compiled level.
+     */
+    bool isEnabled(const LogEntry::Level level) const {
+        return loggingEnabled
+               && LogEntry::isCompiledIn(level)
+               && LogEntry::severity(level) >= LogEntry::severity(minimumLevel);
+    }
+
 private:
     /**
      * @brief Private constructor to enforce singleton pattern.
@@ -88,12 +204,36 @@ private:
     Logger& operator=(const Logger&) = delete;
 
     /**
-     * @brief Generates a timestamp string based on elapsed time since startTimer() was called.
-     * @return std::string Formatted timestamp in HH:MM:SS.mm format.
+     * @brief Returns the elapsed time since startTimer() was called.
+     * @return uint32_t Elapsed time in milliseconds.
+     */
+    uint32_t getTimestampMs() const;
+
+    /**
+     * @brief Creates a record with timestamp, level, format and source MAC filled in.
+     */
+    LogEntry::Record makeRecord(LogEntry::Level level, LogEntry::Format format, const uint8_t* sourceMac) const;
+
+    /**
+     * @brief Asks site whether a message may be stored and logs the repeat and rate limit
+     * counts it has collected since its last stored message.
+     * @return true if the message itself should be stored.
+     */
+    bool admit(LogSite& site, LogEntry::Level level, uint32_t hash, uint32_t timestampMs) const;
+
+    /**
+     * @brief Logs the repeat and rate limit counts of a LogSite::Decision.
+     * @param level level of the rate limit entry.
+     */
+    void commitCounts(const LogSite::Decision& decision, LogEntry::Level level) const;
+
+    /**
+     * @brief Hands a finished record to the log database.
      */
-    std::string getCurrentTimestamp() const;
+    void commit(const LogEntry::Record& record) const;
 
     bool loggingEnabled = true; ///< Flag controlling whether logging is enabled
+    LogEntry::Level minimumLevel = LogEntry::TRACE; ///< Least important level stored at runtime
 };
 
 #endif // LOGGER_H
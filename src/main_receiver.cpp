@@ -1,7 +1,10 @@
 #include <Arduino.h>
 #include <Dezibot.h>
 #include <WiFi.h>
+#include <new>
+#include <esp_heap_caps.h>
 #include <shared/SenderMap.h>
+#include <shared/TelemetryFrame.h>
 #include <shared/CommandMessage.h>
 #include <shared/CommandSender.h>
 #include <logger/Logger.h>
@@ -10,68 +13,368 @@
 
 Dezibot dezibot;
 
-static std::map<String, SenderInfo> senderMap;
-static SemaphoreHandle_t senderMapMutex = xSemaphoreCreateMutex();
+static DeviceTable deviceTable;
+// both receive workers write to the table; readers never take this, see DeviceTable::read()
+static SemaphoreHandle_t tableWriteMutex = xSemaphoreCreateMutex();
 
-std::map<String, SenderInfo> &getSenderMap() { return senderMap; }
-SemaphoreHandle_t getSenderMapMutex() { return senderMapMutex; }
+DeviceTable &getDeviceTable() { return deviceTable; }
 
 static EspNowReceiverTransport espNowTransport;
 static BleReceiverTransport bleTransport;
 
-static void storeTelemetry(const uint8_t *mac, const SensorMessage &msg, TransportType transport)
+/**
+ * @brief Telemetry histories handed out at once. Each takes about 12 KB of heap, so a large
+ *        swarm cannot have one per sender; a history goes to a sender when its chart asks for
+ *        it, see watchHistory(), and moves on to the next one once that chart is closed.
+ */
+#ifndef TELEMETRY_HISTORY_DEVICES
+#define TELEMETRY_HISTORY_DEVICES 8
+#endif
+
+/**
+ * @brief Heap that has to stay free after a history was allocated, for Wi-Fi, BLE and the
+ *        debug server.
+ */
+#ifndef TELEMETRY_HISTORY_MIN_FREE_HEAP
+#define TELEMETRY_HISTORY_MIN_FREE_HEAP 65536
+#endif
+
+// a history not queried for this long may be handed to another sender; charts poll every second
+#define TELEMETRY_HISTORY_IDLE_MS 10000
+
+// a history and the sender it records, slot is -1 until it is handed out
+struct HistoryLease
+{
+    TelemetryHistory *history;
+    int slot;
+    unsigned long queriedMs;
+};
+
+static HistoryLease historyLeases[TELEMETRY_HISTORY_DEVICES];
+static size_t historiesAllocated = 0;
+
+// the caller holds tableWriteMutex
+static HistoryLease *leaseHistory(unsigned long now)
+{
+    if (historiesAllocated < TELEMETRY_HISTORY_DEVICES
+        && heap_caps_get_free_size(MALLOC_CAP_8BIT) >= sizeof(TelemetryHistory) + TELEMETRY_HISTORY_MIN_FREE_HEAP)
+    {
+        TelemetryHistory *history = new (std::nothrow) TelemetryHistory();
+        if (history != nullptr)
+        {
+            HistoryLease &lease = historyLeases[historiesAllocated++];
+            lease.history = history;
+            lease.slot = -1;
+            return &lease;
+        }
+    }
+
+    HistoryLease *idlest = nullptr;
+    for (size_t i = 0; i < historiesAllocated; i++)
+    {
+        HistoryLease &lease = historyLeases[i];
+        if (now - lease.queriedMs >= TELEMETRY_HISTORY_IDLE_MS
+            && (idlest == nullptr || now - lease.queriedMs > now - idlest->queriedMs))
+            idlest = &lease;
+    }
+    if (idlest == nullptr)
+        return nullptr;
+
+    // histories are never freed, a reader still holding the pointer notices the write and retries
+    if (idlest->slot >= 0)
+    {
+        deviceTable.beginWrite(idlest->slot).history = nullptr;
+        deviceTable.endWrite(idlest->slot);
+    }
+    idlest->history->clear();
+    idlest->slot = -1;
+    return idlest;
+}
+
+bool watchHistory(int slot)
+{
+    const unsigned long now = millis();
+    bool watched = false;
+    xSemaphoreTake(tableWriteMutex, portMAX_DELAY);
+    for (size_t i = 0; i < historiesAllocated && !watched; i++)
+    {
+        if (historyLeases[i].slot == slot)
+        {
+            historyLeases[i].queriedMs = now;
+            watched = true;
+        }
+    }
+
+    HistoryLease *lease = watched ? nullptr : leaseHistory(now);
+    if (lease != nullptr)
+    {
+        lease->slot = slot;
+        lease->queriedMs = now;
+        // recording starts with the values the sender has now, so the chart has a first point
+        SenderInfo &info = deviceTable.beginWrite(slot);
+        info.history = lease->history;
+        info.history->add(info.msg);
+        deviceTable.endWrite(slot);
+        watched = true;
+    }
+    xSemaphoreGive(tableWriteMutex);
+    return watched;
+}
+
+// the caller holds tableWriteMutex; IMU histories are small, every sender that batches gets one while the heap lasts
+static ImuHistory *takeImuHistory()
+{
+    if (heap_caps_get_free_size(MALLOC_CAP_8BIT) < sizeof(ImuHistory) + TELEMETRY_HISTORY_MIN_FREE_HEAP)
+        return nullptr;
+    return new (std::nothrow) ImuHistory();
+}
+
+// a sender beyond DEVICE_TABLE_CAPACITY is not tracked; its frames are dropped, counted and logged
+static void logRefusedSender(const uint8_t *mac)
+{
+    DEZIBOT_LOG_FORMAT(LogEntry::WARNING, LogEntry::FMT_DEVICE_TABLE_FULL, mac,
+                       (uint32_t)DEVICE_TABLE_CAPACITY, deviceTable.getRefused());
+}
+
+// the per-frame log is rate limited per device, one shared call site would let a few
+// chatty senders use up the budget and hide all others
+static LogSite telemetryLogSites[DEVICE_TABLE_CAPACITY];
+static LogSite telemetryLogOverflow;
+
+static void storeTelemetry(const uint8_t *mac, const SensorMessage &msg, uint8_t groups, TransportType transport)
+{
+    xSemaphoreTake(tableWriteMutex, portMAX_DELAY);
+    int slot = deviceTable.insert(DeviceTable::packMac(mac));
+    if (slot >= 0)
+    {
+        // groups that were not sent keep their last received values, late frames are only counted
+        const unsigned long now = millis();
+        SenderInfo &info = deviceTable.beginWrite(slot);
+        if (info.link.track(msg.counter, msg.uptimeMs))
+        {
+            TelemetryFrame::merge(info.msg, msg, groups);
+            // only senders whose chart is open have a history, see watchHistory()
+            if (info.history != nullptr)
+                info.history->add(info.msg);
+        }
+        info.lastSeenMs = now;
+        info.transport = transport;
+        deviceTable.endWrite(slot);
+    }
+    xSemaphoreGive(tableWriteMutex);
+    if (slot < 0)
+        logRefusedSender(mac);
+
+    if (DEZIBOT_LOG_ENABLED(LogEntry::INFO))
+    {
+        LogSite &site = slot >= 0 ? telemetryLogSites[slot] : telemetryLogOverflow;
+        Logger::getInstance().logFormat(site, LogEntry::INFO,
+                                        transport == TRANSPORT_BLE ? LogEntry::FMT_TELEMETRY_BLE : LogEntry::FMT_TELEMETRY_ESPNOW,
+                                        mac, msg.counter, msg.uptimeMs);
+    }
+}
+
+static void storeImuBatch(const uint8_t *mac, const ImuBatch &batch, TransportType transport)
 {
-    char macStr[18];
-    snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    if (batch.count == 0)
+        return;
 
-    if (xSemaphoreTake(senderMapMutex, pdMS_TO_TICKS(10)) == pdTRUE)
+    xSemaphoreTake(tableWriteMutex, portMAX_DELAY);
+    int slot = deviceTable.insert(DeviceTable::packMac(mac));
+    if (slot >= 0)
     {
-        SenderInfo &info = senderMap[String(macStr)];
-        info.msg = msg;
+        SenderInfo &info = deviceTable.beginWrite(slot);
+        info.imuLink.track(batch.counter, batch.uptimeMs);
+        if (info.imu == nullptr)
+            info.imu = takeImuHistory();
+        if (info.imu != nullptr)
+            info.imu->add(batch);
+
+        // the live values follow the newest sample
+        const ImuSample &newest = batch.samples[batch.count - 1];
+        info.msg.accelX = newest.accelX;
+        info.msg.accelY = newest.accelY;
+        info.msg.accelZ = newest.accelZ;
+        info.msg.gyroX = newest.gyroX;
+        info.msg.gyroY = newest.gyroY;
+        info.msg.gyroZ = newest.gyroZ;
         info.lastSeenMs = millis();
         info.transport = transport;
-        xSemaphoreGive(senderMapMutex);
+        deviceTable.endWrite(slot);
     }
+    xSemaphoreGive(tableWriteMutex);
+    if (slot < 0)
+        logRefusedSender(mac);
+}
 
-    char logBuf[128];
-    snprintf(logBuf, sizeof(logBuf), "Telemetry from %s [%s]: counter=%lu uptime=%lu",
-             macStr, transport == TRANSPORT_BLE ? "BLE" : "ESP-NOW",
-             (unsigned long)msg.counter, (unsigned long)msg.uptimeMs);
-    Logger::getInstance().logInfo(std::string(logBuf), std::string(macStr));
+static void countCrcError(const uint8_t *mac)
+{
+    xSemaphoreTake(tableWriteMutex, portMAX_DELAY);
+    // a corrupted frame alone does not make an unknown device appear in the swarm
+    int slot = deviceTable.find(DeviceTable::packMac(mac));
+    if (slot >= 0)
+    {
+        deviceTable.beginWrite(slot).link.crcErrors++;
+        deviceTable.endWrite(slot);
+    }
+    xSemaphoreGive(tableWriteMutex);
 }
 
-static void onEspNowTelemetry(const uint8_t *mac, const SensorMessage &msg)
+static void onEspNowTelemetry(const uint8_t *mac, const SensorMessage &msg, uint8_t groups)
 {
-    storeTelemetry(mac, msg, TRANSPORT_ESPNOW);
+    storeTelemetry(mac, msg, groups, TRANSPORT_ESPNOW);
 }
 
-static void onBleTelemetry(const uint8_t *mac, const SensorMessage &msg)
+static void onBleTelemetry(const uint8_t *mac, const SensorMessage &msg, uint8_t groups)
 {
-    storeTelemetry(mac, msg, TRANSPORT_BLE);
+    storeTelemetry(mac, msg, groups, TRANSPORT_BLE);
 }
 
-bool sendCommandToDevice(const uint8_t *mac, uint8_t command)
+static void onEspNowImuBatch(const uint8_t *mac, const ImuBatch &batch)
 {
-    char macStr[18];
-    snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-             mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    storeImuBatch(mac, batch, TRANSPORT_ESPNOW);
+}
 
+static void onBleImuBatch(const uint8_t *mac, const ImuBatch &batch)
+{
+    storeImuBatch(mac, batch, TRANSPORT_BLE);
+}
+
+bool sendCommandToDevice(const uint8_t *mac, uint8_t command, CommandResult &result)
+{
     TransportType transport = TRANSPORT_ESPNOW;
-    if (xSemaphoreTake(senderMapMutex, pdMS_TO_TICKS(10)) == pdTRUE)
-    {
-        auto it = senderMap.find(String(macStr));
-        if (it != senderMap.end())
-            transport = it->second.transport;
-        xSemaphoreGive(senderMapMutex);
-    }
+    int slot = deviceTable.find(DeviceTable::packMac(mac));
+    if (slot >= 0)
+        deviceTable.read(slot, [&transport](const SenderInfo &info)
+                         { transport = info.transport; });
 
-    Serial.printf("sendCommand: %s via %s\n", macStr, transport == TRANSPORT_BLE ? "BLE" : "ESP-NOW");
+    Serial.printf("sendCommand: %02X:%02X:%02X:%02X:%02X:%02X via %s\n",
+                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], transport == TRANSPORT_BLE ? "BLE" : "ESP-NOW");
 
     if (transport == TRANSPORT_BLE)
-        return bleTransport.sendCommand(mac, command);
+        return bleTransport.sendCommand(mac, command, result);
     else
-        return espNowTransport.sendCommand(mac, command);
+        return espNowTransport.sendCommand(mac, command, result);
+}
+
+bool getCommandPeerStats(PeerStats &stats)
+{
+    stats = espNowTransport.getPeerStats();
+    return true;
+}
+
+// a sender heard from within this time is expected to acknowledge a broadcast command
+#define COMMAND_ONLINE_MS 5000
+
+// the part of a group command sent over one transport
+struct GroupCommandJob
+{
+    ReceiverTransport *transport = nullptr;
+    const CommandTarget *target = nullptr;
+    uint8_t command = 0;
+    const std::vector<uint64_t> *expected = nullptr;
+    GroupCommandResult result;
+    SemaphoreHandle_t done = nullptr; ///< Given when groupCommandTask() finished
+};
+
+static void runGroupCommand(GroupCommandJob &job)
+{
+    job.transport->sendGroupCommand(*job.target, job.command, *job.expected, job.result);
+}
+
+static void groupCommandTask(void *param)
+{
+    GroupCommandJob *job = (GroupCommandJob *)param;
+    runGroupCommand(*job);
+    xSemaphoreGive(job->done);
+    vTaskDelete(NULL);
+}
+
+bool sendCommandToGroup(const CommandTarget &target, uint8_t command, GroupCommandResult &result)
+{
+    // each transport addresses and waits for the senders last heard on it
+    CommandTarget targets[2] = {target, target};
+    std::vector<uint64_t> expected[2];
+    if (target.type == TARGET_MACS)
+    {
+        targets[TRANSPORT_ESPNOW].macs.clear();
+        targets[TRANSPORT_BLE].macs.clear();
+        for (uint64_t mac : target.macs)
+        {
+            TransportType transport = TRANSPORT_ESPNOW;
+            int slot = deviceTable.find(mac);
+            if (slot >= 0)
+                deviceTable.read(slot, [&transport](const SenderInfo &info)
+                                 { transport = info.transport; });
+            targets[transport].macs.push_back(mac);
+            expected[transport].push_back(mac);
+        }
+    }
+    else if (target.type == TARGET_ALL)
+    {
+        const unsigned long now = millis();
+        for (size_t slot = 0; slot < deviceTable.size(); slot++)
+        {
+            unsigned long lastSeenMs = 0;
+            TransportType transport = TRANSPORT_ESPNOW;
+            deviceTable.read(slot, [&lastSeenMs, &transport](const SenderInfo &info)
+                             {
+                                 lastSeenMs = info.lastSeenMs;
+                                 transport = info.transport;
+                             });
+            if (now - lastSeenMs < COMMAND_ONLINE_MS)
+                expected[transport].push_back(deviceTable.macAt(slot));
+        }
+    }
+    // group membership is only known to the senders, nobody in particular is expected
+
+    result = GroupCommandResult();
+    ReceiverTransport *transports[2] = {&espNowTransport, &bleTransport};
+    GroupCommandJob jobs[2];
+    for (size_t transport = 0; transport < 2; transport++)
+    {
+        jobs[transport].transport = transports[transport];
+        jobs[transport].target = &targets[transport];
+        jobs[transport].command = command;
+        jobs[transport].expected = &expected[transport];
+    }
+    const bool useBle = target.type != TARGET_MACS || !targets[TRANSPORT_BLE].macs.empty();
+    const bool useEspNow = target.type != TARGET_MACS || !targets[TRANSPORT_ESPNOW].macs.empty();
+
+    // BLE retries take as long as ESP-NOW ones, both transports wait for their senders at once
+    GroupCommandJob &bleJob = jobs[TRANSPORT_BLE];
+    bool bleInline = false;
+    if (useBle)
+    {
+        bleJob.done = xSemaphoreCreateBinary();
+        bleInline = !bleJob.done ||
+                    xTaskCreatePinnedToCore(groupCommandTask, "group_cmd", 4096, &bleJob, 4, NULL, 1) != pdPASS;
+    }
+    if (useEspNow)
+        runGroupCommand(jobs[TRANSPORT_ESPNOW]);
+    if (bleInline)
+        runGroupCommand(bleJob);
+    else if (useBle)
+        xSemaphoreTake(bleJob.done, portMAX_DELAY);
+    if (bleJob.done)
+        vSemaphoreDelete(bleJob.done);
+
+    for (size_t transport = 0; transport < 2; transport++)
+    {
+        const GroupCommandResult &part = jobs[transport].result;
+        if (part.attempts > result.attempts)
+            result.attempts = part.attempts;
+        if (part.totalUs > result.totalUs)
+            result.totalUs = part.totalUs;
+        result.acked.insert(result.acked.end(), part.acked.begin(), part.acked.end());
+        result.missing.insert(result.missing.end(), part.missing.begin(), part.missing.end());
+    }
+    result.espNowUs = jobs[TRANSPORT_ESPNOW].result.totalUs;
+    result.bleUs = jobs[TRANSPORT_BLE].result.totalUs;
+
+    DEZIBOT_LOG_FORMAT(LogEntry::INFO, LogEntry::FMT_GROUP_COMMAND, nullptr,
+                       command, (uint32_t)result.acked.size(), (uint32_t)result.missing.size());
+    return result.missing.empty() && !result.acked.empty();
 }
 
 int i = 0;
@@ -82,9 +385,13 @@ void setup()
     dezibot.debugServer.setup();
 
     espNowTransport.setTelemetryCallback(onEspNowTelemetry);
+    espNowTransport.setImuBatchCallback(onEspNowImuBatch);
+    espNowTransport.setCrcErrorCallback(countCrcError);
     espNowTransport.begin();
 
     bleTransport.setTelemetryCallback(onBleTelemetry);
+    bleTransport.setImuBatchCallback(onBleImuBatch);
+    bleTransport.setCrcErrorCallback(countCrcError);
     bleTransport.begin();
 
     Serial.print("MAC: ");
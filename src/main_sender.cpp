@@ -4,6 +4,7 @@
 #include <driver/temp_sensor.h>
 #include <freertos/queue.h>
 #include <shared/SensorMessage.h>
+#include <shared/TelemetryFrame.h>
 #include <shared/CommandMessage.h>
 #include <transport/SenderTransport.h>
 #include <transport/EspNowSenderTransport.h>
@@ -13,6 +14,24 @@
 
 Dezibot dezibot;
 
+// frames between two transmissions of the slowly changing groups
+#define SYSTEM_GROUP_INTERVAL 5
+#define INFO_GROUP_INTERVAL 30
+
+// IMU samples sent together in one batch frame, 0 disables batching
+#define IMU_BATCH_SAMPLES 10
+#define IMU_SAMPLE_INTERVAL_MS 40 // 25 Hz
+
+// print the transmit counters every 2 s, for tuning the rate controller
+#ifndef TX_STATS_LOG
+#define TX_STATS_LOG 0
+#endif
+
+// groups this bot answers to, one bit each, see /command/batch?groups=
+#ifndef SWARM_GROUPS
+#define SWARM_GROUPS 0x01
+#endif
+
 static SenderTransport *transport = nullptr;
 static uint32_t counter = 0;
 static QueueHandle_t commandQueue = nullptr;
@@ -65,67 +84,128 @@ static uint16_t estimatePowerMw(const SensorMessage &m)
     return total;
 }
 
-static void telemetryTask(void *param)
+static void sendTelemetry()
 {
-    while (true)
-    {
-        SensorMessage msg = {};
-        msg.magic = MSG_MAGIC;
-        msg.counter = counter;
-        msg.uptimeMs = millis();
-
-        msg.ambientLight = dezibot.colorDetection.getAmbientLight();
-        msg.colorR = dezibot.colorDetection.getColorValue(VEML_RED);
-        msg.colorG = dezibot.colorDetection.getColorValue(VEML_GREEN);
-        msg.colorB = dezibot.colorDetection.getColorValue(VEML_BLUE);
-        msg.colorW = dezibot.colorDetection.getColorValue(VEML_WHITE);
-
-        msg.irFront = LightDetection::getValue(IR_FRONT);
-        msg.irLeft = LightDetection::getValue(IR_LEFT);
-        msg.irRight = LightDetection::getValue(IR_RIGHT);
-        msg.irBack = LightDetection::getValue(IR_BACK);
-        msg.dlBottom = LightDetection::getValue(DL_BOTTOM);
-        msg.dlFront = LightDetection::getValue(DL_FRONT);
-
-        msg.motorLeft = Motion::left.getSpeed();
-        msg.motorRight = Motion::right.getSpeed();
-
-        IMUResult accel = Motion::detection.getAcceleration();
-        msg.accelX = accel.x;
-        msg.accelY = accel.y;
-        msg.accelZ = accel.z;
-
-        IMUResult gyro = Motion::detection.getRotation();
-        msg.gyroX = gyro.x;
-        msg.gyroY = gyro.y;
-        msg.gyroZ = gyro.z;
-
-        msg.temperature = Motion::detection.getTemperature();
+    SensorMessage msg = {};
+    msg.magic = MSG_MAGIC;
+    msg.counter = counter;
+    msg.uptimeMs = millis();
+
+    // only sampled groups are transmitted, the receiver keeps the last values of the others
+    uint8_t groups = GROUP_COLOR | GROUP_IR | GROUP_MOTOR | GROUP_IMU | GROUP_POWER;
+    if (counter % SYSTEM_GROUP_INTERVAL == 0)
+        groups |= GROUP_SYSTEM;
+    if (counter % INFO_GROUP_INTERVAL == 0)
+        groups |= GROUP_INFO;
+
+    msg.ambientLight = dezibot.colorDetection.getAmbientLight();
+    msg.colorR = dezibot.colorDetection.getColorValue(VEML_RED);
+    msg.colorG = dezibot.colorDetection.getColorValue(VEML_GREEN);
+    msg.colorB = dezibot.colorDetection.getColorValue(VEML_BLUE);
+    msg.colorW = dezibot.colorDetection.getColorValue(VEML_WHITE);
+
+    msg.irFront = LightDetection::getValue(IR_FRONT);
+    msg.irLeft = LightDetection::getValue(IR_LEFT);
+    msg.irRight = LightDetection::getValue(IR_RIGHT);
+    msg.irBack = LightDetection::getValue(IR_BACK);
+    msg.dlBottom = LightDetection::getValue(DL_BOTTOM);
+    msg.dlFront = LightDetection::getValue(DL_FRONT);
+
+    msg.motorLeft = Motion::left.getSpeed();
+    msg.motorRight = Motion::right.getSpeed();
+
+    IMUResult accel = Motion::detection.getAcceleration();
+    msg.accelX = accel.x;
+    msg.accelY = accel.y;
+    msg.accelZ = accel.z;
+
+    IMUResult gyro = Motion::detection.getRotation();
+    msg.gyroX = gyro.x;
+    msg.gyroY = gyro.y;
+    msg.gyroZ = gyro.z;
+
+    msg.temperature = Motion::detection.getTemperature();
+    if (groups & GROUP_INFO)
         msg.whoAmI = Motion::detection.getWhoAmI();
 
-        Orientation tilt = Motion::detection.getTilt();
-        if (tilt.xRotation == INT_MAX && tilt.yRotation == INT_MAX)
-        {
-            tilt.xRotation = 0;
-            tilt.yRotation = 0;
-        }
-        msg.tiltX = tilt.xRotation;
-        msg.tiltY = tilt.yRotation;
-        msg.tiltDirection = (uint8_t)Motion::detection.getTiltDirection();
+    Orientation tilt = Motion::detection.getTilt();
+    if (tilt.xRotation == INT_MAX && tilt.yRotation == INT_MAX)
+    {
+        tilt.xRotation = 0;
+        tilt.yRotation = 0;
+    }
+    msg.tiltX = tilt.xRotation;
+    msg.tiltY = tilt.yRotation;
+    msg.tiltDirection = (uint8_t)Motion::detection.getTiltDirection();
 
+    if (groups & GROUP_SYSTEM)
+    {
         msg.freeHeap = esp_get_free_heap_size();
         msg.minFreeHeap = esp_get_minimum_free_heap_size();
         msg.taskCount = (uint8_t)uxTaskGetNumberOfTasks();
         float chipTemp = 0.0f;
         temp_sensor_read_celsius(&chipTemp);
         msg.chipTemp = chipTemp;
+    }
+
+    msg.estimatedPowerMw = estimatePowerMw(msg);
+
+    transport->sendTelemetry(msg, groups);
+    counter++;
+}
+
+static void sampleImu(ImuBatch &batch)
+{
+    uint32_t now = millis();
+    if (batch.count == 0)
+        batch.uptimeMs = now;
 
-        msg.estimatedPowerMw = estimatePowerMw(msg);
+    ImuSample &sample = batch.samples[batch.count++];
+    sample.offsetMs = (uint16_t)(now - batch.uptimeMs);
 
-        transport->sendTelemetry(msg);
-        counter++;
+    IMUResult accel = Motion::detection.getAcceleration();
+    sample.accelX = accel.x;
+    sample.accelY = accel.y;
+    sample.accelZ = accel.z;
 
-        vTaskDelay(pdMS_TO_TICKS(1000));
+    IMUResult gyro = Motion::detection.getRotation();
+    sample.gyroX = gyro.x;
+    sample.gyroY = gyro.y;
+    sample.gyroZ = gyro.z;
+
+    if (batch.count >= IMU_BATCH_SAMPLES || batch.count >= IMU_BATCH_MAX_SAMPLES)
+    {
+        // not rate limited, a batch is due every IMU_BATCH_SAMPLES samples
+        transport->sendImuBatch(batch);
+        batch.counter++;
+        batch.count = 0;
+    }
+}
+
+// one task samples everything, so the IMU and the transport are never used concurrently
+static void telemetryTask(void *param)
+{
+    ImuBatch batch = {};
+    uint32_t intervalMs = TELEMETRY_INTERVAL_MS;
+    uint32_t lastTelemetryMs = millis() - intervalMs;
+    TickType_t lastWake = xTaskGetTickCount();
+    // without batching the task wakes at the fastest telemetry rate and checks whether a frame is due
+    const TickType_t period = pdMS_TO_TICKS(IMU_BATCH_SAMPLES > 0 ? IMU_SAMPLE_INTERVAL_MS : TELEMETRY_MIN_INTERVAL_MS);
+
+    while (true)
+    {
+        if (IMU_BATCH_SAMPLES > 0)
+            sampleImu(batch);
+
+        if (millis() - lastTelemetryMs >= intervalMs)
+        {
+            lastTelemetryMs += intervalMs;
+            sendTelemetry();
+            // the rate controller backs off when the channel is busy
+            intervalMs = transport->nextTelemetryIntervalMs();
+        }
+
+        vTaskDelayUntil(&lastWake, period);
     }
 }
 
@@ -152,6 +232,7 @@ void setup()
 
     Serial.println("Setup: transport created, setting callback...");
 
+    transport->setGroups(SWARM_GROUPS);
     transport->setCommandCallback([](const CommandMessage &cmd)
                                   {
         if (xQueueSend(commandQueue, &cmd, 0) != pdTRUE)
@@ -178,4 +259,15 @@ void setup()
 void loop()
 {
     delay(2000);
+
+#if TX_STATS_LOG
+    if (transport)
+    {
+        const TxStats tx = transport->getTxStats();
+        Serial.printf("TX: queued=%u sent=%u failed=%u dropped=%u acks=%u latency=%u/%u/%u us (last/mean/max)\n",
+                      tx.queued, tx.sent, tx.failed, tx.dropped, tx.acks, tx.lastLatencyUs, tx.meanLatencyUs, tx.maxLatencyUs);
+        Serial.printf("TX: telemetry interval=%u ms, backoffs=%u\n",
+                      transport->getTelemetryIntervalMs(), transport->getRateBackoffs());
+    }
+#endif
 }
@@ -30,7 +30,7 @@ void Motion::begin(void) {
     Motion::right.begin();
     detection.begin();
 
-    Logger::getInstance().logTrace("Successfully started Motion module");
+    DEZIBOT_LOG_TRACE("Successfully started Motion module");
 };
 void Motion::moveTask(void * args) {
     uint32_t runtime = (uint32_t)args;
@@ -91,7 +91,7 @@ void Motion::moveTask(void * args) {
 
 // Move forward for a certain amount of time.
 void Motion::move(uint32_t moveForMs, uint baseValue) {
-    Logger::getInstance().logInfo("Move for " + std::to_string(moveForMs));
+    DEZIBOT_LOG_INFO("Move for " + std::to_string(moveForMs));
 
        if(xMoveTaskHandle){
             vTaskDelete(xMoveTaskHandle);
@@ -140,7 +140,7 @@ void Motion::leftMotorTask(void * args) {
 
 // Rotate clockwise for a certain amount of time.
 void Motion::rotateClockwise(uint32_t rotateForMs,uint baseValue) {
-    Logger::getInstance().logInfo("Rotate Clockwise for " + std::to_string(rotateForMs));
+    DEZIBOT_LOG_INFO("Rotate Clockwise for " + std::to_string(rotateForMs));
 
     LEFT_MOTOR_DUTY = baseValue;
     RIGHT_MOTOR_DUTY = baseValue;
@@ -182,7 +182,7 @@ void Motion::rightMotorTask(void * args) {
 // Rotate anticlockwise for a certain amount of time.
 void Motion::rotateAntiClockwise(uint32_t rotateForMs,uint baseValue) {
     // I took the liberty to rename this in the logs
-    Logger::getInstance().logInfo("Rotate CounterClockwise for " + std::to_string(rotateForMs));
+    DEZIBOT_LOG_INFO("Rotate CounterClockwise for " + std::to_string(rotateForMs));
 
     LEFT_MOTOR_DUTY = baseValue;
     RIGHT_MOTOR_DUTY = baseValue;
@@ -198,7 +198,7 @@ void Motion::rotateAntiClockwise(uint32_t rotateForMs,uint baseValue) {
 };
 
 void Motion::stop(void){
-    Logger::getInstance().logInfo("Motion stopped");
+    DEZIBOT_LOG_INFO("Motion stopped");
 
     if(xMoveTaskHandle){
         vTaskDelete(xMoveTaskHandle);
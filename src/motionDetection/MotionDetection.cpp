@@ -24,7 +24,7 @@ void MotionDetection::begin(void){
     this->initFIFO();
     this->stopFIFO();
 
-    Logger::getInstance().logTrace("Successfully started MotionDetection module");
+    DEZIBOT_LOG_TRACE("Successfully started MotionDetection module");
 };
 void MotionDetection::end(void){
     this->writeRegister(PWR_MGMT0,0x00);
@@ -131,12 +131,7 @@ Orientation MotionDetection::getTilt(){
 
     Orientation result = Orientation{xAngle,yAngle};
 
-    Logger::getInstance().logInfo(
-        "Getting tilt with values: x= "
-        + std::to_string(result.xRotation)
-        + " y= "
-        + std::to_string(result.yRotation)
-    );
+    DEZIBOT_LOG_FORMAT(LogEntry::INFO, LogEntry::FMT_TILT, nullptr, result.xRotation, result.yRotation);
 
     startFIFO();
 
@@ -179,10 +174,7 @@ Direction MotionDetection::getTiltDirection(uint tolerance){
 
     }
 
-    Logger::getInstance().logInfo(
-        "Getting tilt direction with value "
-        + result
-    );
+    DEZIBOT_LOG_FORMAT(LogEntry::INFO, LogEntry::FMT_TILT_DIRECTION, nullptr, result);
 
     return result;
 };
@@ -10,12 +10,12 @@ void MultiColorLight::begin(void){
     rgbLeds.begin();
     this->turnOffLed();
 
-    Logger::getInstance().logTrace("Successfully started MultiColorLight module");
+    DEZIBOT_LOG_TRACE("Successfully started MultiColorLight module");
 };
 
 void MultiColorLight::setLed(uint8_t index , uint32_t color){
     if (index > ledAmount-1){
-        Logger::getInstance().logError("MultiColorLight index out of range");
+        DEZIBOT_LOG_ERROR("MultiColorLight index out of range");
     }
     rgbLeds.setPixelColor(index, normalizeColor(color));
     rgbLeds.show();
@@ -23,12 +23,7 @@ void MultiColorLight::setLed(uint8_t index , uint32_t color){
 
 
 void MultiColorLight::setLed(leds leds, uint32_t color){
-    Logger::getInstance().logInfo(
-        "Setting LED "
-        + std::to_string(leds)
-        + " to color value: "
-        + std::to_string(color)
-    );
+    DEZIBOT_LOG_FORMAT(LogEntry::INFO, LogEntry::FMT_LED_COLOR, nullptr, leds, color);
     switch (leds){
         case TOP_LEFT:
             MultiColorLight::setLed(1,color);break;
@@ -45,7 +40,7 @@ void MultiColorLight::setLed(leds leds, uint32_t color){
                 MultiColorLight::setLed(index,color);
             }break;
         default:
-            Logger::getInstance().logWarning(
+            DEZIBOT_LOG_WARNING(
                 "MultiColorLight.setLed() could not set color to LED as the provided LED is unknown"
             );
             break;
@@ -54,7 +49,7 @@ void MultiColorLight::setLed(leds leds, uint32_t color){
 };
 
 void MultiColorLight::setLed(leds leds, uint8_t red, uint8_t green, uint8_t blue){
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Setting LED "
         + std::to_string(leds)
         + "to RGB value: ("
@@ -69,27 +64,17 @@ void MultiColorLight::setLed(leds leds, uint8_t red, uint8_t green, uint8_t blue
 
 
 void MultiColorLight::setTopLeds(uint32_t color){
-    Logger::getInstance().logInfo(
-        "Setting Top LED to color value: "
-        + std::to_string(color)
-    );
+    DEZIBOT_LOG_FORMAT(LogEntry::INFO, LogEntry::FMT_TOP_LED_COLOR, nullptr, color);
     MultiColorLight::setLed(TOP,color);
 }; 
 
 void MultiColorLight::setTopLeds(uint8_t red, uint8_t green, uint8_t blue){
-    Logger::getInstance().logInfo(
-        "Setting Top LED to RGB value: ("
-        + std::to_string(red)
-        + ", "
-        + std::to_string(green)
-        + ", "
-        + std::to_string(blue)
-    );
+    DEZIBOT_LOG_FORMAT(LogEntry::INFO, LogEntry::FMT_TOP_LED_RGB, nullptr, red, green, blue);
     MultiColorLight::setTopLeds(MultiColorLight::color(red,green,blue));
 }; 
 
 void MultiColorLight::blink(uint16_t amount,uint32_t color, leds leds, uint32_t interval){
-    Logger::getInstance().logInfo(
+    DEZIBOT_LOG_INFO(
         "Set blinking with values: Amount: "
         + std::to_string(amount)
         + " Color: "
@@ -124,7 +109,7 @@ void MultiColorLight::turnOffLed(leds leds){
                 MultiColorLight::setLed(index,0);
             }break;
         default:
-            Logger::getInstance().logError("MultiColorLight.turnOffLed() invalid leds");
+            DEZIBOT_LOG_ERROR("MultiColorLight.turnOffLed() invalid leds");
             break;
     }
 };
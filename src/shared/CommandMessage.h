@@ -4,6 +4,11 @@
 #include <stdint.h>
 
 #define CMD_MAGIC 0xDE22
+#define CMD_ACK_MAGIC 0xDE26
+#define CMD_GROUP_MAGIC 0xDE27
+
+// MACs that fit into one group command frame, ESP-NOW carries at most 250 bytes
+#define CMD_GROUP_MAX_MACS 40
 
 enum CommandType : uint8_t {
     CMD_LOCATE = 0x01,
@@ -11,9 +16,38 @@ enum CommandType : uint8_t {
     CMD_STOP = 0x03,
 };
 
+// seq is chosen by the receiver and repeated unchanged on every retransmission
 typedef struct {
     uint16_t magic;
     uint8_t  command;
+    uint16_t seq;
+    uint16_t crc; // CRC-16 of the bytes before it, see Crc16.h
 } __attribute__((packed)) CommandMessage;
 
+enum CommandTargetType : uint8_t {
+    TARGET_ALL = 0x00,    // every sender that hears the frame
+    TARGET_GROUPS = 0x01, // senders sharing a bit with groups, see SenderTransport::setGroups()
+    TARGET_MACS = 0x02,   // senders listed in the frame
+};
+
+// one command for many senders, each sender decides from the target whether it is addressed;
+// followed by macCount MAC addresses of 6 bytes and the CRC-16 of everything before it
+typedef struct {
+    uint16_t magic;
+    uint8_t  command;
+    uint16_t seq;
+    uint8_t  target; // CommandTargetType
+    uint8_t  groups;
+    uint8_t  macCount;
+} __attribute__((packed)) GroupCommandHeader;
+
+#define CMD_GROUP_MAX_FRAME (sizeof(GroupCommandHeader) + CMD_GROUP_MAX_MACS * 6 + 2)
+
+// sent back by a sender for every valid command, duplicates included
+typedef struct {
+    uint16_t magic;
+    uint16_t seq;
+    uint16_t crc; // CRC-16 of the bytes before it
+} __attribute__((packed)) CommandAck;
+
 #endif
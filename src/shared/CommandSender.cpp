@@ -1,5 +1,13 @@
 #include "CommandSender.h"
 
-__attribute__((weak)) bool sendCommandToDevice(const uint8_t *mac, uint8_t command) {
+__attribute__((weak)) bool sendCommandToDevice(const uint8_t *mac, uint8_t command, CommandResult &result) {
+    return false;
+}
+
+__attribute__((weak)) bool sendCommandToGroup(const CommandTarget &target, uint8_t command, GroupCommandResult &result) {
+    return false;
+}
+
+__attribute__((weak)) bool getCommandPeerStats(PeerStats &stats) {
     return false;
 }
@@ -2,7 +2,40 @@
 #define COMMAND_SENDER_H
 
 #include <stdint.h>
+#include <vector>
 
-bool sendCommandToDevice(const uint8_t *mac, uint8_t command);
+struct PeerStats;
+
+// outcome of a command that is retransmitted until the device acknowledges it
+struct CommandResult {
+    bool acked = false;
+    uint8_t attempts = 0;
+    uint32_t rttUs = 0;   // from the last transmission before the ACK to the ACK
+    uint32_t totalUs = 0; // from the first transmission to the ACK or giving up
+};
+
+// addressees of a group command, see GroupCommandHeader
+struct CommandTarget {
+    uint8_t type = 0;           // CommandTargetType
+    uint8_t groups = 0;         // for TARGET_GROUPS
+    std::vector<uint64_t> macs; // for TARGET_MACS, packed like DeviceTable::packMac()
+};
+
+// outcome of a group command, retransmitted until every expected sender acknowledged it
+struct GroupCommandResult {
+    uint8_t attempts = 0;
+    uint32_t totalUs = 0;  // until the slowest transport finished
+    uint32_t espNowUs = 0; // time each transport took, 0 if it was not used
+    uint32_t bleUs = 0;
+    std::vector<uint64_t> acked;
+    std::vector<uint64_t> missing; // expected senders that never acknowledged
+};
+
+bool sendCommandToDevice(const uint8_t *mac, uint8_t command, CommandResult &result);
+
+bool sendCommandToGroup(const CommandTarget &target, uint8_t command, GroupCommandResult &result);
+
+// peer table of the ESP-NOW command path, false if there is none
+bool getCommandPeerStats(PeerStats &stats);
 
 #endif
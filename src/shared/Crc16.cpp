@@ -0,0 +1,18 @@
+#include "Crc16.h"
+
+// one entry per nibble keeps the table at 32 bytes
+static const uint16_t CRC16_TABLE[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+};
+
+uint16_t crc16(const uint8_t *data, size_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++)
+    {
+        crc = (uint16_t)(crc << 4) ^ CRC16_TABLE[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (uint16_t)(crc << 4) ^ CRC16_TABLE[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
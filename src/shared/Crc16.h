@@ -0,0 +1,26 @@
+/**
+ * @file Crc16.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief CRC-16/CCITT-FALSE checksum used as trailer of telemetry and command frames.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef CRC16_H
+#define CRC16_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Compute the CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF) of a buffer.
+ * @param data Bytes to check.
+ * @param length Number of bytes.
+ * @return uint16_t
+ */
+uint16_t crc16(const uint8_t *data, size_t length);
+
+#endif
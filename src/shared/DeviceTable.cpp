@@ -0,0 +1,92 @@
+#include "DeviceTable.h"
+#include <stdio.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define DEVICE_TABLE_BUCKETS (2 * DEVICE_TABLE_CAPACITY)
+
+size_t DeviceTable::home(uint64_t mac)
+{
+    return (size_t)((mac * 0x9E3779B97F4A7C15ULL) >> 40) & (DEVICE_TABLE_BUCKETS - 1);
+}
+
+int DeviceTable::find(uint64_t mac) const
+{
+    for (size_t bucket = home(mac);; bucket = (bucket + 1) & (DEVICE_TABLE_BUCKETS - 1))
+    {
+        const uint16_t entry = buckets[bucket].load(std::memory_order_acquire);
+        if (entry == 0)
+            return -1;
+        if (keys[entry - 1] == mac)
+            return entry - 1;
+    }
+}
+
+int DeviceTable::insert(uint64_t mac)
+{
+    size_t bucket = home(mac);
+    for (;; bucket = (bucket + 1) & (DEVICE_TABLE_BUCKETS - 1))
+    {
+        const uint16_t entry = buckets[bucket].load(std::memory_order_relaxed);
+        if (entry == 0)
+            break;
+        if (keys[entry - 1] == mac)
+            return entry - 1;
+    }
+
+    // the index is never more than half full, so the probe above always ends
+    const size_t used = count.load(std::memory_order_relaxed);
+    if (used >= DEVICE_TABLE_CAPACITY)
+    {
+        refused.store(refused.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return -1;
+    }
+
+    // fill the slot first, readers only see it once the bucket and the count are published
+    const int slot = (int)used;
+    keys[slot] = mac;
+    entries[slot] = SenderInfo();
+    buckets[bucket].store((uint16_t)(slot + 1), std::memory_order_release);
+    count.store(used + 1, std::memory_order_release);
+    return slot;
+}
+
+void DeviceTable::waitForWriter()
+{
+    vTaskDelay(1);
+}
+
+uint64_t DeviceTable::packMac(const uint8_t *mac)
+{
+    uint64_t packed = 0;
+    for (int i = 0; i < 6; i++)
+        packed = (packed << 8) | mac[i];
+    return packed;
+}
+
+void DeviceTable::unpackMac(uint64_t mac, uint8_t *out)
+{
+    for (int i = 5; i >= 0; i--)
+    {
+        out[i] = (uint8_t)mac;
+        mac >>= 8;
+    }
+}
+
+void DeviceTable::formatMac(uint64_t mac, char *out, size_t capacity)
+{
+    uint8_t bytes[6];
+    unpackMac(mac, bytes);
+    snprintf(out, capacity, "%02X:%02X:%02X:%02X:%02X:%02X",
+             bytes[0], bytes[1], bytes[2], bytes[3], bytes[4], bytes[5]);
+}
+
+bool DeviceTable::parseMac(const char *text, uint64_t &mac)
+{
+    uint8_t bytes[6];
+    if (sscanf(text, "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+               &bytes[0], &bytes[1], &bytes[2], &bytes[3], &bytes[4], &bytes[5]) != 6)
+        return false;
+    mac = packMac(bytes);
+    return true;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file DeviceTable.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief Fixed capacity table of all known senders, keyed by the MAC address packed into an
+ *        integer. Open addressing with linear probing over an index twice the capacity keeps
+ *        lookups at one or two probes; entries never move, so a slot index stays valid for
+ *        the lifetime of the table. MACs are only formatted as text at the HTTP boundary.
+ *        Every slot carries a sequence counter, so readers copy a consistent snapshot
+ *        without locking and never hold up the receive path.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef DEVICE_TABLE_H
+#define DEVICE_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <shared/SensorMessage.h>
+#include <shared/ImuHistory.h>
+#include <shared/TelemetryHistory.h>
+#include <shared/LinkStats.h>
+
+/**
+ * @brief Senders the receiver keeps track of, must be a power of two. Frames of further senders
+ *        are refused, see DeviceTable::getRefused().
+ */
+#ifndef DEVICE_TABLE_CAPACITY
+#define DEVICE_TABLE_CAPACITY 64
+#endif
+
+enum TransportType : uint8_t
+{
+    TRANSPORT_ESPNOW = 0,
+    TRANSPORT_BLE = 1,
+};
+
+struct SenderInfo
+{
+    SensorMessage msg;
+    unsigned long lastSeenMs;
+    TransportType transport = TRANSPORT_ESPNOW;
+    ImuHistory *imu = nullptr; ///< High rate samples, set with the first batch frame if the heap allows, never freed
+    TelemetryHistory *history = nullptr; ///< Set while the sender is charted, never freed but may move to another sender
+    LinkStats link; ///< Telemetry frames, counted by SensorMessage::counter
+    LinkStats imuLink; ///< Batch frames, counted by ImuBatch::counter
+};
+
+/**
+ * @class DeviceTable
+ * @brief Open addressing hash table from MAC address to SenderInfo. Slots are numbered
+ *        0 to size() - 1 in the order the devices were first seen.
+ *
+ *        There may be one writer at a time: insert() and beginWrite()/endWrite() have to be
+ *        serialized by the caller. find(), size(), macAt() and read() may be called from
+ *        any task at any time.
+ */
+class DeviceTable
+{
+public:
+    /**
+     * @brief Look up a device.
+     * @param mac Packed MAC address, see packMac().
+     * @return Slot of the device, -1 if it is unknown.
+     */
+    int find(uint64_t mac) const;
+
+    /**
+     * @brief Look up a device and add it if it is unknown. Writer only.
+     * @param mac Packed MAC address, see packMac().
+     * @return Slot of the device, -1 if it is unknown and the table is full.
+     */
+    int insert(uint64_t mac);
+
+    /**
+     * @brief Number of times insert() turned a device away because the table was full.
+     * @return uint32_t
+     */
+    uint32_t getRefused() const { return refused.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Number of known devices.
+     * @return size_t
+     */
+    size_t size() const { return count.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Start changing the device in a slot returned by find() or insert(). Readers of
+     *        this slot retry until endWrite() is called, so keep the update short.
+     * @return SenderInfo& to be modified in place.
+     */
+    SenderInfo &beginWrite(int slot)
+    {
+        sequence[slot].store(sequence[slot].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        return entries[slot];
+    }
+
+    /**
+     * @brief Publish the changes made since beginWrite().
+     * @return void
+     */
+    void endWrite(int slot)
+    {
+        sequence[slot].store(sequence[slot].load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Copy data out of a slot returned by find() or below size().
+     * @param reader Called with the SenderInfo of the slot. It may run more than once when
+     *        the writer gets in between and must only copy into its own variables; the copy
+     *        of the last call is consistent.
+     * @return void
+     */
+    template <typename Reader>
+    void read(int slot, Reader reader) const
+    {
+        for (;;)
+        {
+            const uint32_t before = sequence[slot].load(std::memory_order_acquire);
+            if ((before & 1) == 0)
+            {
+                reader(static_cast<const SenderInfo &>(entries[slot]));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence[slot].load(std::memory_order_relaxed) == before)
+                    return;
+            }
+            waitForWriter();
+        }
+    }
+
+    /**
+     * @brief Packed MAC address of the device in a slot.
+     * @return uint64_t
+     */
+    uint64_t macAt(int slot) const { return keys[slot]; }
+
+    /**
+     * @brief Pack a 6 byte MAC address into the low 48 bits of an integer.
+     * @return uint64_t
+     */
+    static uint64_t packMac(const uint8_t *mac);
+
+    /**
+     * @brief Unpack a MAC address into 6 bytes.
+     * @return void
+     */
+    static void unpackMac(uint64_t mac, uint8_t *out);
+
+    /**
+     * @brief Format a packed MAC address as "AA:BB:CC:DD:EE:FF".
+     * @param out Destination of at least 18 bytes.
+     * @return void
+     */
+    static void formatMac(uint64_t mac, char *out, size_t capacity);
+
+    /**
+     * @brief Parse a MAC address in "aa:bb:cc:dd:ee:ff" form.
+     * @return false if text is not a MAC address.
+     */
+    static bool parseMac(const char *text, uint64_t &mac);
+
+private:
+    static_assert((DEVICE_TABLE_CAPACITY & (DEVICE_TABLE_CAPACITY - 1)) == 0,
+                  "DEVICE_TABLE_CAPACITY must be a power of two");
+
+    /**
+     * @brief First bucket to probe for a MAC. The vendor prefix is the same for every bot,
+     *        so all bits are mixed before the bucket is taken.
+     */
+    static size_t home(uint64_t mac);
+
+    /**
+     * @brief Let a preempted writer finish, readers may run at a higher priority.
+     */
+    static void waitForWriter();
+
+    SenderInfo entries[DEVICE_TABLE_CAPACITY];
+    uint64_t keys[DEVICE_TABLE_CAPACITY]; ///< Written once before the slot is published
+    std::atomic<uint32_t> sequence[DEVICE_TABLE_CAPACITY] = {}; ///< Odd while a write is in progress
+    std::atomic<uint16_t> buckets[2 * DEVICE_TABLE_CAPACITY] = {}; ///< Slot + 1, 0 marks an empty bucket
+    std::atomic<size_t> count{0};
+    std::atomic<uint32_t> refused{0};
+};
+
+#endif
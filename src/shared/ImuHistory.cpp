@@ -0,0 +1,48 @@
+#include "ImuHistory.h"
+
+// a sample this much older than the newest one means the sender restarted
+#define IMU_HISTORY_RESTART_MS 10000
+
+size_t ImuHistory::add(const ImuBatch &batch)
+{
+    size_t stored = 0;
+    for (uint8_t i = 0; i < batch.count && i < IMU_BATCH_MAX_SAMPLES; i++)
+    {
+        const ImuSample &sample = batch.samples[i];
+        const uint32_t time = batch.uptimeMs + sample.offsetMs;
+        if (count > 0)
+        {
+            const int32_t age = (int32_t)(time - timestampMs[(head + IMU_HISTORY_SAMPLES - 1) % IMU_HISTORY_SAMPLES]);
+            if (age <= 0 && age > -IMU_HISTORY_RESTART_MS)
+                continue;
+            if (age <= 0)
+                count = 0;
+        }
+
+        timestampMs[head] = time;
+        accelX[head] = sample.accelX;
+        accelY[head] = sample.accelY;
+        accelZ[head] = sample.accelZ;
+        gyroX[head] = sample.gyroX;
+        gyroY[head] = sample.gyroY;
+        gyroZ[head] = sample.gyroZ;
+        head = (head + 1) % IMU_HISTORY_SAMPLES;
+        if (count < IMU_HISTORY_SAMPLES)
+            count++;
+        stored++;
+    }
+    return stored;
+}
+
+void ImuHistory::get(size_t index, uint32_t &timestamp, ImuSample &sample) const
+{
+    const size_t slot = (head + IMU_HISTORY_SAMPLES - count + index) % IMU_HISTORY_SAMPLES;
+    timestamp = timestampMs[slot];
+    sample.offsetMs = 0;
+    sample.accelX = accelX[slot];
+    sample.accelY = accelY[slot];
+    sample.accelZ = accelZ[slot];
+    sample.gyroX = gyroX[slot];
+    sample.gyroY = gyroY[slot];
+    sample.gyroZ = gyroZ[slot];
+}
@@ -0,0 +1,70 @@
+/**
+ * @file ImuHistory.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief Ring buffer of the most recent IMU samples of one sender. Every axis is kept in its
+ *        own array, so a plot of one axis reads contiguous memory.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef IMU_HISTORY_H
+#define IMU_HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <shared/TelemetryFrame.h>
+
+/**
+ * @brief Samples kept per sender, 16 bytes each.
+ */
+#ifndef IMU_HISTORY_SAMPLES
+#define IMU_HISTORY_SAMPLES 128
+#endif
+
+/**
+ * @class ImuHistory
+ * @brief Columnar history of IMU samples, oldest samples are overwritten.
+ */
+class ImuHistory
+{
+public:
+    /**
+     * @brief Append all samples of a batch. Samples that are not newer than the newest stored
+     *        one, e.g. from a repeated frame, are skipped; a much older one clears the
+     *        history because the sender restarted.
+     * @param batch Received batch.
+     * @return Number of samples stored.
+     */
+    size_t add(const ImuBatch &batch);
+
+    /**
+     * @brief Number of stored samples.
+     * @return size_t
+     */
+    size_t size() const { return count; }
+
+    /**
+     * @brief Read a stored sample.
+     * @param index 0 is the oldest sample, size() - 1 the newest.
+     * @param timestampMs Receives the sender uptime of the sample.
+     * @param sample Receives the values, offsetMs is set to 0.
+     * @return void
+     */
+    void get(size_t index, uint32_t &timestampMs, ImuSample &sample) const;
+
+private:
+    uint32_t timestampMs[IMU_HISTORY_SAMPLES];
+    int16_t accelX[IMU_HISTORY_SAMPLES];
+    int16_t accelY[IMU_HISTORY_SAMPLES];
+    int16_t accelZ[IMU_HISTORY_SAMPLES];
+    int16_t gyroX[IMU_HISTORY_SAMPLES];
+    int16_t gyroY[IMU_HISTORY_SAMPLES];
+    int16_t gyroZ[IMU_HISTORY_SAMPLES];
+    size_t head = 0; ///< Next slot to write
+    size_t count = 0;
+};
+
+#endif
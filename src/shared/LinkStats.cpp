@@ -0,0 +1,45 @@
+#include "LinkStats.h"
+
+bool LinkStats::track(uint32_t counter, uint32_t uptimeMs)
+{
+    received++;
+    const int32_t ahead = (int32_t)(counter - newest);
+    const int32_t uptimeAhead = (int32_t)(uptimeMs - newestUptimeMs);
+
+    // a restarted sender counts from zero again and its clock went back, a newer frame
+    // never carries an older uptime and a late one is not held back for long
+    const bool restarted = ahead <= -LINK_REORDER_WINDOW
+        || (ahead > 0 && uptimeAhead < 0)
+        || uptimeAhead < -LINK_REORDER_MS;
+    if (!started || restarted)
+    {
+        started = true;
+        newest = counter;
+        newestUptimeMs = uptimeMs;
+        seen = 1;
+        return true;
+    }
+
+    if (ahead > 0)
+    {
+        dropped += ahead - 1;
+        newest = counter;
+        newestUptimeMs = uptimeMs;
+        seen = ahead < LINK_REORDER_WINDOW ? (seen << ahead) | 1 : 1;
+        return true;
+    }
+
+    const uint64_t bit = 1ULL << -ahead;
+    if (seen & bit)
+    {
+        duplicates++;
+        return false;
+    }
+
+    // it was counted as lost when the newer frame arrived
+    seen |= bit;
+    reordered++;
+    if (dropped > 0)
+        dropped--;
+    return false;
+}
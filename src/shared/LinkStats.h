@@ -0,0 +1,58 @@
+/**
+ * @file LinkStats.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief Frame loss accounting for one sender, derived from the frame counters it sends.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef LINK_STATS_H
+#define LINK_STATS_H
+
+#include <stdint.h>
+
+/**
+ * @brief A counter this far behind the newest one is a late frame, anything older means
+ *        the sender restarted.
+ */
+#define LINK_REORDER_WINDOW 64
+
+/**
+ * @brief A frame whose uptime is this much older than the newest frame's is not late but
+ *        from a restarted sender. Catches restarts the counter alone cannot, e.g. while the
+ *        newest counter is still inside the reorder window.
+ */
+#define LINK_REORDER_MS 1000
+
+/**
+ * @class LinkStats
+ * @brief Counts received, lost, duplicated and reordered frames of one counter sequence.
+ */
+class LinkStats
+{
+public:
+    /**
+     * @brief Account for a received frame.
+     * @param counter Frame counter sent by the device.
+     * @param uptimeMs Uptime the device sent along with the frame.
+     * @return true if the frame is newer than every frame seen so far and should be applied.
+     */
+    bool track(uint32_t counter, uint32_t uptimeMs);
+
+    uint32_t received = 0;   ///< Valid frames
+    uint32_t dropped = 0;    ///< Frames missing from the counter sequence
+    uint32_t duplicates = 0; ///< Frames received more than once
+    uint32_t reordered = 0;  ///< Frames that arrived after a newer one
+    uint32_t crcErrors = 0;  ///< Frames rejected by their checksum
+
+private:
+    uint32_t newest = 0;
+    uint32_t newestUptimeMs = 0;
+    uint64_t seen = 0; ///< Bit n is set if frame newest - n was received
+    bool started = false;
+};
+
+#endif
@@ -1,7 +1,13 @@
 #include "SenderMap.h"
 
-static std::map<String, SenderInfo> emptySenderMap;
-static SemaphoreHandle_t emptyMutex = xSemaphoreCreateMutex();
+// allocated on first use, so sketches without a receiver do not pay for the table
+__attribute__((weak)) DeviceTable &getDeviceTable()
+{
+    static DeviceTable *emptyDeviceTable = new DeviceTable();
+    return *emptyDeviceTable;
+}
 
-__attribute__((weak)) std::map<String, SenderInfo> &getSenderMap() { return emptySenderMap; }
-__attribute__((weak)) SemaphoreHandle_t getSenderMapMutex() { return emptyMutex; }
+__attribute__((weak)) bool watchHistory(int slot)
+{
+    return false;
+}
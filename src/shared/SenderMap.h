@@ -2,23 +2,13 @@
 #define SENDER_MAP_H
 
 #include <Arduino.h>
-#include <map>
-#include <shared/SensorMessage.h>
+#include <shared/DeviceTable.h>
 
-enum TransportType : uint8_t
-{
-    TRANSPORT_ESPNOW = 0,
-    TRANSPORT_BLE = 1,
-};
+// readers use DeviceTable::read(), only the receive path writes to the table
+DeviceTable &getDeviceTable();
 
-struct SenderInfo
-{
-    SensorMessage msg;
-    unsigned long lastSeenMs;
-    TransportType transport = TRANSPORT_ESPNOW;
-};
-
-std::map<String, SenderInfo> &getSenderMap();
-SemaphoreHandle_t getSenderMapMutex();
+// give the device in a slot a telemetry history if it has none, recording starts now; called
+// with every history query, so the histories follow the open charts. false if none is free
+bool watchHistory(int slot);
 
 #endif
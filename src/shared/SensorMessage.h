@@ -5,6 +5,8 @@
 
 #define MSG_MAGIC 0xDE21
 
+// Full set of telemetry values. This was also the version 1 wire format, frames are now
+// encoded with only the sampled field groups, see TelemetryFrame.h.
 typedef struct {
     uint16_t magic;
     uint32_t counter;
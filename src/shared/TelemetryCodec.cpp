@@ -0,0 +1,86 @@
+#include "TelemetryCodec.h"
+#include <string.h>
+
+size_t TelemetryEncoder::encode(const SensorMessage &msg, uint8_t groups, uint8_t *out, size_t capacity)
+{
+    groups &= TELEMETRY_GROUPS_ALL;
+
+    if (haveKey && framesSinceKey < TELEMETRY_KEYFRAME_INTERVAL && (groups & ~keyGroups) == 0)
+    {
+        uint8_t delta[TELEMETRY_MAX_FRAME];
+        size_t deltaLength = TelemetryFrame::encodeDelta(msg, groups, key, key.counter, delta, sizeof(delta));
+        size_t keyLength = TelemetryFrame::encode(msg, groups, out, capacity);
+        if (deltaLength > 0 && deltaLength < keyLength)
+        {
+            memcpy(out, delta, deltaLength);
+            framesSinceKey++;
+            return deltaLength;
+        }
+        if (keyLength == 0)
+            return 0;
+        key = msg;
+        keyGroups = groups;
+        framesSinceKey = 1;
+        return keyLength;
+    }
+
+    size_t length = TelemetryFrame::encode(msg, groups, out, capacity);
+    if (length == 0)
+        return 0;
+    key = msg;
+    keyGroups = groups;
+    framesSinceKey = 1;
+    haveKey = true;
+    return length;
+}
+
+void TelemetryEncoder::reset()
+{
+    haveKey = false;
+}
+
+bool TelemetryDecoder::decode(const uint8_t *mac, const uint8_t *data, size_t length,
+                              SensorMessage &msg, uint8_t &groups)
+{
+    uint64_t id = 0;
+    for (int i = 0; i < 6; i++)
+        id = (id << 8) | mac[i];
+
+    uint32_t keyCounter;
+    if (TelemetryFrame::deltaKeyCounter(data, length, keyCounter))
+    {
+        auto it = keyframes.find(id);
+        if (it == keyframes.end() || it->second.msg.counter != keyCounter)
+        {
+            missingKeyframes++;
+            return false;
+        }
+        it->second.lastUsed = ++useClock;
+        return TelemetryFrame::decodeDelta(data, length, it->second.msg, it->second.groups, msg, groups);
+    }
+
+    if (!TelemetryFrame::decode(data, length, msg, groups))
+        return false;
+
+    auto it = keyframes.find(id);
+    if (it == keyframes.end())
+    {
+        if (keyframes.size() >= TELEMETRY_DECODER_DEVICES)
+        {
+            // a sender that went away must not keep a newly arrived one from using delta frames
+            auto oldest = keyframes.begin();
+            for (auto candidate = keyframes.begin(); candidate != keyframes.end(); ++candidate)
+            {
+                if (candidate->second.lastUsed < oldest->second.lastUsed)
+                    oldest = candidate;
+            }
+            keyframes.erase(oldest);
+            evictedKeyframes++;
+        }
+        it = keyframes.insert(std::make_pair(id, Keyframe())).first;
+    }
+    it->second.msg = msg;
+    it->second.groups = groups;
+    it->second.lastUsed = ++useClock;
+    return true;
+}
@@ -0,0 +1,112 @@
+/**
+ * @file TelemetryCodec.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief Stateful telemetry coding on top of TelemetryFrame. The sender transmits a full
+ *        keyframe every TELEMETRY_KEYFRAME_INTERVAL frames and delta frames against it in
+ *        between; the receiver keeps the last keyframe of every sender to rebuild full values.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef TELEMETRY_CODEC_H
+#define TELEMETRY_CODEC_H
+
+#include <map>
+#include <shared/TelemetryFrame.h>
+
+/**
+ * @brief Frames between two keyframes. A lost keyframe costs at most this many frames.
+ */
+#ifndef TELEMETRY_KEYFRAME_INTERVAL
+#define TELEMETRY_KEYFRAME_INTERVAL 10
+#endif
+
+/**
+ * @brief Senders whose keyframe a receiver remembers. A new sender beyond this takes the place
+ *        of the sender that has been silent the longest.
+ */
+#ifndef TELEMETRY_DECODER_DEVICES
+#define TELEMETRY_DECODER_DEVICES 32
+#endif
+
+/**
+ * @class TelemetryEncoder
+ * @brief Chooses between keyframe and delta frame for every outgoing message.
+ */
+class TelemetryEncoder
+{
+public:
+    /**
+     * @brief Encode a message, as delta frame when the current keyframe allows it.
+     * @details A keyframe is sent when the interval is over, when a group is requested that the
+     *          keyframe does not carry, or when the delta would not be smaller.
+     * @param msg Message holding the sampled values.
+     * @param groups Bitmap of TelemetryGroup values to include.
+     * @param out Destination buffer of TELEMETRY_MAX_FRAME bytes.
+     * @param capacity Size of out.
+     * @return Frame length in bytes, 0 if out is too small.
+     */
+    size_t encode(const SensorMessage &msg, uint8_t groups, uint8_t *out, size_t capacity);
+
+    /**
+     * @brief Make the next frame a keyframe, e.g. after a new receiver connected.
+     * @return void
+     */
+    void reset();
+
+private:
+    SensorMessage key = {};
+    uint8_t keyGroups = 0;
+    uint8_t framesSinceKey = 0;
+    bool haveKey = false;
+};
+
+/**
+ * @class TelemetryDecoder
+ * @brief Decodes frames of all versions and resolves delta frames per sender.
+ */
+class TelemetryDecoder
+{
+public:
+    /**
+     * @brief Decode a frame received from mac.
+     * @param mac MAC address of the sender (6 bytes).
+     * @param data Received bytes.
+     * @param length Number of received bytes.
+     * @param msg Receives counter, uptime and the fields of all decoded groups.
+     * @param groups Receives the bitmap of decoded groups.
+     * @return true if the frame is valid and, for a delta frame, its keyframe is known.
+     */
+    bool decode(const uint8_t *mac, const uint8_t *data, size_t length, SensorMessage &msg, uint8_t &groups);
+
+    /**
+     * @brief Number of delta frames dropped because their keyframe was not received.
+     * @return uint32_t
+     */
+    uint32_t getMissingKeyframes() const { return missingKeyframes; }
+
+    /**
+     * @brief Number of keyframes forgotten to make room for a new sender. The next delta
+     *        frames of that sender are dropped until its next keyframe.
+     * @return uint32_t
+     */
+    uint32_t getEvictedKeyframes() const { return evictedKeyframes; }
+
+private:
+    struct Keyframe
+    {
+        SensorMessage msg;
+        uint8_t groups;
+        uint32_t lastUsed; ///< Value of useClock when the sender was last decoded
+    };
+
+    std::map<uint64_t, Keyframe> keyframes;
+    uint32_t useClock = 0;
+    uint32_t missingKeyframes = 0;
+    uint32_t evictedKeyframes = 0;
+};
+
+#endif
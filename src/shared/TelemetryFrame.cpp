@@ -0,0 +1,532 @@
+#include "TelemetryFrame.h"
+#include <string.h>
+#include <shared/Crc16.h>
+
+namespace
+{
+    /**
+     * @brief Describes where a wire field lives in SensorMessage.
+     */
+    struct FieldInfo
+    {
+        uint8_t group;
+        uint8_t offset;
+        uint8_t size;
+        uint8_t encoding;
+        float scale; ///< wire value = field value * scale, for the scaled encodings
+    };
+
+    /**
+     * @brief How a field is put on the wire from version 3 on. Older frames carry every field raw.
+     */
+    enum WireEncoding : uint8_t
+    {
+        WIRE_RAW,         ///< copied as is
+        WIRE_SCALED_I16,  ///< float multiplied by scale, rounded and saturated to int16
+        WIRE_SCALED_U16,  ///< float multiplied by scale, rounded and saturated to uint16
+        WIRE_CLAMPED_I16, ///< int32 saturated to int16
+    };
+
+    const uint8_t FIRST_GROUPED_VERSION = 2;
+    const uint8_t FIRST_FIXED_POINT_VERSION = 3;
+    const uint8_t FIRST_CRC_VERSION = 4;
+
+#define TELEMETRY_FIELD(group, name) {group, offsetof(SensorMessage, name), sizeof(SensorMessage::name), WIRE_RAW, 1.0f}
+#define TELEMETRY_SCALED(group, name, encoding, scale) \
+    {group, offsetof(SensorMessage, name), sizeof(SensorMessage::name), encoding, scale}
+
+    // Wire schema, ordered by group bit and then by position within the group.
+    // New fields may only be appended to the end of their group. The sensors deliver about
+    // 0.1 units of precision, so temperatures travel as centi-degrees, ambient light as quarter
+    // lux (up to 16383 lux, the range of the color sensor) and tilt angles as whole degrees.
+    const FieldInfo FIELDS[] = {
+        TELEMETRY_SCALED(GROUP_COLOR, ambientLight, WIRE_SCALED_U16, 4.0f),
+        TELEMETRY_FIELD(GROUP_COLOR, colorR),
+        TELEMETRY_FIELD(GROUP_COLOR, colorG),
+        TELEMETRY_FIELD(GROUP_COLOR, colorB),
+        TELEMETRY_FIELD(GROUP_COLOR, colorW),
+        TELEMETRY_FIELD(GROUP_IR, irFront),
+        TELEMETRY_FIELD(GROUP_IR, irLeft),
+        TELEMETRY_FIELD(GROUP_IR, irRight),
+        TELEMETRY_FIELD(GROUP_IR, irBack),
+        TELEMETRY_FIELD(GROUP_IR, dlBottom),
+        TELEMETRY_FIELD(GROUP_IR, dlFront),
+        TELEMETRY_FIELD(GROUP_MOTOR, motorLeft),
+        TELEMETRY_FIELD(GROUP_MOTOR, motorRight),
+        TELEMETRY_FIELD(GROUP_IMU, accelX),
+        TELEMETRY_FIELD(GROUP_IMU, accelY),
+        TELEMETRY_FIELD(GROUP_IMU, accelZ),
+        TELEMETRY_FIELD(GROUP_IMU, gyroX),
+        TELEMETRY_FIELD(GROUP_IMU, gyroY),
+        TELEMETRY_FIELD(GROUP_IMU, gyroZ),
+        TELEMETRY_SCALED(GROUP_IMU, temperature, WIRE_SCALED_I16, 100.0f),
+        TELEMETRY_SCALED(GROUP_IMU, tiltX, WIRE_CLAMPED_I16, 1.0f),
+        TELEMETRY_SCALED(GROUP_IMU, tiltY, WIRE_CLAMPED_I16, 1.0f),
+        TELEMETRY_FIELD(GROUP_IMU, tiltDirection),
+        TELEMETRY_FIELD(GROUP_SYSTEM, freeHeap),
+        TELEMETRY_FIELD(GROUP_SYSTEM, minFreeHeap),
+        TELEMETRY_FIELD(GROUP_SYSTEM, taskCount),
+        TELEMETRY_SCALED(GROUP_SYSTEM, chipTemp, WIRE_SCALED_I16, 100.0f),
+        TELEMETRY_FIELD(GROUP_POWER, estimatedPowerMw),
+        TELEMETRY_FIELD(GROUP_INFO, whoAmI),
+    };
+
+#undef TELEMETRY_FIELD
+#undef TELEMETRY_SCALED
+
+    const size_t FIELD_COUNT = sizeof(FIELDS) / sizeof(FIELDS[0]);
+
+    uint8_t wireSize(const FieldInfo &field, uint8_t version)
+    {
+        if (version < FIRST_FIXED_POINT_VERSION || field.encoding == WIRE_RAW)
+            return field.size;
+        return 2;
+    }
+
+    int32_t saturate(float value, int32_t minimum, int32_t maximum)
+    {
+        if (value != value)
+            return 0;
+        if (value <= (float)minimum)
+            return minimum;
+        if (value >= (float)maximum)
+            return maximum;
+        return (int32_t)(value < 0 ? value - 0.5f : value + 0.5f);
+    }
+
+    // wire value of a field in the low wireSize() bytes, floats sent raw travel as their bit pattern
+    uint32_t readField(const SensorMessage &msg, const FieldInfo &field, uint8_t version)
+    {
+        const uint8_t *source = (const uint8_t *)&msg + field.offset;
+        uint32_t value = 0;
+        if (wireSize(field, version) == field.size)
+        {
+            memcpy(&value, source, field.size);
+            return value;
+        }
+
+        float number;
+        int32_t integer;
+        switch (field.encoding)
+        {
+        case WIRE_SCALED_I16:
+            memcpy(&number, source, sizeof(number));
+            return (uint16_t)saturate(number * field.scale, INT16_MIN, INT16_MAX);
+        case WIRE_SCALED_U16:
+            memcpy(&number, source, sizeof(number));
+            return (uint16_t)saturate(number * field.scale, 0, UINT16_MAX);
+        case WIRE_CLAMPED_I16:
+            memcpy(&integer, source, sizeof(integer));
+            return (uint16_t)(integer < INT16_MIN ? INT16_MIN : integer > INT16_MAX ? INT16_MAX : integer);
+        default:
+            return 0;
+        }
+    }
+
+    void writeField(SensorMessage &msg, const FieldInfo &field, uint8_t version, uint32_t value)
+    {
+        uint8_t *target = (uint8_t *)&msg + field.offset;
+        if (wireSize(field, version) == field.size)
+        {
+            memcpy(target, &value, field.size);
+            return;
+        }
+
+        float number;
+        int32_t integer;
+        switch (field.encoding)
+        {
+        case WIRE_SCALED_I16:
+            number = (int16_t)value / field.scale;
+            memcpy(target, &number, sizeof(number));
+            break;
+        case WIRE_SCALED_U16:
+            number = (uint16_t)value / field.scale;
+            memcpy(target, &number, sizeof(number));
+            break;
+        case WIRE_CLAMPED_I16:
+            integer = (int16_t)value;
+            memcpy(target, &integer, sizeof(integer));
+            break;
+        }
+    }
+
+    // difference in the width of the field, sign extended and zig-zag encoded so that small
+    // changes in either direction become small numbers
+    uint32_t zigZagDiff(uint32_t value, uint32_t key, uint8_t size)
+    {
+        const uint8_t shift = 32 - size * 8;
+        const int32_t diff = (int32_t)((value - key) << shift) >> shift;
+        return ((uint32_t)diff << 1) ^ (uint32_t)(diff >> 31);
+    }
+
+    uint32_t applyZigZagDiff(uint32_t key, uint32_t zigZag)
+    {
+        const int32_t diff = (int32_t)(zigZag >> 1) ^ -(int32_t)(zigZag & 1);
+        return key + (uint32_t)diff;
+    }
+
+    bool putVarint(uint8_t *out, size_t capacity, size_t &used, uint32_t value)
+    {
+        do
+        {
+            if (used >= capacity)
+                return false;
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            out[used++] = byte | (value ? 0x80 : 0);
+        } while (value);
+        return true;
+    }
+
+    bool getVarint(const uint8_t *data, size_t end, size_t &position, uint32_t &value)
+    {
+        value = 0;
+        for (uint8_t shift = 0; shift < 35; shift += 7)
+        {
+            if (position >= end)
+                return false;
+            const uint8_t byte = data[position++];
+            value |= (uint32_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return true;
+        }
+        return false;
+    }
+
+    // appends the checksum of out[0, used), returns the frame length or 0 if it does not fit
+    size_t appendCrc(uint8_t *out, size_t used, size_t capacity)
+    {
+        if (used + sizeof(uint16_t) > capacity)
+            return 0;
+        const uint16_t crc = crc16(out, used);
+        memcpy(out + used, &crc, sizeof(crc));
+        return used + sizeof(crc);
+    }
+}
+
+size_t TelemetryFrame::encode(const SensorMessage &msg, uint8_t groups, uint8_t *out, size_t capacity)
+{
+    groups &= TELEMETRY_GROUPS_ALL;
+
+    TelemetryHeader header;
+    header.magic = TELEMETRY_MAGIC;
+    header.version = TELEMETRY_VERSION;
+    header.groups = groups;
+    header.counter = msg.counter;
+    header.uptimeMs = msg.uptimeMs;
+
+    if (capacity < sizeof(header))
+        return 0;
+    memcpy(out, &header, sizeof(header));
+    size_t used = sizeof(header);
+
+    size_t field = 0;
+    for (uint8_t bit = 1; bit != 0 && bit <= TELEMETRY_GROUPS_ALL; bit <<= 1)
+    {
+        if (!(groups & bit))
+        {
+            while (field < FIELD_COUNT && FIELDS[field].group == bit)
+                field++;
+            continue;
+        }
+
+        // length byte first, filled in once the group is written
+        if (used + 1 > capacity)
+            return 0;
+        const size_t lengthIndex = used++;
+        for (; field < FIELD_COUNT && FIELDS[field].group == bit; field++)
+        {
+            const uint8_t size = wireSize(FIELDS[field], TELEMETRY_VERSION);
+            if (used + size > capacity)
+                return 0;
+            const uint32_t value = readField(msg, FIELDS[field], TELEMETRY_VERSION);
+            memcpy(out + used, &value, size);
+            used += size;
+        }
+        out[lengthIndex] = (uint8_t)(used - lengthIndex - 1);
+    }
+    return appendCrc(out, used, capacity);
+}
+
+bool TelemetryFrame::decode(const uint8_t *data, size_t length, SensorMessage &msg, uint8_t &groups)
+{
+    memset(&msg, 0, sizeof(msg));
+    groups = 0;
+
+    uint16_t magic;
+    if (length < sizeof(magic))
+        return false;
+    memcpy(&magic, data, sizeof(magic));
+
+    // version 1: the plain SensorMessage struct with every field
+    if (magic == MSG_MAGIC)
+    {
+        if (length != sizeof(SensorMessage))
+            return false;
+        memcpy(&msg, data, sizeof(msg));
+        groups = TELEMETRY_GROUPS_ALL;
+        return true;
+    }
+
+    TelemetryHeader header;
+    if (magic != TELEMETRY_MAGIC || length < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.version < FIRST_GROUPED_VERSION)
+        return false;
+
+    msg.magic = MSG_MAGIC;
+    msg.counter = header.counter;
+    msg.uptimeMs = header.uptimeMs;
+
+    size_t position = sizeof(header);
+    for (uint8_t bit = 1; bit != 0; bit <<= 1)
+    {
+        if (!(header.groups & bit))
+            continue;
+        if (position >= length)
+            return false;
+        const size_t groupLength = data[position++];
+        if (position + groupLength > length)
+            return false;
+
+        // fields a newer sender appended are skipped, fields an older sender lacks stay zero
+        size_t offset = 0;
+        bool known = false;
+        for (size_t field = 0; field < FIELD_COUNT; field++)
+        {
+            if (FIELDS[field].group != bit)
+                continue;
+            known = true;
+            const uint8_t size = wireSize(FIELDS[field], header.version);
+            if (offset + size > groupLength)
+                break;
+            uint32_t value = 0;
+            memcpy(&value, data + position + offset, size);
+            writeField(msg, FIELDS[field], header.version, value);
+            offset += size;
+        }
+        if (known)
+            groups |= bit;
+        position += groupLength;
+    }
+    return true;
+}
+
+size_t TelemetryFrame::encodeDelta(const SensorMessage &msg, uint8_t groups, const SensorMessage &key,
+                                   uint32_t keyCounter, uint8_t *out, size_t capacity)
+{
+    groups &= TELEMETRY_GROUPS_ALL;
+
+    TelemetryDeltaHeader header;
+    header.magic = TELEMETRY_DELTA_MAGIC;
+    header.version = TELEMETRY_VERSION;
+    header.groups = groups;
+    header.counter = msg.counter;
+    header.uptimeMs = msg.uptimeMs;
+    header.keyCounter = keyCounter;
+
+    if (capacity < sizeof(header))
+        return 0;
+    memcpy(out, &header, sizeof(header));
+    size_t used = sizeof(header);
+
+    for (uint8_t bit = 1; bit != 0 && bit <= TELEMETRY_GROUPS_ALL; bit <<= 1)
+    {
+        if (!(groups & bit))
+            continue;
+
+        uint32_t changed = 0;
+        uint8_t index = 0;
+        for (size_t field = 0; field < FIELD_COUNT; field++)
+        {
+            if (FIELDS[field].group != bit)
+                continue;
+            if (readField(msg, FIELDS[field], TELEMETRY_VERSION) != readField(key, FIELDS[field], TELEMETRY_VERSION))
+                changed |= 1UL << index;
+            index++;
+        }
+
+        if (used + 1 > capacity)
+            return 0;
+        const size_t lengthIndex = used++;
+        if (!putVarint(out, capacity, used, changed))
+            return 0;
+        index = 0;
+        for (size_t field = 0; field < FIELD_COUNT; field++)
+        {
+            if (FIELDS[field].group != bit)
+                continue;
+            if (changed & (1UL << index++))
+            {
+                const uint32_t diff = zigZagDiff(readField(msg, FIELDS[field], TELEMETRY_VERSION),
+                                                 readField(key, FIELDS[field], TELEMETRY_VERSION),
+                                                 wireSize(FIELDS[field], TELEMETRY_VERSION));
+                if (!putVarint(out, capacity, used, diff))
+                    return 0;
+            }
+        }
+        out[lengthIndex] = (uint8_t)(used - lengthIndex - 1);
+    }
+    return appendCrc(out, used, capacity);
+}
+
+bool TelemetryFrame::decodeDelta(const uint8_t *data, size_t length, const SensorMessage &key, uint8_t keyGroups,
+                                 SensorMessage &msg, uint8_t &groups)
+{
+    memset(&msg, 0, sizeof(msg));
+    groups = 0;
+
+    TelemetryDeltaHeader header;
+    if (length < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != TELEMETRY_DELTA_MAGIC || header.version < FIRST_GROUPED_VERSION)
+        return false;
+
+    msg.magic = MSG_MAGIC;
+    msg.counter = header.counter;
+    msg.uptimeMs = header.uptimeMs;
+
+    size_t position = sizeof(header);
+    for (uint8_t bit = 1; bit != 0; bit <<= 1)
+    {
+        if (!(header.groups & bit))
+            continue;
+        if (position >= length)
+            return false;
+        const size_t end = position + 1 + data[position];
+        position++;
+        if (end > length)
+            return false;
+
+        bool known = false;
+        for (size_t field = 0; field < FIELD_COUNT && !known; field++)
+            known = FIELDS[field].group == bit;
+        if (!known)
+        {
+            position = end;
+            continue;
+        }
+        // a delta against a group the keyframe did not carry cannot be resolved
+        if (!(keyGroups & bit))
+            return false;
+
+        uint32_t changed;
+        if (!getVarint(data, end, position, changed))
+            return false;
+        uint8_t index = 0;
+        for (size_t field = 0; field < FIELD_COUNT; field++)
+        {
+            if (FIELDS[field].group != bit)
+                continue;
+            uint32_t value = readField(key, FIELDS[field], header.version);
+            if (changed & (1UL << index++))
+            {
+                uint32_t diff;
+                if (!getVarint(data, end, position, diff))
+                    return false;
+                value = applyZigZagDiff(value, diff);
+            }
+            writeField(msg, FIELDS[field], header.version, value);
+        }
+        groups |= bit;
+        position = end;
+    }
+    return true;
+}
+
+bool TelemetryFrame::deltaKeyCounter(const uint8_t *data, size_t length, uint32_t &keyCounter)
+{
+    TelemetryDeltaHeader header;
+    if (length < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != TELEMETRY_DELTA_MAGIC)
+        return false;
+    keyCounter = header.keyCounter;
+    return true;
+}
+
+size_t TelemetryFrame::encodeImuBatch(const ImuBatch &batch, uint8_t *out, size_t capacity)
+{
+    if (batch.count > IMU_BATCH_MAX_SAMPLES)
+        return 0;
+
+    ImuBatchHeader header;
+    header.magic = TELEMETRY_BATCH_MAGIC;
+    header.version = TELEMETRY_VERSION;
+    header.count = batch.count;
+    header.counter = batch.counter;
+    header.uptimeMs = batch.uptimeMs;
+
+    const size_t length = sizeof(header) + batch.count * sizeof(ImuSample);
+    if (length > capacity)
+        return 0;
+    memcpy(out, &header, sizeof(header));
+    memcpy(out + sizeof(header), batch.samples, batch.count * sizeof(ImuSample));
+    return appendCrc(out, length, capacity);
+}
+
+bool TelemetryFrame::decodeImuBatch(const uint8_t *data, size_t length, ImuBatch &batch)
+{
+    ImuBatchHeader header;
+    if (length < sizeof(header))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != TELEMETRY_BATCH_MAGIC || header.version < FIRST_GROUPED_VERSION ||
+        header.count > IMU_BATCH_MAX_SAMPLES)
+        return false;
+    // later versions may append fields to each sample, only the known prefix is read
+    if (header.count == 0 || (length - sizeof(header)) % header.count != 0)
+        return false;
+    const size_t stride = (length - sizeof(header)) / header.count;
+    if (stride < sizeof(ImuSample))
+        return false;
+
+    batch.counter = header.counter;
+    batch.uptimeMs = header.uptimeMs;
+    batch.count = header.count;
+    for (uint8_t i = 0; i < header.count; i++)
+        memcpy(&batch.samples[i], data + sizeof(header) + i * stride, sizeof(ImuSample));
+    return true;
+}
+
+bool TelemetryFrame::checkCrc(const uint8_t *data, size_t &length)
+{
+    uint16_t magic;
+    if (length < sizeof(magic) + 1)
+        return false;
+    memcpy(&magic, data, sizeof(magic));
+
+    // every grouped frame has its version right after the magic
+    if (magic != TELEMETRY_MAGIC && magic != TELEMETRY_DELTA_MAGIC && magic != TELEMETRY_BATCH_MAGIC)
+        return true;
+    if (data[sizeof(magic)] < FIRST_CRC_VERSION)
+        return true;
+
+    uint16_t crc;
+    if (length < sizeof(magic) + 1 + sizeof(crc))
+        return false;
+    memcpy(&crc, data + length - sizeof(crc), sizeof(crc));
+    if (crc16(data, length - sizeof(crc)) != crc)
+        return false;
+    length -= sizeof(crc);
+    return true;
+}
+
+void TelemetryFrame::merge(SensorMessage &target, const SensorMessage &update, uint8_t groups)
+{
+    target.magic = update.magic;
+    target.counter = update.counter;
+    target.uptimeMs = update.uptimeMs;
+
+    uint8_t *to = (uint8_t *)&target;
+    const uint8_t *from = (const uint8_t *)&update;
+    for (size_t field = 0; field < FIELD_COUNT; field++)
+    {
+        if (groups & FIELDS[field].group)
+            memcpy(to + FIELDS[field].offset, from + FIELDS[field].offset, FIELDS[field].size);
+    }
+}
@@ -0,0 +1,205 @@
+/**
+ * @file TelemetryFrame.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief Wire format of telemetry frames. A frame starts with a versioned header whose group
+ *        bitmap tells which field groups follow; every group carries its own length, so
+ *        receivers skip groups they do not know and accept groups that grew new fields.
+ *        From version 3 on, float and angle fields travel as 16 bit fixed-point values.
+ *        From version 4 on, every frame ends with a CRC-16 of all preceding bytes.
+ *        Frames of the original fixed SensorMessage layout (version 1) are decoded as well.
+ *        Delta frames carry only the fields that changed since a keyframe, see TelemetryCodec.
+ *        Batch frames carry several timestamped IMU samples for high rate motion data.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef TELEMETRY_FRAME_H
+#define TELEMETRY_FRAME_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <shared/SensorMessage.h>
+
+#define TELEMETRY_MAGIC 0xDE23
+#define TELEMETRY_DELTA_MAGIC 0xDE24
+#define TELEMETRY_BATCH_MAGIC 0xDE25
+#define TELEMETRY_VERSION 4
+
+/**
+ * @brief Largest frame that fits into one ESP-NOW packet.
+ */
+#define TELEMETRY_MAX_FRAME 250
+
+/**
+ * @brief IMU samples per batch frame. 16 samples make a 238 byte frame, which fits into one
+ *        ESP-NOW packet and into one BLE notification at an MTU of 247.
+ */
+#define IMU_BATCH_MAX_SAMPLES 16
+
+/**
+ * @brief Field groups of a SensorMessage, bit positions in the frame header.
+ */
+enum TelemetryGroup : uint8_t
+{
+    GROUP_COLOR = 1 << 0,  ///< ambientLight, colorR/G/B/W
+    GROUP_IR = 1 << 1,     ///< irFront/Left/Right/Back, dlBottom/Front
+    GROUP_MOTOR = 1 << 2,  ///< motorLeft, motorRight
+    GROUP_IMU = 1 << 3,    ///< accel, gyro, temperature, tilt, tiltDirection
+    GROUP_SYSTEM = 1 << 4, ///< freeHeap, minFreeHeap, taskCount, chipTemp
+    GROUP_POWER = 1 << 5,  ///< estimatedPowerMw
+    GROUP_INFO = 1 << 6,   ///< whoAmI, constant and therefore sent rarely
+};
+
+#define TELEMETRY_GROUPS_ALL 0x7F
+
+/**
+ * @brief Header of a version 2 and later frame, followed by one [length, payload] block per set group bit.
+ */
+typedef struct {
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  groups;
+    uint32_t counter;
+    uint32_t uptimeMs;
+} __attribute__((packed)) TelemetryHeader;
+
+/**
+ * @brief Header of a delta frame. Each group block holds a varint bitmap of the fields that
+ *        differ from keyframe keyCounter, followed by one zig-zag varint difference per changed field.
+ */
+typedef struct {
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  groups;
+    uint32_t counter;
+    uint32_t uptimeMs;
+    uint32_t keyCounter;
+} __attribute__((packed)) TelemetryDeltaHeader;
+
+/**
+ * @brief One IMU sample of a batch frame, taken offsetMs after the first sample of the batch.
+ */
+typedef struct {
+    uint16_t offsetMs;
+    int16_t  accelX;
+    int16_t  accelY;
+    int16_t  accelZ;
+    int16_t  gyroX;
+    int16_t  gyroY;
+    int16_t  gyroZ;
+} __attribute__((packed)) ImuSample;
+
+/**
+ * @brief Header of a batch frame, followed by count ImuSample values.
+ */
+typedef struct {
+    uint16_t magic;
+    uint8_t  version;
+    uint8_t  count;
+    uint32_t counter;
+    uint32_t uptimeMs;
+} __attribute__((packed)) ImuBatchHeader;
+
+/**
+ * @brief IMU samples collected by a sender. counter numbers the batches, uptimeMs is the time of
+ *        the first sample.
+ */
+struct ImuBatch
+{
+    uint32_t counter;
+    uint32_t uptimeMs;
+    uint8_t count;
+    ImuSample samples[IMU_BATCH_MAX_SAMPLES];
+};
+
+/**
+ * @class TelemetryFrame
+ * @brief Encodes and decodes telemetry frames.
+ */
+class TelemetryFrame
+{
+public:
+    /**
+     * @brief Encode the given groups of a message into a frame.
+     * @param msg Message holding the sampled values, fields of other groups are ignored.
+     * @param groups Bitmap of TelemetryGroup values to include.
+     * @param out Destination buffer.
+     * @param capacity Size of out, TELEMETRY_MAX_FRAME is always enough.
+     * @return Frame length in bytes, 0 if out is too small.
+     */
+    static size_t encode(const SensorMessage &msg, uint8_t groups, uint8_t *out, size_t capacity);
+
+    /**
+     * @brief Verify and strip the CRC trailer. Must be called before any decode function.
+     * @param data Received bytes.
+     * @param length Number of received bytes, reduced by the trailer size on success.
+     * @return false if the frame carries a CRC that does not match.
+     */
+    static bool checkCrc(const uint8_t *data, size_t &length);
+
+    /**
+     * @brief Decode a frame of any known version.
+     * @param data Received bytes.
+     * @param length Number of received bytes without the CRC trailer, see checkCrc().
+     * @param msg Receives counter, uptime and the fields of all decoded groups, other fields are zeroed.
+     * @param groups Receives the bitmap of decoded groups.
+     * @return true if the frame is valid.
+     */
+    static bool decode(const uint8_t *data, size_t length, SensorMessage &msg, uint8_t &groups);
+
+    /**
+     * @brief Encode the given groups of a message as differences to a keyframe.
+     * @param msg Message holding the sampled values.
+     * @param groups Groups to include, all of them must be present in the keyframe.
+     * @param key Values of the keyframe.
+     * @param keyCounter Counter of the keyframe, lets the receiver detect a missed keyframe.
+     * @param out Destination buffer.
+     * @param capacity Size of out, TELEMETRY_MAX_FRAME is always enough.
+     * @return Frame length in bytes, 0 if out is too small.
+     */
+    static size_t encodeDelta(const SensorMessage &msg, uint8_t groups, const SensorMessage &key,
+                              uint32_t keyCounter, uint8_t *out, size_t capacity);
+
+    /**
+     * @brief Decode a delta frame against the keyframe it refers to.
+     * @param key Values of the keyframe, see deltaKeyCounter().
+     * @param keyGroups Groups present in the keyframe.
+     * @param msg Receives the reconstructed values of the decoded groups.
+     * @param groups Receives the bitmap of decoded groups.
+     * @return true if the frame is valid and only refers to groups of the keyframe.
+     */
+    static bool decodeDelta(const uint8_t *data, size_t length, const SensorMessage &key, uint8_t keyGroups,
+                            SensorMessage &msg, uint8_t &groups);
+
+    /**
+     * @brief Tell whether a frame is a delta frame and which keyframe it refers to.
+     * @return true for a delta frame.
+     */
+    static bool deltaKeyCounter(const uint8_t *data, size_t length, uint32_t &keyCounter);
+
+    /**
+     * @brief Encode a batch of IMU samples into a frame.
+     * @param batch Samples to send, count must not exceed IMU_BATCH_MAX_SAMPLES.
+     * @param out Destination buffer.
+     * @param capacity Size of out, TELEMETRY_MAX_FRAME is always enough.
+     * @return Frame length in bytes, 0 if out is too small.
+     */
+    static size_t encodeImuBatch(const ImuBatch &batch, uint8_t *out, size_t capacity);
+
+    /**
+     * @brief Decode a batch frame.
+     * @return true if data is a valid batch frame.
+     */
+    static bool decodeImuBatch(const uint8_t *data, size_t length, ImuBatch &batch);
+
+    /**
+     * @brief Copy counter, uptime and the fields of the given groups from update into target.
+     * @return void
+     */
+    static void merge(SensorMessage &target, const SensorMessage &update, uint8_t groups);
+};
+
+#endif
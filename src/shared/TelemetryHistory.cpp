@@ -0,0 +1,302 @@
+#include "TelemetryHistory.h"
+#include <math.h>
+#include <stddef.h>
+#include <string.h>
+
+// a sample this much older than the newest one means the sender restarted
+#define TELEMETRY_HISTORY_RESTART_MS 10000
+
+static_assert(TELEMETRY_HISTORY_RESOLUTIONS == 3, "resolutionMs() lists one width per resolution");
+
+namespace
+{
+    enum SourceType : uint8_t
+    {
+        SOURCE_U16,
+        SOURCE_I16,
+        SOURCE_I32,
+        SOURCE_U32,
+        SOURCE_F32,
+    };
+
+    struct HistoryFieldInfo
+    {
+        const char *name;
+        uint8_t offset;
+        SourceType source;
+        bool isSigned; ///< Stored as int16 instead of uint16
+        float scale;   ///< Stored value per unit
+    };
+
+#define HISTORY_FIELD(member, source, isSigned, scale) \
+    {#member, offsetof(SensorMessage, member), source, isSigned, scale}
+
+    // same order as HistoryField
+    const HistoryFieldInfo FIELDS[HISTORY_FIELD_COUNT] = {
+        HISTORY_FIELD(ambientLight, SOURCE_F32, false, 4.0f),
+        HISTORY_FIELD(colorR, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(colorG, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(colorB, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(colorW, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(irFront, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(irLeft, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(irRight, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(irBack, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(dlBottom, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(dlFront, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(motorLeft, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(motorRight, SOURCE_U16, false, 1.0f),
+        HISTORY_FIELD(accelX, SOURCE_I16, true, 1.0f),
+        HISTORY_FIELD(accelY, SOURCE_I16, true, 1.0f),
+        HISTORY_FIELD(accelZ, SOURCE_I16, true, 1.0f),
+        HISTORY_FIELD(gyroX, SOURCE_I16, true, 1.0f),
+        HISTORY_FIELD(gyroY, SOURCE_I16, true, 1.0f),
+        HISTORY_FIELD(gyroZ, SOURCE_I16, true, 1.0f),
+        HISTORY_FIELD(temperature, SOURCE_F32, true, 100.0f),
+        HISTORY_FIELD(tiltX, SOURCE_I32, true, 1.0f),
+        HISTORY_FIELD(tiltY, SOURCE_I32, true, 1.0f),
+        HISTORY_FIELD(freeHeap, SOURCE_U32, false, 1.0f / 16), // 16 byte steps up to 1 MiB
+        HISTORY_FIELD(chipTemp, SOURCE_F32, true, 100.0f),
+        HISTORY_FIELD(estimatedPowerMw, SOURCE_U16, false, 1.0f),
+    };
+
+#undef HISTORY_FIELD
+
+    // fields with rollups, in column order; values that trend over minutes rather than
+    // seconds, so their min/max/mean over an hour says something
+    const HistoryField ROLLUP_FIELDS[HISTORY_ROLLUP_FIELD_COUNT] = {
+        HISTORY_AMBIENT_LIGHT,
+        HISTORY_MOTOR_LEFT,
+        HISTORY_MOTOR_RIGHT,
+        HISTORY_TEMPERATURE,
+        HISTORY_FREE_HEAP,
+        HISTORY_CHIP_TEMP,
+        HISTORY_POWER,
+    };
+
+    // column of a field in the rollups, -1 if it has none
+    int rollupColumn(HistoryField field)
+    {
+        for (size_t column = 0; column < HISTORY_ROLLUP_FIELD_COUNT; column++)
+        {
+            if (ROLLUP_FIELDS[column] == field)
+                return (int)column;
+        }
+        return -1;
+    }
+
+    float readSource(const SensorMessage &msg, const HistoryFieldInfo &field)
+    {
+        const uint8_t *src = reinterpret_cast<const uint8_t *>(&msg) + field.offset;
+        switch (field.source)
+        {
+        case SOURCE_U16:
+        {
+            uint16_t v;
+            memcpy(&v, src, sizeof(v));
+            return v;
+        }
+        case SOURCE_I16:
+        {
+            int16_t v;
+            memcpy(&v, src, sizeof(v));
+            return v;
+        }
+        case SOURCE_I32:
+        {
+            int32_t v;
+            memcpy(&v, src, sizeof(v));
+            return (float)v;
+        }
+        case SOURCE_U32:
+        {
+            uint32_t v;
+            memcpy(&v, src, sizeof(v));
+            return (float)v;
+        }
+        default:
+        {
+            float v;
+            memcpy(&v, src, sizeof(v));
+            return v;
+        }
+        }
+    }
+
+    uint16_t quantize(float value, const HistoryFieldInfo &field)
+    {
+        if (isnan(value))
+            return 0;
+        const float low = field.isSigned ? -32768.0f : 0.0f;
+        const float high = field.isSigned ? 32767.0f : 65535.0f;
+        float scaled = roundf(value * field.scale);
+        if (scaled < low)
+            scaled = low;
+        if (scaled > high)
+            scaled = high;
+        return field.isSigned ? (uint16_t)(int16_t)scaled : (uint16_t)scaled;
+    }
+}
+
+bool TelemetryHistory::add(const SensorMessage &msg)
+{
+    if (count > 0)
+    {
+        const int32_t age = (int32_t)(msg.uptimeMs - timestampMs[slotOf(count - 1)]);
+        if (age <= 0 && age > -TELEMETRY_HISTORY_RESTART_MS)
+            return false;
+        if (age <= 0)
+            clear();
+    }
+
+    int32_t sample[HISTORY_FIELD_COUNT];
+    timestampMs[head] = msg.uptimeMs;
+    for (size_t field = 0; field < HISTORY_FIELD_COUNT; field++)
+    {
+        const uint16_t stored = quantize(readSource(msg, FIELDS[field]), FIELDS[field]);
+        values[field][head] = stored;
+        sample[field] = FIELDS[field].isSigned ? (int16_t)stored : stored;
+    }
+    head = (head + 1) % TELEMETRY_HISTORY_SAMPLES;
+    if (count < TELEMETRY_HISTORY_SAMPLES)
+        count++;
+
+    for (size_t i = 0; i < TELEMETRY_HISTORY_RESOLUTIONS - 1; i++)
+        rollups[i].add(msg.uptimeMs, sample, resolutionMs(i + 1));
+    return true;
+}
+
+void TelemetryHistory::clear()
+{
+    count = 0;
+    for (Rollup &rollup : rollups)
+        rollup.count = 0;
+}
+
+void TelemetryHistory::Rollup::add(uint32_t timestamp, const int32_t *sample, uint32_t bucketMs)
+{
+    const uint32_t start = timestamp - timestamp % bucketMs;
+    if (count == 0 || startMs[head] != start)
+    {
+        if (count > 0)
+            head = (head + 1) % TELEMETRY_ROLLUP_BUCKETS;
+        if (count < TELEMETRY_ROLLUP_BUCKETS)
+            count++;
+        startMs[head] = start;
+        samples = 0;
+        for (size_t column = 0; column < HISTORY_ROLLUP_FIELD_COUNT; column++)
+        {
+            sum[column] = 0;
+            low[column] = sample[ROLLUP_FIELDS[column]];
+            high[column] = sample[ROLLUP_FIELDS[column]];
+        }
+    }
+
+    // the open bucket is rewritten every time, so readers see it like a finished one
+    samples++;
+    const int32_t half = (int32_t)(samples / 2);
+    for (size_t column = 0; column < HISTORY_ROLLUP_FIELD_COUNT; column++)
+    {
+        const int32_t value = sample[ROLLUP_FIELDS[column]];
+        sum[column] += value;
+        if (value < low[column])
+            low[column] = value;
+        if (value > high[column])
+            high[column] = value;
+        const int32_t mean = (sum[column] >= 0 ? sum[column] + half : sum[column] - half) / (int32_t)samples;
+        stats[HISTORY_MEAN][column][head] = (uint16_t)mean;
+        stats[HISTORY_MIN][column][head] = (uint16_t)low[column];
+        stats[HISTORY_MAX][column][head] = (uint16_t)high[column];
+    }
+}
+
+uint32_t TelemetryHistory::resolutionMs(size_t resolution)
+{
+    static const uint32_t widths[TELEMETRY_HISTORY_RESOLUTIONS] = {0, TELEMETRY_ROLLUP_SHORT_MS, TELEMETRY_ROLLUP_LONG_MS};
+    return widths[resolution];
+}
+
+size_t TelemetryHistory::size(size_t resolution) const
+{
+    return resolution == 0 ? count : rollups[resolution - 1].count;
+}
+
+size_t TelemetryHistory::firstAfter(size_t resolution, uint32_t sinceMs) const
+{
+    // timestamps only grow within a ring, see add()
+    size_t low = 0;
+    size_t high = size(resolution);
+    while (low < high)
+    {
+        const size_t mid = (low + high) / 2;
+        if ((int32_t)(timestampAt(resolution, mid) - sinceMs) > 0)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return low;
+}
+
+uint32_t TelemetryHistory::timestampAt(size_t resolution, size_t index) const
+{
+    if (resolution == 0)
+        return timestampMs[slotOf(index)];
+    const Rollup &rollup = rollups[resolution - 1];
+    return rollup.startMs[rollup.slotOf(index)];
+}
+
+float TelemetryHistory::valueAt(HistoryField field, size_t resolution, size_t index, HistoryStat stat) const
+{
+    const HistoryFieldInfo &info = FIELDS[field];
+    uint16_t raw;
+    if (resolution == 0)
+    {
+        raw = values[field][slotOf(index)];
+    }
+    else
+    {
+        const int column = rollupColumn(field);
+        if (column < 0)
+            return NAN;
+        const Rollup &rollup = rollups[resolution - 1];
+        raw = rollup.stats[stat][column][rollup.slotOf(index)];
+    }
+    const float value = info.isSigned ? (float)(int16_t)raw : (float)raw;
+    return value / info.scale;
+}
+
+size_t TelemetryHistory::chooseResolution(uint32_t sinceMs, size_t points) const
+{
+    for (size_t resolution = 0; resolution < TELEMETRY_HISTORY_RESOLUTIONS - 1; resolution++)
+    {
+        const size_t entries = size(resolution);
+        // the oldest entry has to be at or before sinceMs, otherwise older data is missing
+        const bool reachesBack = entries > 0 && (int32_t)(timestampAt(resolution, 0) - sinceMs) <= 0;
+        if (reachesBack && entries - firstAfter(resolution, sinceMs) <= points)
+            return resolution;
+    }
+    return TELEMETRY_HISTORY_RESOLUTIONS - 1;
+}
+
+bool TelemetryHistory::hasRollups(HistoryField field)
+{
+    return rollupColumn(field) >= 0;
+}
+
+bool TelemetryHistory::fieldByName(const char *name, size_t length, HistoryField &field)
+{
+    for (size_t i = 0; i < HISTORY_FIELD_COUNT; i++)
+    {
+        if (strlen(FIELDS[i].name) == length && strncmp(FIELDS[i].name, name, length) == 0)
+        {
+            field = (HistoryField)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *TelemetryHistory::fieldName(HistoryField field)
+{
+    return FIELDS[field].name;
+}
@@ -0,0 +1,227 @@
+/**
+ * @file TelemetryHistory.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief Ring buffer of the most recent telemetry values of one sender, so charts can be
+ *        filled from the receiver instead of being built up by polling. Every field is kept
+ *        in its own array of 16 bit values; floats and wide integers are stored scaled and
+ *        clamped like their fixed-point wire format. Older data of the slowly changing fields
+ *        is kept as min/max/mean rollups at coarser resolutions, updated with every sample, so
+ *        a chart over a long range reads as few points as one over the last minute.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef TELEMETRY_HISTORY_H
+#define TELEMETRY_HISTORY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <shared/SensorMessage.h>
+
+/**
+ * @brief Samples kept per sender, 54 bytes each. At the default telemetry interval of one
+ *        second this covers two minutes.
+ */
+#ifndef TELEMETRY_HISTORY_SAMPLES
+#define TELEMETRY_HISTORY_SAMPLES 120
+#endif
+
+/**
+ * @brief Buckets kept per rollup resolution, 46 bytes each.
+ */
+#ifndef TELEMETRY_ROLLUP_BUCKETS
+#define TELEMETRY_ROLLUP_BUCKETS 60
+#endif
+
+/**
+ * @brief Bucket widths of the two rollup resolutions. With 60 buckets they cover ten
+ *        minutes and one hour.
+ */
+#ifndef TELEMETRY_ROLLUP_SHORT_MS
+#define TELEMETRY_ROLLUP_SHORT_MS 10000
+#endif
+
+#ifndef TELEMETRY_ROLLUP_LONG_MS
+#define TELEMETRY_ROLLUP_LONG_MS 60000
+#endif
+
+/**
+ * @brief Fields that have rollups, see TelemetryHistory::hasRollups(). Rollups of all fields
+ *        would take three times the memory of the raw samples.
+ */
+#define HISTORY_ROLLUP_FIELD_COUNT 7
+
+/**
+ * @brief Raw samples plus the two rollups. Resolution 0 is the raw ring, higher numbers
+ *        are coarser.
+ */
+#define TELEMETRY_HISTORY_RESOLUTIONS 3
+
+/**
+ * @brief Value of a rollup bucket. Raw samples return the same value for all of them.
+ */
+enum HistoryStat : uint8_t
+{
+    HISTORY_MEAN,
+    HISTORY_MIN,
+    HISTORY_MAX,
+};
+
+/**
+ * @brief SensorMessage fields that are recorded, named like the SensorMessage members.
+ */
+enum HistoryField : uint8_t
+{
+    HISTORY_AMBIENT_LIGHT,
+    HISTORY_COLOR_R,
+    HISTORY_COLOR_G,
+    HISTORY_COLOR_B,
+    HISTORY_COLOR_W,
+    HISTORY_IR_FRONT,
+    HISTORY_IR_LEFT,
+    HISTORY_IR_RIGHT,
+    HISTORY_IR_BACK,
+    HISTORY_DL_BOTTOM,
+    HISTORY_DL_FRONT,
+    HISTORY_MOTOR_LEFT,
+    HISTORY_MOTOR_RIGHT,
+    HISTORY_ACCEL_X,
+    HISTORY_ACCEL_Y,
+    HISTORY_ACCEL_Z,
+    HISTORY_GYRO_X,
+    HISTORY_GYRO_Y,
+    HISTORY_GYRO_Z,
+    HISTORY_TEMPERATURE,
+    HISTORY_TILT_X,
+    HISTORY_TILT_Y,
+    HISTORY_FREE_HEAP,
+    HISTORY_CHIP_TEMP,
+    HISTORY_POWER,
+    HISTORY_FIELD_COUNT
+};
+
+/**
+ * @class TelemetryHistory
+ * @brief Columnar history of telemetry values, oldest samples are overwritten. Timestamps are
+ *        the sender uptime, so they match SensorMessage::uptimeMs; a rollup bucket is
+ *        stamped with its start. The newest bucket of a rollup is the one still being filled.
+ *        With the default sizes this is about 12 KB per sender, so the receiver only gives
+ *        a history to the senders that are being charted, see TELEMETRY_HISTORY_DEVICES.
+ */
+class TelemetryHistory
+{
+public:
+    /**
+     * @brief Append the current values of a sender and fold them into the rollups. A message
+     *        that is not newer than the newest sample is skipped; a much older one clears the
+     *        history because the sender restarted.
+     * @param msg All known values of the sender, timestamped by msg.uptimeMs.
+     * @return true if the sample was stored.
+     */
+    bool add(const SensorMessage &msg);
+
+    /**
+     * @brief Drop all samples and rollups, e.g. before the history is handed to another sender.
+     * @return void
+     */
+    void clear();
+
+    /**
+     * @brief Width of the buckets of a resolution.
+     * @return uint32_t Milliseconds, 0 for raw samples.
+     */
+    static uint32_t resolutionMs(size_t resolution);
+
+    /**
+     * @brief Number of stored samples or buckets.
+     * @return size_t
+     */
+    size_t size(size_t resolution) const;
+
+    /**
+     * @brief Find the first sample or bucket that starts after a point in time.
+     * @param sinceMs Sender uptime in milliseconds.
+     * @return Index of the oldest entry newer than sinceMs, size() if there is none.
+     */
+    size_t firstAfter(size_t resolution, uint32_t sinceMs) const;
+
+    /**
+     * @brief Sender uptime of a stored sample, or start of a bucket.
+     * @param index 0 is the oldest entry, size() - 1 the newest.
+     * @return uint32_t
+     */
+    uint32_t timestampAt(size_t resolution, size_t index) const;
+
+    /**
+     * @brief Value of one field of a stored sample or bucket.
+     * @param index 0 is the oldest entry, size() - 1 the newest.
+     * @return float NAN for a rollup of a field without rollups.
+     */
+    float valueAt(HistoryField field, size_t resolution, size_t index, HistoryStat stat = HISTORY_MEAN) const;
+
+    /**
+     * @brief Pick the resolution for a chart of everything after sinceMs. That is the finest
+     *        one that reaches back to sinceMs with at most points entries; if none does, the
+     *        coarsest, of which only the newest points entries should be shown.
+     * @return size_t Resolution, 0 for raw samples.
+     */
+    size_t chooseResolution(uint32_t sinceMs, size_t points) const;
+
+    /**
+     * @brief Whether a field is kept in the rollups too. Charts of other fields only reach
+     *        back as far as the raw samples.
+     * @return bool
+     */
+    static bool hasRollups(HistoryField field);
+
+    /**
+     * @brief Look up a field by its SensorMessage member name, e.g. "accelX".
+     * @return true if name is a recorded field.
+     */
+    static bool fieldByName(const char *name, size_t length, HistoryField &field);
+
+    /**
+     * @brief SensorMessage member name of a field.
+     * @return const char*
+     */
+    static const char *fieldName(HistoryField field);
+
+private:
+    /**
+     * @brief Min/max/mean of all samples whose timestamps fall into the same bucket, for the
+     *        fields that have rollups. The bucket being filled is written in place on every sample.
+     */
+    struct Rollup
+    {
+        void add(uint32_t timestampMs, const int32_t *sample, uint32_t bucketMs);
+        size_t slotOf(size_t index) const
+        {
+            return (head + 1 + TELEMETRY_ROLLUP_BUCKETS - count + index) % TELEMETRY_ROLLUP_BUCKETS;
+        }
+
+        uint32_t startMs[TELEMETRY_ROLLUP_BUCKETS];
+        uint16_t stats[3][HISTORY_ROLLUP_FIELD_COUNT][TELEMETRY_ROLLUP_BUCKETS]; ///< Indexed by HistoryStat, then rollup column
+        int32_t sum[HISTORY_ROLLUP_FIELD_COUNT]; ///< Of the bucket being filled
+        int32_t low[HISTORY_ROLLUP_FIELD_COUNT];
+        int32_t high[HISTORY_ROLLUP_FIELD_COUNT];
+        uint32_t samples = 0; ///< In the bucket being filled
+        size_t head = 0; ///< Slot of the bucket being filled
+        size_t count = 0;
+    };
+
+    size_t slotOf(size_t index) const
+    {
+        return (head + TELEMETRY_HISTORY_SAMPLES - count + index) % TELEMETRY_HISTORY_SAMPLES;
+    }
+
+    uint32_t timestampMs[TELEMETRY_HISTORY_SAMPLES];
+    uint16_t values[HISTORY_FIELD_COUNT][TELEMETRY_HISTORY_SAMPLES]; ///< Scaled, signed fields as two's complement
+    size_t head = 0; ///< Next slot to write
+    size_t count = 0;
+    Rollup rollups[TELEMETRY_HISTORY_RESOLUTIONS - 1];
+};
+
+#endif
@@ -52,35 +52,13 @@ static void macFromBleAddress(BLEAddress &addr, uint8_t *outMac)
 void BleReceiverTransport::notifyCallback(BLERemoteCharacteristic *pChar,
                                            uint8_t *pData, size_t length, bool isNotify)
 {
-    Serial.printf("BLE: notify received, len=%d\n", length);
-
-    if (length != sizeof(SensorMessage) || !instance)
-    {
-        Serial.printf("BLE: notify size mismatch (got %d, expected %d)\n", length, sizeof(SensorMessage));
-        return;
-    }
-
-    SensorMessage msg;
-    memcpy(&msg, pData, sizeof(msg));
-
-    if (msg.magic != MSG_MAGIC)
-    {
-        Serial.printf("BLE: bad magic 0x%04X\n", msg.magic);
+    // runs in the BLE task, decoding happens in the worker
+    if (!instance)
         return;
-    }
 
     BLEClient *pClient = pChar->getRemoteService()->getClient();
     BLEAddress addr = pClient->getPeerAddress();
-
-    uint8_t mac[6];
-    macFromBleAddress(addr, mac);
-
-    Serial.printf("BLE: telemetry from %02X:%02X:%02X:%02X:%02X:%02X counter=%lu\n",
-                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5],
-                  (unsigned long)msg.counter);
-
-    if (instance->telemetryCallback)
-        instance->telemetryCallback(mac, msg);
+    instance->enqueueFrame(*addr.getNative(), pData, length);
 }
 
 void BleReceiverTransport::connectToDevice(BLEAdvertisedDevice *device)
@@ -107,8 +85,8 @@ void BleReceiverTransport::connectToDevice(BLEAdvertisedDevice *device)
         return;
     }
 
-    // Request larger MTU — SensorMessage is 79 bytes, need at least 82 (79 + 3 ATT header)
-    pClient->setMTU(100);
+    // Request larger MTU — a full IMU batch is 238 bytes, need at least 241 (238 + 3 ATT header)
+    pClient->setMTU(247);
     Serial.printf("BLE: negotiated MTU with %s\n", addr.c_str());
 
     BLERemoteService *pService = pClient->getService(DEZIBOT_SERVICE_UUID);
@@ -208,6 +186,12 @@ bool BleReceiverTransport::begin()
     instance = this;
     devicesMutex = xSemaphoreCreateMutex();
 
+    if (!startWorker("ble_rx"))
+    {
+        Serial.println("BLE receive worker failed to start");
+        return false;
+    }
+
     BLEDevice::init("Dezibot_Receiver");
 
     BLEScan *pScan = BLEDevice::getScan();
@@ -219,23 +203,22 @@ bool BleReceiverTransport::begin()
     return true;
 }
 
-bool BleReceiverTransport::sendCommand(const uint8_t *mac, uint8_t command)
+bool BleReceiverTransport::sendCommandFrame(const uint8_t *mac, const uint8_t *frame, size_t length)
 {
     if (xSemaphoreTake(devicesMutex, pdMS_TO_TICKS(100)) != pdTRUE)
         return false;
 
+    // BLE has no broadcast, a group command is written to every connection
     bool sent = false;
     for (auto &pair : connectedDevices)
     {
         BleDeviceEntry &entry = pair.second;
-        if (memcmp(entry.mac, mac, 6) == 0 && entry.commandChar)
+        if ((!mac || memcmp(entry.mac, mac, 6) == 0) && entry.commandChar)
         {
-            CommandMessage msg = {};
-            msg.magic = CMD_MAGIC;
-            msg.command = command;
-            entry.commandChar->writeValue((uint8_t *)&msg, sizeof(msg));
+            entry.commandChar->writeValue((uint8_t *)frame, length);
             sent = true;
-            break;
+            if (mac)
+                break;
         }
     }
 
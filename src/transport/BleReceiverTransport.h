@@ -68,13 +68,15 @@ public:
      */
     bool begin() override;
 
+protected:
     /**
-     * @brief Send a command to a specific connected device.
-     * @param mac MAC address of the target device (6 bytes).
-     * @param command Command byte to send.
-     * @return true if send successful, false otherwise.
+     * @brief Write a command frame to a specific connected device.
+     * @param mac MAC address of the target device (6 bytes), nullptr for every connected one.
+     * @param frame Command frame to send.
+     * @param length Frame length.
+     * @return true if a device is connected and the frame was written, false otherwise.
      */
-    bool sendCommand(const uint8_t *mac, uint8_t command) override;
+    bool sendCommandFrame(const uint8_t *mac, const uint8_t *frame, size_t length) override;
 
 private:
     /**
@@ -7,7 +7,10 @@ BleSenderTransport *BleSenderTransport::instance = nullptr;
 void BleSenderTransport::ServerCallbacks::onConnect(BLEServer *pServer)
 {
     if (instance)
+    {
         instance->deviceConnected = true;
+        instance->keyframeRequested = true;
+    }
     Serial.println("BLE: receiver connected");
 }
 
@@ -19,19 +22,36 @@ void BleSenderTransport::ServerCallbacks::onDisconnect(BLEServer *pServer)
     pServer->startAdvertising();
 }
 
-void BleSenderTransport::CommandCharCallbacks::onWrite(BLECharacteristic *pCharacteristic)
+void BleSenderTransport::SensorCharCallbacks::onStatus(BLECharacteristic *pCharacteristic, Status s, uint32_t code)
 {
-    std::string value = pCharacteristic->getValue();
-    if (value.length() != sizeof(CommandMessage))
+    if (!instance)
         return;
 
-    CommandMessage cmd;
-    memcpy(&cmd, value.data(), sizeof(cmd));
+    // a disabled subscription or a missing client is not the channel's fault
+    portENTER_CRITICAL(&instance->txStatsMux);
+    if (s == SUCCESS_NOTIFY && instance->notifyingAck)
+        instance->txStats.acks++;
+    else if (s == SUCCESS_NOTIFY)
+        instance->txStats.sent++;
+    else if (s == ERROR_GATT && !instance->notifyingAck)
+        instance->txStats.failed++;
+    portEXIT_CRITICAL(&instance->txStatsMux);
+}
 
-    if (cmd.magic != CMD_MAGIC)
+void BleSenderTransport::CommandCharCallbacks::onWrite(BLECharacteristic *pCharacteristic)
+{
+    std::string value = pCharacteristic->getValue();
+    CommandMessage cmd;
+    bool shared;
+    if (!instance || !instance->parseCommand((const uint8_t *)value.data(), value.length(), cmd, shared))
         return;
 
-    if (instance && instance->commandCallback)
+    // acknowledged on the sensor characteristic, the receiver is subscribed to it anyway
+    uint8_t ack[sizeof(CommandAck)];
+    const size_t length = encodeAck(cmd.seq, ack);
+    instance->notify(ack, length, true);
+
+    if (instance->isNewCommand(cmd.seq) && instance->commandCallback)
         instance->commandCallback(cmd);
 }
 
@@ -39,11 +59,14 @@ bool BleSenderTransport::begin()
 {
     instance = this;
 
+    notifyMutex = xSemaphoreCreateMutex();
+    if (!notifyMutex)
+        return false;
+
     Serial.println("BLE: reading MAC...");
-    uint8_t mac[6];
-    esp_read_mac(mac, ESP_MAC_BT);
+    esp_read_mac(ownMac, ESP_MAC_BT);
     char nameBuf[20];
-    snprintf(nameBuf, sizeof(nameBuf), "Dezibot_%02X%02X", mac[4], mac[5]);
+    snprintf(nameBuf, sizeof(nameBuf), "Dezibot_%02X%02X", ownMac[4], ownMac[5]);
 
     Serial.print("BLE: initializing as ");
     Serial.println(nameBuf);
@@ -71,6 +94,7 @@ bool BleSenderTransport::begin()
         SENSOR_CHAR_UUID,
         BLECharacteristic::PROPERTY_NOTIFY);
     pSensorChar->addDescriptor(new BLE2902());
+    pSensorChar->setCallbacks(new SensorCharCallbacks());
 
     pCommandChar = pService->createCharacteristic(
         COMMAND_CHAR_UUID,
@@ -80,7 +104,8 @@ bool BleSenderTransport::begin()
     Serial.println("BLE: starting service...");
     pService->start();
 
-    BLEDevice::setMTU(100);
+    // a full IMU batch is 238 bytes, the largest MTU leaves 244 for the payload
+    BLEDevice::setMTU(247);
 
     Serial.println("BLE: starting advertising...");
     BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
@@ -93,7 +118,7 @@ bool BleSenderTransport::begin()
     return true;
 }
 
-bool BleSenderTransport::sendTelemetry(const SensorMessage &msg)
+bool BleSenderTransport::sendTelemetry(const SensorMessage &msg, uint8_t groups)
 {
     if (!deviceConnected)
     {
@@ -101,8 +126,49 @@ bool BleSenderTransport::sendTelemetry(const SensorMessage &msg)
         return false;
     }
 
-    pSensorChar->setValue((uint8_t *)&msg, sizeof(msg));
-    pSensorChar->notify();
-    Serial.printf("BLE: notified %d bytes, counter=%lu\n", sizeof(msg), (unsigned long)msg.counter);
+    if (keyframeRequested)
+    {
+        keyframeRequested = false;
+        encoder.reset();
+    }
+
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    size_t length = encoder.encode(msg, groups, frame, sizeof(frame));
+    if (length == 0)
+        return false;
+
+    notify(frame, length);
+    Serial.printf("BLE: notified %d bytes, counter=%lu\n", length, (unsigned long)msg.counter);
     return true;
 }
+
+bool BleSenderTransport::sendImuBatch(const ImuBatch &batch)
+{
+    if (!deviceConnected)
+        return false;
+
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    size_t length = TelemetryFrame::encodeImuBatch(batch, frame, sizeof(frame));
+    if (length == 0)
+        return false;
+
+    notify(frame, length);
+    return true;
+}
+
+void BleSenderTransport::notify(uint8_t *frame, size_t length, bool ack)
+{
+    // acknowledgements are sent from the BLE task, telemetry from the sender loop
+    xSemaphoreTake(notifyMutex, portMAX_DELAY);
+    if (!ack)
+    {
+        portENTER_CRITICAL(&txStatsMux);
+        txStats.queued++;
+        portEXIT_CRITICAL(&txStatsMux);
+    }
+    notifyingAck = ack;
+    pSensorChar->setValue(frame, length);
+    pSensorChar->notify();
+    notifyingAck = false;
+    xSemaphoreGive(notifyMutex);
+}
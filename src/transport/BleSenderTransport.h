@@ -47,11 +47,37 @@ public:
     /**
      * @brief Send telemetry data via BLE notification.
      * @param msg The sensor message containing telemetry data.
+     * @param groups Field groups to transmit, see TelemetryGroup.
      * @return true if send successful, false otherwise.
      */
-    bool sendTelemetry(const SensorMessage &msg) override;
+    bool sendTelemetry(const SensorMessage &msg, uint8_t groups) override;
+
+    /**
+     * @brief Send a batch of IMU samples via BLE notification.
+     * @param batch The collected samples.
+     * @return true if send successful, false otherwise.
+     */
+    bool sendImuBatch(const ImuBatch &batch) override;
 
 private:
+    /**
+     * @brief Notify the receiver of a frame and count it.
+     * @param ack Whether the frame is a command acknowledgement, counted in TxStats::acks only.
+     * @return void
+     */
+    void notify(uint8_t *frame, size_t length, bool ack = false);
+
+    /**
+     * @brief Keeps setValue() and notify() of one frame together.
+     */
+    SemaphoreHandle_t notifyMutex = nullptr;
+
+    /**
+     * @brief Whether the notification in progress is an acknowledgement. onStatus() runs
+     *        inside notify(), with notifyMutex held.
+     */
+    bool notifyingAck = false;
+
     /**
      * @brief Pointer to the BLE server instance.
      */
@@ -72,6 +98,11 @@ private:
      */
     bool deviceConnected = false;
 
+    /**
+     * @brief Set when a receiver connected, it needs a keyframe before it can decode deltas.
+     */
+    bool keyframeRequested = false;
+
     /**
      * @brief Singleton instance pointer for static callbacks.
      */
@@ -96,6 +127,21 @@ private:
         void onDisconnect(BLEServer *pServer) override;
     };
 
+    /**
+     * @class SensorCharCallbacks
+     * @brief Counts the outcome of every notification in txStats.
+     */
+    class SensorCharCallbacks : public BLECharacteristicCallbacks
+    {
+        /**
+         * @brief Called after a notification was handed to the stack or refused.
+         * @param pCharacteristic Pointer to the characteristic.
+         * @param s Outcome, ERROR_GATT when the link is congested.
+         * @param code Stack error code.
+         */
+        void onStatus(BLECharacteristic *pCharacteristic, Status s, uint32_t code) override;
+    };
+
     /**
      * @class CommandCharCallbacks
      * @brief Callback handler for command characteristic write events.
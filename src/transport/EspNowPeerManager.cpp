@@ -0,0 +1,72 @@
+#include "EspNowPeerManager.h"
+#include <string.h>
+
+bool EspNowPeerManager::ensurePeer(const uint8_t *mac)
+{
+    useClock++;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (memcmp(entries[i].mac, mac, 6) == 0)
+        {
+            entries[i].lastUsed = useClock;
+            stats.hits++;
+            return true;
+        }
+    }
+
+    stats.misses++;
+    if (count == ESPNOW_PEER_SLOTS)
+        evictOldest();
+
+    esp_err_t result = addPeer(mac);
+    // the driver table may also hold peers added elsewhere, make room and try once more
+    if (result == ESP_ERR_ESPNOW_FULL && evictOldest())
+        result = addPeer(mac);
+    if (result != ESP_OK && result != ESP_ERR_ESPNOW_EXIST)
+    {
+        stats.failures++;
+        return false;
+    }
+
+    memcpy(entries[count].mac, mac, 6);
+    entries[count].lastUsed = useClock;
+    count++;
+    return true;
+}
+
+PeerStats EspNowPeerManager::getStats() const
+{
+    PeerStats current = stats;
+    current.peers = count;
+    return current;
+}
+
+esp_err_t EspNowPeerManager::addPeer(const uint8_t *mac)
+{
+    esp_now_peer_info_t peer = {};
+    memcpy(peer.peer_addr, mac, 6);
+    peer.channel = 0;
+    peer.encrypt = false;
+    peer.ifidx = ifidx;
+    return esp_now_add_peer(&peer);
+}
+
+bool EspNowPeerManager::evictOldest()
+{
+    if (count == 0)
+        return false;
+
+    size_t oldest = 0;
+    for (size_t i = 1; i < count; i++)
+    {
+        // compared as a difference, so the clock may wrap
+        if ((int32_t)(entries[i].lastUsed - entries[oldest].lastUsed) < 0)
+            oldest = i;
+    }
+
+    esp_now_del_peer(entries[oldest].mac);
+    entries[oldest] = entries[count - 1];
+    count--;
+    stats.evictions++;
+    return true;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file EspNowPeerManager.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief Keeps the ESP-NOW peer table filled with the most recently addressed devices.
+ *        ESP-NOW only sends unicast frames to registered peers and holds at most
+ *        ESP_NOW_MAX_TOTAL_PEER_NUM of them, so the least recently used peer is removed
+ *        when a new device has to be added.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef ESPNOW_PEER_MANAGER_H
+#define ESPNOW_PEER_MANAGER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_now.h>
+
+/**
+ * @brief Peers the manager keeps registered at the same time.
+ */
+#ifndef ESPNOW_PEER_SLOTS
+#define ESPNOW_PEER_SLOTS ESP_NOW_MAX_TOTAL_PEER_NUM
+#endif
+
+/**
+ * @brief Counters of the peer table since begin.
+ */
+struct PeerStats
+{
+    uint32_t hits = 0;      ///< Sends to a device that already was a peer
+    uint32_t misses = 0;    ///< Sends that had to add the device first
+    uint32_t evictions = 0; ///< Peers removed to make room
+    uint32_t failures = 0;  ///< Devices that could not be added
+    size_t peers = 0;       ///< Currently registered
+};
+
+/**
+ * @class EspNowPeerManager
+ * @brief LRU cache of ESP-NOW peers. Not thread safe, the caller serializes all sends.
+ */
+class EspNowPeerManager
+{
+public:
+    /**
+     * @param ifidx Interface the peers are registered on.
+     */
+    explicit EspNowPeerManager(wifi_interface_t ifidx) : ifidx(ifidx) {}
+
+    /**
+     * @brief Make a device a peer before a frame is sent to it, evicting the least recently
+     *        used peer if the table is full.
+     * @param mac MAC address of the device (6 bytes).
+     * @return false if the device could not be added.
+     */
+    bool ensurePeer(const uint8_t *mac);
+
+    /**
+     * @brief Peer table counters.
+     * @return PeerStats
+     */
+    PeerStats getStats() const;
+
+private:
+    struct Entry
+    {
+        uint8_t mac[6];
+        uint32_t lastUsed; ///< Value of useClock at the last send
+    };
+
+    /**
+     * @brief Register a device with ESP-NOW.
+     * @return esp_err_t Result of esp_now_add_peer().
+     */
+    esp_err_t addPeer(const uint8_t *mac);
+
+    /**
+     * @brief Remove the least recently used peer.
+     * @return false if there is none.
+     */
+    bool evictOldest();
+
+    wifi_interface_t ifidx;
+    Entry entries[ESPNOW_PEER_SLOTS];
+    size_t count = 0;
+    uint32_t useClock = 0;
+    PeerStats stats;
+};
+
+#endif
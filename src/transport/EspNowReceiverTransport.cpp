@@ -2,22 +2,17 @@
 #include <WiFi.h>
 #include <esp_now.h>
 #include <esp_wifi.h>
+#include <logger/Logger.h>
 
 EspNowReceiverTransport *EspNowReceiverTransport::instance = nullptr;
 
 void EspNowReceiverTransport::onRecv(const uint8_t *mac, const uint8_t *data, int dataLen)
 {
-    if (dataLen != sizeof(SensorMessage))
+    // runs in the Wi-Fi task, decoding happens in the worker
+    if (dataLen <= 0 || !instance)
         return;
 
-    SensorMessage msg;
-    memcpy(&msg, data, sizeof(msg));
-
-    if (msg.magic != MSG_MAGIC)
-        return;
-
-    if (instance && instance->telemetryCallback)
-        instance->telemetryCallback(mac, msg);
+    instance->enqueueFrame(mac, data, dataLen);
 }
 
 bool EspNowReceiverTransport::begin()
@@ -30,6 +25,12 @@ bool EspNowReceiverTransport::begin()
         return false;
     }
 
+    if (!startWorker("espnow_rx"))
+    {
+        Serial.println("ESP-NOW receive worker failed to start");
+        return false;
+    }
+
     esp_now_register_recv_cb(onRecv);
 
     uint8_t primaryChan = 0;
@@ -39,30 +40,23 @@ bool EspNowReceiverTransport::begin()
     return true;
 }
 
-bool EspNowReceiverTransport::sendCommand(const uint8_t *mac, uint8_t command)
+bool EspNowReceiverTransport::sendCommandFrame(const uint8_t *mac, const uint8_t *frame, size_t length)
 {
-    Serial.printf("sendCommand: to %02X:%02X:%02X:%02X:%02X:%02X cmd=0x%02X\n",
-                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], command);
+    // group commands are broadcast, every sender filters them itself
+    static const uint8_t broadcastAddress[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+    if (!mac)
+        mac = broadcastAddress;
+
+    Serial.printf("sendCommand: to %02X:%02X:%02X:%02X:%02X:%02X, %u bytes\n",
+                  mac[0], mac[1], mac[2], mac[3], mac[4], mac[5], (unsigned)length);
 
-    if (!esp_now_is_peer_exist(mac))
+    // the peer table holds 20 devices, the least recently commanded one makes room
+    if (!peers.ensurePeer(mac))
     {
-        esp_now_peer_info_t peer = {};
-        memcpy(peer.peer_addr, mac, 6);
-        peer.channel = 0;
-        peer.encrypt = false;
-        peer.ifidx = WIFI_IF_AP;
-        esp_err_t addResult = esp_now_add_peer(&peer);
-        if (addResult != ESP_OK)
-        {
-            Serial.printf("sendCommand: add_peer failed err=0x%x\n", addResult);
-            return false;
-        }
+        DEZIBOT_LOG_FORMAT(LogEntry::WARNING, LogEntry::FMT_PEER_ADD_FAILED, mac);
+        return false;
     }
 
-    CommandMessage msg = {};
-    msg.magic = CMD_MAGIC;
-    msg.command = command;
-
-    esp_err_t result = esp_now_send(mac, (uint8_t *)&msg, sizeof(msg));
+    esp_err_t result = esp_now_send(mac, frame, length);
     return result == ESP_OK;
 }
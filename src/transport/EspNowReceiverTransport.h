@@ -14,6 +14,7 @@
 #define ESPNOW_RECEIVER_TRANSPORT_H
 
 #include "ReceiverTransport.h"
+#include "EspNowPeerManager.h"
 
 /**
  * @class EspNowReceiverTransport
@@ -29,14 +30,27 @@ public:
     bool begin() override;
 
     /**
-     * @brief Send a command to a specific sender via ESP-NOW.
-     * @param mac MAC address of the target device (6 bytes).
-     * @param command Command byte to send.
-     * @return true if send successful, false otherwise.
+     * @brief Hit, miss and eviction counts of the peer table used for commands.
+     * @return PeerStats
      */
-    bool sendCommand(const uint8_t *mac, uint8_t command) override;
+    PeerStats getPeerStats() const { return peers.getStats(); }
+
+protected:
+    /**
+     * @brief Send a command frame to a specific sender via ESP-NOW.
+     * @param mac MAC address of the target device (6 bytes), nullptr to broadcast.
+     * @param frame Command frame to send.
+     * @param length Frame length.
+     * @return true if the frame was queued by ESP-NOW, false otherwise.
+     */
+    bool sendCommandFrame(const uint8_t *mac, const uint8_t *frame, size_t length) override;
 
 private:
+    /**
+     * @brief Peers for command frames, only used by sendCommandFrame().
+     */
+    EspNowPeerManager peers{WIFI_IF_AP};
+
     /**
      * @brief Singleton instance pointer for static callbacks.
      */
@@ -1,30 +1,164 @@
 #include "EspNowSenderTransport.h"
 #include <WiFi.h>
+#include <esp_mac.h>
 #include <esp_now.h>
 #include <esp_wifi.h>
+#include <shared/Crc16.h>
 
 #define ESPNOW_CHANNEL 1
 
+static bool isKeyframe(const uint8_t *data, size_t length)
+{
+    uint16_t magic;
+    if (length < sizeof(magic))
+        return false;
+    memcpy(&magic, data, sizeof(magic));
+    return magic == TELEMETRY_MAGIC;
+}
+
 EspNowSenderTransport *EspNowSenderTransport::instance = nullptr;
 
 void EspNowSenderTransport::onSent(const uint8_t *macAddr, esp_now_send_status_t status)
 {
-    Serial.print("Send status: ");
-    Serial.println(status == ESP_NOW_SEND_SUCCESS ? "OK" : "FAIL");
+    if (!instance)
+        return;
+
+    portENTER_CRITICAL(&instance->txStatsMux);
+    // a callback for a frame that timed out was counted already and must not free the next one
+    const bool current = ++instance->callbackSeq == instance->inFlightSeq;
+    if (current)
+        instance->complete(status == ESP_NOW_SEND_SUCCESS);
+    portEXIT_CRITICAL(&instance->txStatsMux);
+
+    if (current)
+        xSemaphoreGive(instance->txDone);
 }
 
-void EspNowSenderTransport::onRecv(const uint8_t *mac, const uint8_t *data, int dataLen)
+void EspNowSenderTransport::complete(bool success)
 {
-    if (dataLen != sizeof(CommandMessage))
+    inFlightSeq = 0;
+    if (inFlightAck)
+    {
+        if (success)
+            txStats.acks++;
         return;
+    }
 
-    CommandMessage cmd;
-    memcpy(&cmd, data, sizeof(cmd));
+    if (success)
+        txStats.sent++;
+    else
+        txStats.failed++;
+    if (!success && inFlightKey)
+        keyframeLost.store(true);
+
+    const uint32_t latency = micros() - inFlightSinceUs;
+    txStats.lastLatencyUs = latency;
+    txStats.latencySumUs += latency;
+    if (latency > txStats.maxLatencyUs)
+        txStats.maxLatencyUs = latency;
+    if (txStats.sent + txStats.failed == 1)
+        txStats.meanLatencyUs = latency;
+    else
+        txStats.meanLatencyUs = (uint32_t)((int32_t)txStats.meanLatencyUs + ((int32_t)latency - (int32_t)txStats.meanLatencyUs) / 16);
+}
+
+bool EspNowSenderTransport::transmit(const uint8_t *mac, const uint8_t *data, size_t length, uint32_t queuedUs, bool ack)
+{
+    // one frame in flight; a callback that never comes must not stall the queue
+    if (xSemaphoreTake(txDone, pdMS_TO_TICKS(ESPNOW_TX_TIMEOUT_MS)) != pdTRUE)
+    {
+        portENTER_CRITICAL(&txStatsMux);
+        const bool timedOut = inFlightSeq != 0;
+        if (timedOut)
+            complete(false);
+        portEXIT_CRITICAL(&txStatsMux);
+
+        // otherwise the callback came just after the timeout and is about to give txDone
+        if (!timedOut)
+            xSemaphoreTake(txDone, portMAX_DELAY);
+    }
+
+    // the callback may run before esp_now_send() returns, the frame is tagged beforehand
+    portENTER_CRITICAL(&txStatsMux);
+    inFlightSeq = txSeq + 1;
+    inFlightSinceUs = queuedUs;
+    inFlightAck = ack;
+    inFlightKey = !ack && isKeyframe(data, length);
+    portEXIT_CRITICAL(&txStatsMux);
+
+    esp_err_t result = esp_now_send(mac, data, length);
+    if (result == ESP_OK)
+    {
+        txSeq++;
+        return true;
+    }
+
+    // no callback follows a refused frame
+    portENTER_CRITICAL(&txStatsMux);
+    inFlightSeq = 0;
+    if (result != ESP_ERR_ESPNOW_NO_MEM && !ack)
+    {
+        txStats.failed++;
+        if (inFlightKey)
+            keyframeLost.store(true);
+    }
+    portEXIT_CRITICAL(&txStatsMux);
+    xSemaphoreGive(txDone);
+
+    if (result == ESP_ERR_ESPNOW_NO_MEM)
+    {
+        // the driver is still busy, the caller tries the same frame again
+        vTaskDelay(1);
+        return false;
+    }
+    return true;
+}
+
+void EspNowSenderTransport::txTask(void *param)
+{
+    EspNowSenderTransport *self = (EspNowSenderTransport *)param;
+
+    while (true)
+    {
+        // acknowledgements go out before queued telemetry, the receiver is waiting for them
+        const uint32_t ackRequest = self->pendingAck.exchange(0);
+        if (ackRequest != 0)
+        {
+            if (ackRequest & ACK_JITTER)
+                vTaskDelay(pdMS_TO_TICKS(esp_random() % (COMMAND_ACK_JITTER_MS + 1)));
+
+            uint8_t ack[sizeof(CommandAck)];
+            const size_t length = encodeAck((uint16_t)ackRequest, ack);
+            if (!self->transmit(self->broadcastAddress, ack, length, micros(), true))
+                self->pendingAck.store(ackRequest & ~ACK_JITTER);
+            continue;
+        }
+
+        const FrameQueue::Frame *frame = self->txQueue.front();
+        if (frame == nullptr)
+        {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
 
-    if (cmd.magic != CMD_MAGIC)
+        if (self->transmit(frame->mac, frame->data, frame->length, frame->timeUs, false))
+            self->txQueue.pop();
+    }
+}
+
+void EspNowSenderTransport::onRecv(const uint8_t *mac, const uint8_t *data, int dataLen)
+{
+    CommandMessage cmd;
+    bool shared;
+    if (!instance || dataLen <= 0 || !instance->parseCommand(data, dataLen, cmd, shared))
         return;
 
-    if (instance && instance->commandCallback)
+    // a retransmitted command is acknowledged again, its ACK may have been lost
+    instance->pendingAck.store(ACK_REQUESTED | (shared ? ACK_JITTER : 0) | cmd.seq);
+    if (instance->txHandle)
+        xTaskNotifyGive(instance->txHandle);
+
+    if (instance->isNewCommand(cmd.seq) && instance->commandCallback)
         instance->commandCallback(cmd);
 }
 
@@ -34,6 +168,7 @@ bool EspNowSenderTransport::begin()
 
     WiFi.mode(WIFI_STA);
     WiFi.disconnect();
+    esp_read_mac(ownMac, ESP_MAC_WIFI_STA);
     esp_wifi_set_channel(ESPNOW_CHANNEL, WIFI_SECOND_CHAN_NONE);
 
     if (esp_now_init() != ESP_OK)
@@ -42,6 +177,14 @@ bool EspNowSenderTransport::begin()
         return false;
     }
 
+    txDone = xSemaphoreCreateBinary();
+    if (!txDone || xTaskCreatePinnedToCore(txTask, "espnow_tx", 4096, this, 5, &txHandle, 0) != pdPASS)
+    {
+        Serial.println("ESP-NOW TX task start failed");
+        return false;
+    }
+    xSemaphoreGive(txDone);
+
     esp_now_register_send_cb(onSent);
     esp_now_register_recv_cb(onRecv);
 
@@ -62,8 +205,49 @@ bool EspNowSenderTransport::begin()
     return true;
 }
 
-bool EspNowSenderTransport::sendTelemetry(const SensorMessage &msg)
+bool EspNowSenderTransport::sendTelemetry(const SensorMessage &msg, uint8_t groups)
+{
+    if (keyframeLost.exchange(false))
+        encoder.reset();
+
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    size_t length = encoder.encode(msg, groups, frame, sizeof(frame));
+    if (length == 0)
+        return false;
+
+    // encode() took the frame as the new reference already, the next one has to replace it
+    if (!enqueue(frame, length))
+    {
+        encoder.reset();
+        return false;
+    }
+    return true;
+}
+
+bool EspNowSenderTransport::sendImuBatch(const ImuBatch &batch)
 {
-    esp_err_t result = esp_now_send(broadcastAddress, (const uint8_t *)&msg, sizeof(msg));
-    return result == ESP_OK;
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    size_t length = TelemetryFrame::encodeImuBatch(batch, frame, sizeof(frame));
+    if (length == 0)
+        return false;
+
+    return enqueue(frame, length);
+}
+
+bool EspNowSenderTransport::enqueue(const uint8_t *frame, size_t length)
+{
+    const bool queued = txHandle && txQueue.push(broadcastAddress, frame, length, micros());
+
+    portENTER_CRITICAL(&txStatsMux);
+    if (queued)
+        txStats.queued++;
+    else
+        txStats.dropped++;
+    portEXIT_CRITICAL(&txStatsMux);
+
+    if (!queued)
+        return false;
+
+    xTaskNotifyGive(txHandle);
+    return true;
 }
@@ -2,7 +2,9 @@
  * @file EspNowSenderTransport.h
  * @author Niclas Jost, Marius Busalt
  * @brief ESP-NOW based sender transport implementation.
- *        Uses ESP-NOW protocol to send telemetry data and receive commands.
+ *        Uses ESP-NOW protocol to send telemetry data and receive commands. Frames are
+ *        queued and handed to the radio by a TX task, one at a time, so a busy channel
+ *        backs up the queue instead of the driver and never blocks sensor sampling.
  * @version 1.0
  * @date 2026-02
  *
@@ -14,8 +16,18 @@
 #define ESPNOW_SENDER_TRANSPORT_H
 
 #include "SenderTransport.h"
+#include "FrameQueue.h"
+#include <Arduino.h>
+#include <atomic>
 #include <esp_now.h>
 
+/**
+ * @brief Time to wait for the send callback of a frame before it is counted as failed.
+ */
+#ifndef ESPNOW_TX_TIMEOUT_MS
+#define ESPNOW_TX_TIMEOUT_MS 100
+#endif
+
 /**
  * @class EspNowSenderTransport
  * @brief ESP-NOW implementation of SenderTransport for sending telemetry via ESP-NOW.
@@ -30,13 +42,48 @@ public:
     bool begin() override;
 
     /**
-     * @brief Send telemetry data via ESP-NOW broadcast.
+     * @brief Queue telemetry data for an ESP-NOW broadcast.
      * @param msg The sensor message containing telemetry data.
-     * @return true if send successful, false otherwise.
+     * @param groups Field groups to transmit, see TelemetryGroup.
+     * @return true if the frame was queued, the outcome is counted in getTxStats().
+     */
+    bool sendTelemetry(const SensorMessage &msg, uint8_t groups) override;
+
+    /**
+     * @brief Queue a batch of IMU samples for an ESP-NOW broadcast.
+     * @param batch The collected samples.
+     * @return true if the frame was queued, the outcome is counted in getTxStats().
      */
-    bool sendTelemetry(const SensorMessage &msg) override;
+    bool sendImuBatch(const ImuBatch &batch) override;
 
 private:
+    /**
+     * @brief Queue an encoded frame for the TX task. Called from the sending task only.
+     * @return false if the queue is full.
+     */
+    bool enqueue(const uint8_t *frame, size_t length);
+
+    /**
+     * @brief TX task, sends pending acknowledgements and queued frames in order and waits
+     *        for the send callback of each.
+     * @param param The transport.
+     */
+    static void txTask(void *param);
+
+    /**
+     * @brief Hand one frame to the radio once the previous one completed. TX task only.
+     * @param queuedUs Start of the latency measurement, in micros().
+     * @param ack Whether the frame is a command acknowledgement, counted in TxStats::acks only.
+     * @return false if the driver had no room, the frame has to be sent again.
+     */
+    bool transmit(const uint8_t *mac, const uint8_t *data, size_t length, uint32_t queuedUs, bool ack);
+
+    /**
+     * @brief Count the frame in flight as finished and clear it. Caller holds txStatsMux.
+     * @param success Whether the radio reported the frame as sent.
+     */
+    void complete(bool success);
+
     /**
      * @brief Singleton instance pointer for static callbacks.
      */
@@ -61,6 +108,66 @@ private:
      * @brief Broadcast MAC address (FF:FF:FF:FF:FF:FF).
      */
     uint8_t broadcastAddress[6] = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
+
+    /**
+     * @brief Frames waiting for the radio.
+     */
+    FrameQueue txQueue;
+
+    /**
+     * @brief TX task handle, notified for every queued frame.
+     */
+    TaskHandle_t txHandle = nullptr;
+
+    /**
+     * @brief Given by the send callback, taken before the next frame goes out.
+     */
+    SemaphoreHandle_t txDone = nullptr;
+
+    /**
+     * @brief Transmission sequence number of the frame in flight, 0 if none is waiting for
+     *        its callback. Set by the TX task, cleared by whoever completes the frame.
+     */
+    uint32_t inFlightSeq = 0;
+
+    /**
+     * @brief Queue time of the frame in flight, in micros().
+     */
+    uint32_t inFlightSinceUs = 0;
+
+    /**
+     * @brief Whether the frame in flight is a command acknowledgement.
+     */
+    bool inFlightAck = false;
+
+    /**
+     * @brief Whether the frame in flight is a telemetry keyframe.
+     */
+    bool inFlightKey = false;
+
+    /**
+     * @brief Set by the TX task when a keyframe failed, the receivers cannot decode the deltas
+     *        that follow it. Taken by sendTelemetry(), which resets the encoder.
+     */
+    std::atomic<bool> keyframeLost{false};
+
+    /**
+     * @brief Frames the driver accepted, and send callbacks received. The driver reports
+     *        frames in order, so the n-th callback belongs to the n-th accepted frame and a
+     *        late callback of a frame that already timed out can be told apart.
+     */
+    uint32_t txSeq = 0;
+    uint32_t callbackSeq = 0;
+
+    /**
+     * @brief ACK_REQUESTED | seq of the command to acknowledge next, 0 if there is none.
+     *        ACK_JITTER is added for group commands. Set by the receive callback, taken by
+     *        the TX task.
+     */
+    std::atomic<uint32_t> pendingAck{0};
+
+    static constexpr uint32_t ACK_REQUESTED = 0x10000;
+    static constexpr uint32_t ACK_JITTER = 0x20000;
 };
 
 #endif
@@ -0,0 +1,33 @@
+#include "FrameQueue.h"
+#include <string.h>
+
+bool FrameQueue::push(const uint8_t *mac, const uint8_t *data, size_t length, uint32_t timeUs)
+{
+    const uint32_t position = head.load(std::memory_order_relaxed);
+    if (length > TELEMETRY_MAX_FRAME || position - tail.load(std::memory_order_acquire) >= FRAME_QUEUE_SLOTS)
+    {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Frame &frame = frames[position & (FRAME_QUEUE_SLOTS - 1)];
+    memcpy(frame.mac, mac, sizeof(frame.mac));
+    frame.length = (uint8_t)length;
+    frame.timeUs = timeUs;
+    memcpy(frame.data, data, length);
+    head.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+const FrameQueue::Frame *FrameQueue::front() const
+{
+    const uint32_t position = tail.load(std::memory_order_relaxed);
+    if (position == head.load(std::memory_order_acquire))
+        return nullptr;
+    return &frames[position & (FRAME_QUEUE_SLOTS - 1)];
+}
+
+void FrameQueue::pop()
+{
+    tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
@@ -0,0 +1,82 @@
+/**
+ * @file FrameQueue.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief Single-producer/single-consumer queue of raw frames. The radio callback only
+ *        copies a received frame into a preallocated slot and the receiver worker decodes
+ *        it straight from that slot; senders queue outgoing frames for their TX task the
+ *        same way.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef FRAME_QUEUE_H
+#define FRAME_QUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <shared/TelemetryFrame.h>
+
+/**
+ * @brief Frames that can wait for the worker, must be a power of two.
+ */
+#ifndef FRAME_QUEUE_SLOTS
+#define FRAME_QUEUE_SLOTS 16
+#endif
+
+/**
+ * @class FrameQueue
+ * @brief Lock-free ring of raw frames, one producer and one consumer.
+ */
+class FrameQueue
+{
+public:
+    /**
+     * @brief A frame with the MAC address of its sender or recipient.
+     */
+    struct Frame
+    {
+        uint8_t mac[6];
+        uint8_t length;
+        uint32_t timeUs; ///< Passed to push()
+        uint8_t data[TELEMETRY_MAX_FRAME];
+    };
+
+    /**
+     * @brief Copy a frame into the next free slot. Producer side only, does not allocate or block.
+     * @param timeUs Kept with the frame, e.g. to measure how long it waited.
+     * @return false if the queue is full or the frame too long; the frame is dropped and counted.
+     */
+    bool push(const uint8_t *mac, const uint8_t *data, size_t length, uint32_t timeUs = 0);
+
+    /**
+     * @brief Oldest queued frame, valid until pop(). Consumer side only.
+     * @return nullptr if the queue is empty.
+     */
+    const Frame *front() const;
+
+    /**
+     * @brief Release the slot returned by front(). Consumer side only.
+     * @return void
+     */
+    void pop();
+
+    /**
+     * @brief Number of frames dropped because the queue was full.
+     * @return uint32_t
+     */
+    uint32_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    static_assert((FRAME_QUEUE_SLOTS & (FRAME_QUEUE_SLOTS - 1)) == 0, "FRAME_QUEUE_SLOTS must be a power of two");
+
+    Frame frames[FRAME_QUEUE_SLOTS];
+    std::atomic<uint32_t> head{0}; ///< Frames pushed by the producer
+    std::atomic<uint32_t> tail{0}; ///< Frames popped by the consumer
+    std::atomic<uint32_t> dropped{0};
+};
+
+#endif
@@ -0,0 +1,44 @@
+#include "RateController.h"
+#include "SenderTransport.h"
+
+#define RATE_MIN_MILLIHZ (1000000 / TELEMETRY_MAX_INTERVAL_MS)
+#define RATE_MAX_MILLIHZ (1000000 / TELEMETRY_MIN_INTERVAL_MS)
+
+RateController::RateController() : rateMilliHz(1000000 / TELEMETRY_INTERVAL_MS)
+{
+}
+
+void RateController::update(const TxStats &stats)
+{
+    const uint32_t sent = stats.sent - windowSent;
+    const uint32_t failed = stats.failed - windowFailed;
+    const uint32_t dropped = stats.dropped - windowDropped;
+
+    // a dropped frame means the queue overflowed, no need to wait for a full window
+    if (dropped == 0 && sent + failed < RATE_WINDOW_FRAMES)
+        return;
+
+    // judged on this window alone, one slow frame must not halve the rate again and again
+    const uint32_t completed = sent + failed;
+    const uint32_t meanLatencyUs = completed > 0 ? (stats.latencySumUs - windowLatencySumUs) / completed : 0;
+    const bool congested = dropped > 0 || meanLatencyUs > RATE_LATENCY_LIMIT_US ||
+                           failed * 100 > completed * RATE_FAILURE_PERCENT;
+    if (congested)
+    {
+        rateMilliHz /= 2;
+        if (rateMilliHz < RATE_MIN_MILLIHZ)
+            rateMilliHz = RATE_MIN_MILLIHZ;
+        backoffs++;
+    }
+    else
+    {
+        rateMilliHz += RATE_STEP_MILLIHZ;
+        if (rateMilliHz > RATE_MAX_MILLIHZ)
+            rateMilliHz = RATE_MAX_MILLIHZ;
+    }
+
+    windowSent = stats.sent;
+    windowFailed = stats.failed;
+    windowDropped = stats.dropped;
+    windowLatencySumUs = stats.latencySumUs;
+}
@@ -0,0 +1,107 @@
+/**
+ * @file RateController.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief Adapts the telemetry send interval of a sender to the load of the channel. The
+ *        rate grows by a fixed step while frames go out cleanly and is halved when they
+ *        fail, are dropped or wait too long for the radio (AIMD), so many bots in one room
+ *        share the airtime without coordinating. IMU batch frames are not rate limited,
+ *        they carry samples taken at a fixed rate, but they share the queue and the radio
+ *        and so count in the windows that decide the telemetry rate.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef RATE_CONTROLLER_H
+#define RATE_CONTROLLER_H
+
+#include <stdint.h>
+
+struct TxStats;
+
+/**
+ * @brief Interval a sender starts with, and the bounds the controller keeps it in. By
+ *        default a sender never goes faster than it starts and only slows down under load.
+ */
+#ifndef TELEMETRY_INTERVAL_MS
+#define TELEMETRY_INTERVAL_MS 1000
+#endif
+
+#ifndef TELEMETRY_MIN_INTERVAL_MS
+#define TELEMETRY_MIN_INTERVAL_MS TELEMETRY_INTERVAL_MS
+#endif
+
+#ifndef TELEMETRY_MAX_INTERVAL_MS
+#define TELEMETRY_MAX_INTERVAL_MS 5000
+#endif
+
+/**
+ * @brief Completed frames needed before the link is judged.
+ */
+#ifndef RATE_WINDOW_FRAMES
+#define RATE_WINDOW_FRAMES 8
+#endif
+
+/**
+ * @brief Share of failed frames in a window, in percent, that counts as congestion.
+ */
+#ifndef RATE_FAILURE_PERCENT
+#define RATE_FAILURE_PERCENT 10
+#endif
+
+/**
+ * @brief Mean queue-to-callback latency of the frames in a window that counts as
+ *        congestion. Broadcasts are never acknowledged, so a busy channel mostly shows up
+ *        as frames waiting for airtime.
+ */
+#ifndef RATE_LATENCY_LIMIT_US
+#define RATE_LATENCY_LIMIT_US 20000
+#endif
+
+/**
+ * @brief Rate added after every clean window, in thousandths of a frame per second.
+ */
+#ifndef RATE_STEP_MILLIHZ
+#define RATE_STEP_MILLIHZ 100
+#endif
+
+/**
+ * @class RateController
+ * @brief AIMD control of the telemetry rate from the transmit counters of a transport.
+ */
+class RateController
+{
+public:
+    RateController();
+
+    /**
+     * @brief Judge the frames completed since the last window and adjust the rate.
+     * @param stats Current counters of the transport.
+     * @return void
+     */
+    void update(const TxStats &stats);
+
+    /**
+     * @brief Interval between two telemetry frames at the current rate.
+     * @return uint32_t Milliseconds, between TELEMETRY_MIN_INTERVAL_MS and TELEMETRY_MAX_INTERVAL_MS.
+     */
+    uint32_t getIntervalMs() const { return 1000000 / rateMilliHz; }
+
+    /**
+     * @brief Number of times the rate was halved.
+     * @return uint32_t
+     */
+    uint32_t getBackoffs() const { return backoffs; }
+
+private:
+    uint32_t rateMilliHz;
+    uint32_t windowSent = 0; ///< Counters at the start of the current window
+    uint32_t windowFailed = 0;
+    uint32_t windowDropped = 0;
+    uint32_t windowLatencySumUs = 0;
+    uint32_t backoffs = 0;
+};
+
+#endif
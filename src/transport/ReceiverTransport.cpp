@@ -0,0 +1,276 @@
+#include "ReceiverTransport.h"
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <shared/Crc16.h>
+#include <shared/DeviceTable.h>
+
+bool ReceiverTransport::startWorker(const char *name)
+{
+    commandMutex = xSemaphoreCreateMutex();
+    pendingAckMutex = xSemaphoreCreateMutex();
+    ackReceived = xSemaphoreCreateBinary();
+    nextSeq = (uint16_t)esp_random();
+    if (!commandMutex || !pendingAckMutex || !ackReceived)
+        return false;
+
+    return xTaskCreatePinnedToCore(workerTask, name, 4096, this, 4, &worker, 1) == pdPASS;
+}
+
+void ReceiverTransport::enqueueFrame(const uint8_t *mac, const uint8_t *data, size_t length)
+{
+    // the arrival time is kept for the round trip of command acknowledgements
+    if (worker && queue.push(mac, data, length, micros()))
+        xTaskNotifyGive(worker);
+}
+
+bool ReceiverTransport::sendCommand(const uint8_t *mac, uint8_t command, CommandResult &result)
+{
+    result = CommandResult();
+    if (!commandMutex || xSemaphoreTake(commandMutex, pdMS_TO_TICKS(1000)) != pdTRUE)
+        return false;
+
+    CommandMessage msg = {};
+    msg.magic = CMD_MAGIC;
+    msg.command = command;
+    msg.seq = nextSeq++;
+    msg.crc = crc16((const uint8_t *)&msg, offsetof(CommandMessage, crc));
+
+    xSemaphoreTake(pendingAckMutex, portMAX_DELAY);
+    memcpy(pendingMac, mac, 6);
+    pendingSeq = msg.seq;
+    pendingGroup = false;
+    pendingActive = true;
+    xSemaphoreGive(pendingAckMutex);
+    // a late acknowledgement of the previous command may still be signalled
+    xSemaphoreTake(ackReceived, 0);
+
+    const uint32_t firstUs = micros();
+    uint32_t timeoutMs = COMMAND_ACK_TIMEOUT_MS;
+    uint32_t sentUs[COMMAND_MAX_ATTEMPTS];
+    size_t sentCount = 0;
+    while (result.attempts < COMMAND_MAX_ATTEMPTS)
+    {
+        result.attempts++;
+        const uint32_t attemptUs = micros();
+        // the same frame every time, the device executes it once and acknowledges every copy
+        if (sendCommandFrame(mac, (const uint8_t *)&msg, sizeof(msg)))
+            sentUs[sentCount++] = attemptUs;
+        // a refused frame waits out its timeout too, an earlier copy may still be answered
+        if (xSemaphoreTake(ackReceived, pdMS_TO_TICKS(timeoutMs)) == pdTRUE)
+            break;
+        timeoutMs *= 2;
+    }
+
+    // the worker clears pendingActive when the acknowledgement arrives, even just after the last timeout
+    xSemaphoreTake(pendingAckMutex, portMAX_DELAY);
+    result.acked = !pendingActive;
+    pendingActive = false;
+    const uint32_t ackUs = pendingAckUs;
+    xSemaphoreGive(pendingAckMutex);
+
+    // the acknowledgement does not say which copy it answers; it is taken to answer the last
+    // one sent before it arrived, an earlier copy may be acknowledged after a retransmission
+    const uint32_t endUs = result.acked ? ackUs : micros();
+    for (size_t i = sentCount; result.acked && i-- > 0;)
+    {
+        if ((int32_t)(endUs - sentUs[i]) >= 0)
+        {
+            result.rttUs = endUs - sentUs[i];
+            break;
+        }
+    }
+    result.totalUs = endUs - firstUs;
+
+    xSemaphoreGive(commandMutex);
+    return result.acked;
+}
+
+bool ReceiverTransport::sendGroupCommand(const CommandTarget &target, uint8_t command,
+                                         const std::vector<uint64_t> &expected, GroupCommandResult &result)
+{
+    result = GroupCommandResult();
+    if (target.type == TARGET_MACS && target.macs.size() > CMD_GROUP_MAX_MACS)
+        return false;
+    if (!commandMutex || xSemaphoreTake(commandMutex, pdMS_TO_TICKS(1000)) != pdTRUE)
+        return false;
+
+    const uint16_t seq = nextSeq++;
+    xSemaphoreTake(pendingAckMutex, portMAX_DELAY);
+    pendingSeq = seq;
+    pendingGroup = true;
+    pendingAcked.clear();
+    pendingAcked.reserve(expected.size());
+    pendingActive = true;
+    xSemaphoreGive(pendingAckMutex);
+    xSemaphoreTake(ackReceived, 0);
+
+    CommandTarget frameTarget = target;
+    uint8_t frame[CMD_GROUP_MAX_FRAME];
+    const uint32_t firstUs = micros();
+    uint32_t timeoutMs = COMMAND_ACK_TIMEOUT_MS;
+    size_t ackedBefore = 0;
+    while (result.attempts < COMMAND_MAX_ATTEMPTS)
+    {
+        result.attempts++;
+        const size_t length = encodeGroupCommand(frameTarget, command, seq, frame);
+        // nothing to wait for if the frame reaches nobody and nobody is expected
+        if (!sendCommandFrame(nullptr, frame, length) && expected.empty())
+            break;
+
+        // every acknowledgement wakes us, with a list of expected senders we can stop early
+        std::vector<uint64_t> missing;
+        const uint32_t startMs = millis();
+        uint32_t elapsedMs = 0;
+        while (elapsedMs < timeoutMs &&
+               xSemaphoreTake(ackReceived, pdMS_TO_TICKS(timeoutMs - elapsedMs)) == pdTRUE &&
+               (expected.empty() || (collectMissing(expected, missing), !missing.empty())))
+            elapsedMs = millis() - startMs;
+
+        const size_t ackedCount = collectMissing(expected, missing);
+        if (!expected.empty() && missing.empty())
+            break;
+        // without a list, stop once a retransmission brought no new acknowledgement
+        if (expected.empty() && result.attempts >= 2 && ackedCount == ackedBefore)
+            break;
+        ackedBefore = ackedCount;
+
+        // retransmissions only address the silent senders, the others would acknowledge again
+        if (!expected.empty() && missing.size() <= CMD_GROUP_MAX_MACS)
+        {
+            frameTarget.type = TARGET_MACS;
+            frameTarget.macs = missing;
+        }
+        timeoutMs *= 2;
+    }
+
+    xSemaphoreTake(pendingAckMutex, portMAX_DELAY);
+    pendingActive = false;
+    result.acked = pendingAcked;
+    xSemaphoreGive(pendingAckMutex);
+
+    for (uint64_t mac : expected)
+    {
+        if (std::find(result.acked.begin(), result.acked.end(), mac) == result.acked.end())
+            result.missing.push_back(mac);
+    }
+    result.totalUs = micros() - firstUs;
+
+    xSemaphoreGive(commandMutex);
+    return result.missing.empty() && !result.acked.empty();
+}
+
+size_t ReceiverTransport::collectMissing(const std::vector<uint64_t> &expected, std::vector<uint64_t> &missing)
+{
+    missing.clear();
+    xSemaphoreTake(pendingAckMutex, portMAX_DELAY);
+    for (uint64_t mac : expected)
+    {
+        if (std::find(pendingAcked.begin(), pendingAcked.end(), mac) == pendingAcked.end())
+            missing.push_back(mac);
+    }
+    const size_t acked = pendingAcked.size();
+    xSemaphoreGive(pendingAckMutex);
+    return acked;
+}
+
+size_t ReceiverTransport::encodeGroupCommand(const CommandTarget &target, uint8_t command, uint16_t seq, uint8_t *out)
+{
+    GroupCommandHeader header;
+    header.magic = CMD_GROUP_MAGIC;
+    header.command = command;
+    header.seq = seq;
+    header.target = target.type;
+    header.groups = target.groups;
+    header.macCount = target.type == TARGET_MACS ? (uint8_t)target.macs.size() : 0;
+    memcpy(out, &header, sizeof(header));
+
+    size_t length = sizeof(header);
+    for (size_t i = 0; i < header.macCount; i++, length += 6)
+        DeviceTable::unpackMac(target.macs[i], out + length);
+
+    const uint16_t crc = crc16(out, length);
+    memcpy(out + length, &crc, sizeof(crc));
+    return length + sizeof(crc);
+}
+
+void ReceiverTransport::workerTask(void *param)
+{
+    ReceiverTransport *self = (ReceiverTransport *)param;
+
+    while (true)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        const FrameQueue::Frame *frame;
+        while ((frame = self->queue.front()) != nullptr)
+        {
+            self->handleFrame(*frame);
+            self->queue.pop();
+        }
+    }
+}
+
+bool ReceiverTransport::handleAck(const FrameQueue::Frame &frame)
+{
+    if (frame.length != sizeof(CommandAck))
+        return false;
+
+    CommandAck ack;
+    memcpy(&ack, frame.data, sizeof(ack));
+    if (ack.magic != CMD_ACK_MAGIC)
+        return false;
+    if (ack.crc != crc16(frame.data, offsetof(CommandAck, crc)))
+        return true;
+
+    xSemaphoreTake(pendingAckMutex, portMAX_DELAY);
+    if (pendingActive && pendingGroup && pendingSeq == ack.seq)
+    {
+        const uint64_t mac = DeviceTable::packMac(frame.mac);
+        if (std::find(pendingAcked.begin(), pendingAcked.end(), mac) == pendingAcked.end())
+        {
+            pendingAcked.push_back(mac);
+            xSemaphoreGive(ackReceived);
+        }
+    }
+    else if (pendingActive && pendingSeq == ack.seq && memcmp(pendingMac, frame.mac, 6) == 0)
+    {
+        // only the first copy counts, later ones are answers to retransmissions
+        pendingActive = false;
+        pendingAckUs = frame.timeUs;
+        xSemaphoreGive(ackReceived);
+    }
+    xSemaphoreGive(pendingAckMutex);
+    return true;
+}
+
+void ReceiverTransport::handleFrame(const FrameQueue::Frame &frame)
+{
+    // acknowledgements share the channel with telemetry but carry their own CRC
+    if (handleAck(frame))
+        return;
+
+    size_t length = frame.length;
+    if (!TelemetryFrame::checkCrc(frame.data, length))
+    {
+        if (crcErrorCallback)
+            crcErrorCallback(frame.mac);
+        return;
+    }
+
+    ImuBatch batch;
+    if (TelemetryFrame::decodeImuBatch(frame.data, length, batch))
+    {
+        if (imuBatchCallback)
+            imuBatchCallback(frame.mac, batch);
+        return;
+    }
+
+    SensorMessage msg;
+    uint8_t groups;
+    if (!decoder.decode(frame.mac, frame.data, length, msg, groups))
+        return;
+
+    if (telemetryCallback)
+        telemetryCallback(frame.mac, msg, groups);
+}
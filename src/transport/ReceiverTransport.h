@@ -13,11 +13,46 @@
 #ifndef RECEIVER_TRANSPORT_H
 #define RECEIVER_TRANSPORT_H
 
+#include <Arduino.h>
 #include <functional>
+#include <vector>
 #include <shared/SensorMessage.h>
 #include <shared/CommandMessage.h>
+#include <shared/CommandSender.h>
+#include <shared/TelemetryCodec.h>
+#include "FrameQueue.h"
 
-using TelemetryCallback = std::function<void(const uint8_t *mac, const SensorMessage &msg)>;
+/**
+ * @brief Receives decoded telemetry. Only the fields of the groups set in groups
+ *        (see TelemetryGroup) were transmitted, all other fields are zero.
+ */
+using TelemetryCallback = std::function<void(const uint8_t *mac, const SensorMessage &msg, uint8_t groups)>;
+
+/**
+ * @brief Receives a batch of IMU samples.
+ */
+using ImuBatchCallback = std::function<void(const uint8_t *mac, const ImuBatch &batch)>;
+
+/**
+ * @brief Told about a frame from mac that failed its CRC check.
+ */
+using CrcErrorCallback = std::function<void(const uint8_t *mac)>;
+
+/**
+ * @brief Time to wait for the acknowledgement of the first transmission of a command. Every
+ *        retransmission waits twice as long as the one before.
+ */
+#ifndef COMMAND_ACK_TIMEOUT_MS
+#define COMMAND_ACK_TIMEOUT_MS 20
+#endif
+
+/**
+ * @brief Transmissions of a command before it is given up, 620 ms in total with the default
+ *        timeout.
+ */
+#ifndef COMMAND_MAX_ATTEMPTS
+#define COMMAND_MAX_ATTEMPTS 5
+#endif
 
 /**
  * @class ReceiverTransport
@@ -38,12 +73,29 @@ public:
     virtual bool begin() = 0;
 
     /**
-     * @brief Send a command to a specific device.
+     * @brief Send a command to a specific device and retransmit it with exponential backoff
+     *        until the device acknowledges it. Blocks the caller until then, one command is
+     *        in flight at a time.
      * @param mac MAC address of the target device (6 bytes).
      * @param command Command byte to send.
-     * @return true if send successful, false otherwise.
+     * @param result Attempts and measured latencies.
+     * @return true if the device acknowledged the command, false otherwise.
      */
-    virtual bool sendCommand(const uint8_t *mac, uint8_t command) = 0;
+    bool sendCommand(const uint8_t *mac, uint8_t command, CommandResult &result);
+
+    /**
+     * @brief Send one command frame to many senders, each of them checks the target itself.
+     *        Retransmitted with exponential backoff to the expected senders that did not
+     *        acknowledge it yet. Without expected senders it is repeated until a
+     *        retransmission brings no new acknowledgement.
+     * @param target Senders to address, at most CMD_GROUP_MAX_MACS for TARGET_MACS.
+     * @param command Command byte to send.
+     * @param expected Senders that should acknowledge, packed like DeviceTable::packMac().
+     * @param result Attempts and the senders that did and did not acknowledge.
+     * @return true if every expected sender, and at least one, acknowledged the command.
+     */
+    bool sendGroupCommand(const CommandTarget &target, uint8_t command,
+                          const std::vector<uint64_t> &expected, GroupCommandResult &result);
 
     /**
      * @brief Set the callback function for incoming telemetry data.
@@ -52,11 +104,141 @@ public:
      */
     void setTelemetryCallback(TelemetryCallback cb) { telemetryCallback = cb; }
 
+    /**
+     * @brief Set the callback function for incoming IMU batches.
+     * @param cb Callback function to handle received batches.
+     * @return void
+     */
+    void setImuBatchCallback(ImuBatchCallback cb) { imuBatchCallback = cb; }
+
+    /**
+     * @brief Set the callback function for frames with a CRC mismatch.
+     * @param cb Callback function to count corrupted frames.
+     * @return void
+     */
+    void setCrcErrorCallback(CrcErrorCallback cb) { crcErrorCallback = cb; }
+
+    /**
+     * @brief Number of received frames dropped because the worker fell behind.
+     * @return uint32_t
+     */
+    uint32_t getQueueDropped() const { return queue.getDropped(); }
+
 protected:
+    /**
+     * @brief Transmit one command frame, without waiting for its acknowledgement.
+     * @param mac MAC address of the target device (6 bytes), nullptr for every sender in reach.
+     * @param frame Complete frame, sent as is.
+     * @param length Frame length.
+     * @return true if the frame was handed to the radio.
+     */
+    virtual bool sendCommandFrame(const uint8_t *mac, const uint8_t *frame, size_t length) = 0;
+
+    /**
+     * @brief Start the task that decodes queued frames and calls the callbacks.
+     * @param name Task name.
+     * @return true if the task was created.
+     */
+    bool startWorker(const char *name);
+
+    /**
+     * @brief Queue a received frame for the worker. Called from the radio callback.
+     * @param mac MAC address of the sender (6 bytes).
+     * @param data Received bytes.
+     * @param length Number of received bytes.
+     * @return void
+     */
+    void enqueueFrame(const uint8_t *mac, const uint8_t *data, size_t length);
+
     /**
      * @brief Callback function for incoming telemetry data.
      */
     TelemetryCallback telemetryCallback;
+
+    /**
+     * @brief Callback function for incoming IMU batches.
+     */
+    ImuBatchCallback imuBatchCallback;
+
+    /**
+     * @brief Callback function for frames with a CRC mismatch.
+     */
+    CrcErrorCallback crcErrorCallback;
+
+    /**
+     * @brief Last keyframe of every sender, resolves delta frames. Only used by the worker.
+     */
+    TelemetryDecoder decoder;
+
+private:
+    /**
+     * @brief Worker task, waits for frames and handles them in arrival order.
+     * @param param The transport.
+     */
+    static void workerTask(void *param);
+
+    /**
+     * @brief Check, decode and dispatch one frame.
+     * @return void
+     */
+    void handleFrame(const FrameQueue::Frame &frame);
+
+    /**
+     * @brief Hand a command acknowledgement to the waiting sendCommand().
+     * @return false if the frame is not a CommandAck.
+     */
+    bool handleAck(const FrameQueue::Frame &frame);
+
+    /**
+     * @brief Expected senders that have not acknowledged the pending group command yet.
+     * @return size_t Number of senders that acknowledged it.
+     */
+    size_t collectMissing(const std::vector<uint64_t> &expected, std::vector<uint64_t> &missing);
+
+    /**
+     * @brief Encode a group command frame.
+     * @param out Destination of CMD_GROUP_MAX_FRAME bytes.
+     * @return size_t Frame length.
+     */
+    static size_t encodeGroupCommand(const CommandTarget &target, uint8_t command, uint16_t seq, uint8_t *out);
+
+    /**
+     * @brief Frames handed over by the radio callback.
+     */
+    FrameQueue queue;
+
+    /**
+     * @brief Worker task handle, notified for every queued frame.
+     */
+    TaskHandle_t worker = nullptr;
+
+    /**
+     * @brief Held by sendCommand() for the whole exchange.
+     */
+    SemaphoreHandle_t commandMutex = nullptr;
+
+    /**
+     * @brief Guards the pending* fields between sendCommand() and the worker.
+     */
+    SemaphoreHandle_t pendingAckMutex = nullptr;
+
+    /**
+     * @brief Given by the worker when the pending command was acknowledged.
+     */
+    SemaphoreHandle_t ackReceived = nullptr;
+
+    uint8_t pendingMac[6] = {};
+    uint16_t pendingSeq = 0;
+    bool pendingActive = false;
+    bool pendingGroup = false;
+    std::vector<uint64_t> pendingAcked; ///< Senders that acknowledged the pending group command
+    uint32_t pendingAckUs = 0; ///< Arrival of the acknowledgement, in micros()
+
+    /**
+     * @brief Sequence number of the next command, starts at a random value so a restarted
+     *        receiver is not mistaken for a retransmission.
+     */
+    uint16_t nextSeq = 0;
 };
 
 #endif
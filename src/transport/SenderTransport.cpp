@@ -0,0 +1,68 @@
+#include "SenderTransport.h"
+#include <stddef.h>
+#include <string.h>
+#include <shared/Crc16.h>
+
+bool SenderTransport::parseCommand(const uint8_t *data, size_t length, CommandMessage &cmd, bool &shared) const
+{
+    shared = false;
+    if (length == sizeof(CommandMessage))
+    {
+        memcpy(&cmd, data, sizeof(cmd));
+        return cmd.magic == CMD_MAGIC && cmd.crc == crc16(data, offsetof(CommandMessage, crc));
+    }
+
+    GroupCommandHeader header;
+    if (length < sizeof(header) + sizeof(uint16_t))
+        return false;
+    memcpy(&header, data, sizeof(header));
+    const size_t crcOffset = sizeof(header) + header.macCount * 6;
+    if (header.magic != CMD_GROUP_MAGIC || header.macCount > CMD_GROUP_MAX_MACS || length != crcOffset + sizeof(uint16_t))
+        return false;
+    uint16_t crc;
+    memcpy(&crc, data + crcOffset, sizeof(crc));
+    if (crc != crc16(data, crcOffset))
+        return false;
+
+    bool addressed = header.target == TARGET_ALL || (header.target == TARGET_GROUPS && (header.groups & groups) != 0);
+    if (header.target == TARGET_MACS)
+    {
+        const uint8_t *mac = data + sizeof(header);
+        for (size_t i = 0; i < header.macCount && !addressed; i++, mac += 6)
+            addressed = memcmp(mac, ownMac, 6) == 0;
+    }
+    if (!addressed)
+        return false;
+
+    cmd.magic = CMD_MAGIC;
+    cmd.command = header.command;
+    cmd.seq = header.seq;
+    cmd.crc = 0;
+    shared = true;
+    return true;
+}
+
+size_t SenderTransport::encodeAck(uint16_t seq, uint8_t *out)
+{
+    CommandAck ack;
+    ack.magic = CMD_ACK_MAGIC;
+    ack.seq = seq;
+    ack.crc = crc16((const uint8_t *)&ack, offsetof(CommandAck, crc));
+    memcpy(out, &ack, sizeof(ack));
+    return sizeof(ack);
+}
+
+bool SenderTransport::isNewCommand(uint16_t seq)
+{
+    for (size_t i = 0; i < recentCount; i++)
+    {
+        if (recentSeqs[i] == seq)
+            return false;
+    }
+
+    recentSeqs[recentNext] = seq;
+    recentNext = (recentNext + 1) % COMMAND_DEDUP_SEQS;
+    if (recentCount < COMMAND_DEDUP_SEQS)
+        recentCount++;
+    return true;
+}
@@ -14,11 +14,47 @@
 #define SENDER_TRANSPORT_H
 
 #include <functional>
+#include <freertos/FreeRTOS.h>
 #include <shared/SensorMessage.h>
+#include <shared/TelemetryCodec.h>
 #include <shared/CommandMessage.h>
+#include "RateController.h"
 
 using CommandCallback = std::function<void(const CommandMessage &cmd)>;
 
+/**
+ * @brief Sequence numbers of recently executed commands, a retransmission of one of them
+ *        is acknowledged again but not executed twice.
+ */
+#ifndef COMMAND_DEDUP_SEQS
+#define COMMAND_DEDUP_SEQS 8
+#endif
+
+/**
+ * @brief Upper bound of the random delay before a sender acknowledges a command addressed to
+ *        many senders, so their ACKs do not all collide.
+ */
+#ifndef COMMAND_ACK_JITTER_MS
+#define COMMAND_ACK_JITTER_MS 8
+#endif
+
+/**
+ * @brief Counters of the transmit path. Latencies are measured from queueing a frame to
+ *        the radio reporting it as sent. Command acknowledgements are only counted in acks.
+ */
+struct TxStats
+{
+    uint32_t queued = 0;  ///< Frames accepted by sendTelemetry() and sendImuBatch()
+    uint32_t sent = 0;    ///< Frames the radio reported as sent
+    uint32_t failed = 0;  ///< Frames the radio refused or reported as failed, e.g. congested
+    uint32_t dropped = 0; ///< Frames dropped because the queue was full
+    uint32_t acks = 0;    ///< Command acknowledgements the radio reported as sent
+    uint32_t lastLatencyUs = 0;
+    uint32_t meanLatencyUs = 0; ///< Moving average over about the last 16 frames
+    uint32_t latencySumUs = 0;  ///< Latencies of all sent and failed frames added up, wraps
+    uint32_t maxLatencyUs = 0;
+};
+
 /**
  * @class SenderTransport
  * @brief Abstract base class for all sender transport implementations.
@@ -40,9 +76,17 @@ public:
     /**
      * @brief Send telemetry data to the receiver.
      * @param msg The sensor message containing telemetry data.
+     * @param groups Field groups that were sampled and are transmitted, see TelemetryGroup.
      * @return true if send successful, false otherwise.
      */
-    virtual bool sendTelemetry(const SensorMessage &msg) = 0;
+    virtual bool sendTelemetry(const SensorMessage &msg, uint8_t groups = TELEMETRY_GROUPS_ALL) = 0;
+
+    /**
+     * @brief Send a batch of IMU samples in one frame.
+     * @param batch The collected samples.
+     * @return true if send successful, false otherwise.
+     */
+    virtual bool sendImuBatch(const ImuBatch &batch) = 0;
 
     /**
      * @brief Set the callback function for incoming commands.
@@ -51,11 +95,114 @@ public:
      */
     void setCommandCallback(CommandCallback cb) { commandCallback = cb; }
 
+    /**
+     * @brief Set the groups this sender belongs to, one bit per group. A group command is
+     *        executed if it shares a bit with them.
+     * @param mask Group bits, 0 for none.
+     * @return void
+     */
+    void setGroups(uint8_t mask) { groups = mask; }
+
+    /**
+     * @brief Groups this sender belongs to, see setGroups().
+     * @return uint8_t
+     */
+    uint8_t getGroups() const { return groups; }
+
+    /**
+     * @brief Transmit counters since begin(), a consistent copy.
+     * @return TxStats
+     */
+    TxStats getTxStats() const
+    {
+        portENTER_CRITICAL(&txStatsMux);
+        const TxStats stats = txStats;
+        portEXIT_CRITICAL(&txStatsMux);
+        return stats;
+    }
+
+    /**
+     * @brief Let the rate controller judge the frames sent so far and get the time until
+     *        the next telemetry frame is due. Called after every telemetry frame.
+     * @return uint32_t Milliseconds.
+     */
+    uint32_t nextTelemetryIntervalMs()
+    {
+        rate.update(getTxStats());
+        return rate.getIntervalMs();
+    }
+
+    /**
+     * @brief Current interval between telemetry frames, see nextTelemetryIntervalMs().
+     * @return uint32_t Milliseconds.
+     */
+    uint32_t getTelemetryIntervalMs() const { return rate.getIntervalMs(); }
+
+    /**
+     * @brief Number of times the telemetry rate was halved because of congestion.
+     * @return uint32_t
+     */
+    uint32_t getRateBackoffs() const { return rate.getBackoffs(); }
+
 protected:
+    /**
+     * @brief Check a received command frame, either a CommandMessage or a group command,
+     *        and copy the command. ownMac has to be set for MAC lists to match.
+     * @param cmd The command, a group command is returned like a CommandMessage.
+     * @param shared Set if the frame was a group command that other senders answer too.
+     * @return false if data is not a valid command frame or not addressed to this sender.
+     */
+    bool parseCommand(const uint8_t *data, size_t length, CommandMessage &cmd, bool &shared) const;
+
+    /**
+     * @brief Encode the acknowledgement of a command.
+     * @param out Destination of sizeof(CommandAck) bytes.
+     * @return size_t Frame length.
+     */
+    static size_t encodeAck(uint16_t seq, uint8_t *out);
+
+    /**
+     * @brief Remember a command sequence number.
+     * @return false if seq was seen recently, the command was already executed.
+     */
+    bool isNewCommand(uint16_t seq);
+
+    /**
+     * @brief Address the receiver sees this sender under, set by begin().
+     */
+    uint8_t ownMac[6] = {};
+
     /**
      * @brief Callback function for incoming commands.
      */
     CommandCallback commandCallback;
+
+    /**
+     * @brief Keyframe state for delta encoding of outgoing telemetry.
+     */
+    TelemetryEncoder encoder;
+
+    /**
+     * @brief Updated by the implementation as frames are queued and sent, only while
+     *        holding txStatsMux. The radio callbacks run on a different task.
+     */
+    TxStats txStats;
+
+    /**
+     * @brief Guards txStats.
+     */
+    mutable portMUX_TYPE txStatsMux = portMUX_INITIALIZER_UNLOCKED;
+
+    /**
+     * @brief Telemetry rate, fed from txStats.
+     */
+    RateController rate;
+
+private:
+    uint8_t groups = 0;
+    uint16_t recentSeqs[COMMAND_DEDUP_SEQS]; ///< Ring of executed command sequence numbers
+    size_t recentCount = 0;
+    size_t recentNext = 0;
 };
 
 #endif
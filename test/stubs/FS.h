@@ -0,0 +1,79 @@
+/**
+ * @file FS.h
+ * @author Tim Dietrich, Felix Herrling
+ * @brief Host stand-in for the Arduino file system API used by the native tests. Every flash
+ * file is a file below a host directory, so the code under test reads and writes real bytes.
+ * Only the calls the firmware makes are provided.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef TEST_STUBS_FS_H
+#define TEST_STUBS_FS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <sys/stat.h>
+
+namespace fs {
+
+class File {
+public:
+    File() = default;
+    explicit File(FILE* file) : file_(file, [](FILE* f) { fclose(f); }) {}
+
+    explicit operator bool() const { return static_cast<bool>(file_); }
+
+    size_t read(uint8_t* buffer, size_t size) { return file_ ? fread(buffer, 1, size, file_.get()) : 0; }
+    size_t write(const uint8_t* buffer, size_t size) { return file_ ? fwrite(buffer, 1, size, file_.get()) : 0; }
+    bool seek(uint32_t position) { return file_ && fseek(file_.get(), static_cast<long>(position), SEEK_SET) == 0; }
+    void close() { file_.reset(); }
+
+private:
+    std::shared_ptr<FILE> file_;
+};
+
+/**
+ * @brief File system rooted at a host directory. While unmounted every call fails, like
+ * SPIFFS after a failed SPIFFS.begin().
+ */
+class FS {
+public:
+    explicit FS(const std::string& root) : root_(root) {}
+
+    void setMounted(bool mounted) { mounted_ = mounted; }
+
+    File open(const char* path, const char* mode = "r", bool create = false) {
+        (void)create;
+        if (!mounted_) {
+            return File();
+        }
+        FILE* file = fopen((root_ + path).c_str(), (std::string(mode) + "b").c_str());
+        return file ? File(file) : File();
+    }
+
+    bool exists(const char* path) {
+        struct stat status;
+        return mounted_ && stat((root_ + path).c_str(), &status) == 0;
+    }
+
+    bool remove(const char* path) { return mounted_ && ::remove((root_ + path).c_str()) == 0; }
+
+    bool mkdir(const char* path) { return mounted_ && ::mkdir((root_ + path).c_str(), 0755) == 0; }
+
+private:
+    std::string root_;
+    bool mounted_ = true;
+};
+
+} // namespace fs
+
+using fs::File;
+
+#endif // TEST_STUBS_FS_H
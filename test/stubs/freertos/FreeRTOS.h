@@ -0,0 +1,19 @@
+/**
+ * @file FreeRTOS.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief Host stand-in for the FreeRTOS types the portable sources use in the native tests.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef TEST_STUBS_FREERTOS_H
+#define TEST_STUBS_FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+
+#endif
@@ -0,0 +1,28 @@
+/**
+ * @file task.h
+ * @author Niclas Jost, Marius Busalt
+ * @brief Host stand-in for the FreeRTOS task functions the portable sources use in the native
+ *        tests. Host threads are preempted by the OS, so a delay only has to give up the CPU.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#ifndef TEST_STUBS_FREERTOS_TASK_H
+#define TEST_STUBS_FREERTOS_TASK_H
+
+#include <freertos/FreeRTOS.h>
+#include <chrono>
+#include <thread>
+
+inline void vTaskDelay(TickType_t ticks)
+{
+    if (ticks == 0)
+        std::this_thread::yield();
+    else
+        std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+#endif
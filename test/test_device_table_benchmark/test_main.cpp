@@ -0,0 +1,133 @@
+/**
+ * @file test_main.cpp
+ * @author Niclas Jost, Marius Busalt
+ * @brief Lookup benchmark of DeviceTable against the std::map keyed by formatted MAC strings it
+ *        replaced. Every lookup is a find-or-insert followed by an update, as in storeTelemetry.
+ *        std::string stands in for Arduino String, which is not available on the host. The native
+ *        env builds the table with room for 1024 devices, see platformio.ini.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <unity.h>
+#include <shared/DeviceTable.h>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <string>
+
+static_assert(DEVICE_TABLE_CAPACITY >= 1000, "the benchmark needs -DDEVICE_TABLE_CAPACITY=1024");
+
+namespace
+{
+    const uint32_t LOOKUPS = 200000;
+
+    // all bots share the vendor prefix, only the last bytes differ
+    void makeMac(uint32_t device, uint8_t *mac)
+    {
+        mac[0] = 0x24;
+        mac[1] = 0x6F;
+        mac[2] = 0x28;
+        mac[3] = (uint8_t)(device >> 16);
+        mac[4] = (uint8_t)(device >> 8);
+        mac[5] = (uint8_t)device;
+    }
+
+    struct MapEntry
+    {
+        SensorMessage msg;
+        unsigned long lastSeenMs;
+    };
+
+    double mapNsPerLookup(uint32_t devices)
+    {
+        std::map<std::string, MapEntry> senders;
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < LOOKUPS; i++)
+        {
+            uint8_t mac[6];
+            makeMac(i % devices, mac);
+            char key[18];
+            snprintf(key, sizeof(key), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+            MapEntry &entry = senders[key];
+            entry.msg.counter = i;
+            entry.lastSeenMs = i;
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        TEST_ASSERT_EQUAL_UINT32(devices, senders.size());
+        return std::chrono::duration<double, std::nano>(elapsed).count() / LOOKUPS;
+    }
+
+    double tableNsPerLookup(uint32_t devices)
+    {
+        // too large for the stack at 1024 devices
+        std::unique_ptr<DeviceTable> table(new DeviceTable());
+        const auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < LOOKUPS; i++)
+        {
+            uint8_t mac[6];
+            makeMac(i % devices, mac);
+            const int slot = table->insert(DeviceTable::packMac(mac));
+            SenderInfo &info = table->beginWrite(slot);
+            info.msg.counter = i;
+            info.lastSeenMs = i;
+            table->endWrite(slot);
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        TEST_ASSERT_EQUAL_UINT32(devices, table->size());
+        return std::chrono::duration<double, std::nano>(elapsed).count() / LOOKUPS;
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_every_device_keeps_its_slot()
+{
+    std::unique_ptr<DeviceTable> table(new DeviceTable());
+    for (uint32_t device = 0; device < DEVICE_TABLE_CAPACITY; device++)
+    {
+        uint8_t mac[6];
+        makeMac(device, mac);
+        TEST_ASSERT_EQUAL_INT((int)device, table->insert(DeviceTable::packMac(mac)));
+    }
+
+    uint8_t mac[6];
+    makeMac(DEVICE_TABLE_CAPACITY, mac);
+    TEST_ASSERT_EQUAL_INT(-1, table->insert(DeviceTable::packMac(mac)));
+    TEST_ASSERT_EQUAL_INT(-1, table->find(DeviceTable::packMac(mac)));
+
+    for (uint32_t device = 0; device < DEVICE_TABLE_CAPACITY; device++)
+    {
+        makeMac(device, mac);
+        TEST_ASSERT_EQUAL_INT((int)device, table->find(DeviceTable::packMac(mac)));
+        TEST_ASSERT_EQUAL_UINT64(DeviceTable::packMac(mac), table->macAt((int)device));
+    }
+}
+
+void test_lookup_benchmark()
+{
+    const uint32_t deviceCounts[] = {10, 100, 1000};
+    for (uint32_t devices : deviceCounts)
+    {
+        const double map = mapNsPerLookup(devices);
+        const double table = tableNsPerLookup(devices);
+        char line[128];
+        snprintf(line, sizeof(line), "%u devices: map + snprintf %.0f ns, DeviceTable %.0f ns per lookup",
+                 (unsigned)devices, map, table);
+        TEST_MESSAGE(line);
+    }
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_every_device_keeps_its_slot);
+    RUN_TEST(test_lookup_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,146 @@
+/**
+ * @file test_main.cpp
+ * @author Niclas Jost, Marius Busalt
+ * @brief Multi-threaded host test of the DeviceTable read protocol. Two writers, serialized by a
+ *        mutex like the two receive workers, insert devices and update them together with their
+ *        telemetry history while reader threads copy snapshots as the HTTP handlers do. Every
+ *        snapshot has to be consistent: all values written by one update, and the history
+ *        reached through info.history ending at that same update.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <unity.h>
+#include <shared/DeviceTable.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    const uint32_t WRITES_PER_WRITER = 20000;
+    const int READERS = 3;
+
+    uint64_t deviceMac(uint32_t device)
+    {
+        return 0x246F28000000ULL | device;
+    }
+
+    struct Snapshot
+    {
+        uint32_t counter;
+        uint32_t uptimeMs;
+        unsigned long lastSeenMs;
+        int16_t accelX;
+        uint32_t historyNewestMs;
+        float historyAccelX;
+        bool hasHistory;
+    };
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_readers_see_consistent_snapshots()
+{
+    std::unique_ptr<DeviceTable> table(new DeviceTable());
+    std::mutex writeMutex;
+    std::atomic<int> writersRunning{2};
+    std::atomic<uint32_t> reads{0};
+    std::atomic<uint32_t> inconsistent{0};
+
+    HistoryField accelField;
+    TEST_ASSERT_TRUE(TelemetryHistory::fieldByName("accelX", 6, accelField));
+
+    auto writer = [&](uint32_t firstDevice)
+    {
+        for (uint32_t i = 0; i < WRITES_PER_WRITER; i++)
+        {
+            // the writers share the devices, so their updates interleave on every slot
+            const uint32_t device = (firstDevice + i) % DEVICE_TABLE_CAPACITY;
+            std::lock_guard<std::mutex> lock(writeMutex);
+            const int slot = table->insert(deviceMac(device));
+            SenderInfo &info = table->beginWrite(slot);
+            const uint32_t value = info.msg.counter + 1;
+            info.msg.counter = value;
+            info.msg.uptimeMs = value * 10;
+            info.msg.accelX = (int16_t)value;
+            info.lastSeenMs = value;
+            if (info.history == nullptr)
+                info.history = new (std::nothrow) TelemetryHistory();
+            if (info.history != nullptr)
+                info.history->add(info.msg);
+            table->endWrite(slot);
+        }
+        writersRunning--;
+    };
+
+    auto reader = [&](uint32_t seed)
+    {
+        while (writersRunning.load() > 0)
+        {
+            seed = seed * 1103515245u + 12345u;
+            const int slot = table->find(deviceMac((seed >> 16) % DEVICE_TABLE_CAPACITY));
+            if (slot < 0)
+                continue;
+            Snapshot copy = {};
+            table->read(slot, [&](const SenderInfo &info)
+                        {
+                            copy.counter = info.msg.counter;
+                            copy.uptimeMs = info.msg.uptimeMs;
+                            copy.lastSeenMs = info.lastSeenMs;
+                            copy.accelX = info.msg.accelX;
+                            const TelemetryHistory *history = info.history;
+                            copy.hasHistory = history != nullptr && history->size(0) > 0;
+                            if (copy.hasHistory)
+                            {
+                                const size_t newest = history->size(0) - 1;
+                                copy.historyNewestMs = history->timestampAt(0, newest);
+                                copy.historyAccelX = history->valueAt(accelField, 0, newest);
+                            }
+                        });
+            reads++;
+            const bool consistent = copy.uptimeMs == copy.counter * 10
+                && copy.lastSeenMs == copy.counter
+                && copy.accelX == (int16_t)copy.counter
+                && (copy.counter == 0
+                    || (copy.hasHistory && copy.historyNewestMs == copy.uptimeMs
+                        && copy.historyAccelX == (float)copy.accelX));
+            if (!consistent)
+                inconsistent++;
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < READERS; i++)
+        threads.emplace_back(reader, (uint32_t)i + 1);
+    threads.emplace_back(writer, 0);
+    threads.emplace_back(writer, DEVICE_TABLE_CAPACITY / 2);
+    for (std::thread &thread : threads)
+        thread.join();
+
+    char line[96];
+    snprintf(line, sizeof(line), "%u snapshots, %u inconsistent", (unsigned)reads.load(), (unsigned)inconsistent.load());
+    TEST_MESSAGE(line);
+    TEST_ASSERT_GREATER_THAN(0, reads.load());
+    TEST_ASSERT_EQUAL_UINT32(0, inconsistent.load());
+    TEST_ASSERT_EQUAL_UINT32(DEVICE_TABLE_CAPACITY, table->size());
+
+    for (size_t slot = 0; slot < table->size(); slot++)
+        delete table->beginWrite((int)slot).history;
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_readers_see_consistent_snapshots);
+    return UNITY_END();
+}
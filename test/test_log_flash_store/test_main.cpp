@@ -0,0 +1,189 @@
+/**
+ * @file test_main.cpp
+ * @author Tim Dietrich, Felix Herrling
+ * @brief Host tests of LogFlashStore against a file-backed flash emulator, see test/stubs/FS.h.
+ * Every test works on its own empty directory; begin() on it again acts as a reboot.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <unity.h>
+#include <logger/LogFlashStore.h>
+#include <logger/LogDatabase.h>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string makeRoot() {
+        char pattern[] = "/tmp/dezibot_flash_XXXXXX";
+        const char* root = mkdtemp(pattern);
+        TEST_ASSERT_NOT_NULL(root);
+        return root;
+    }
+
+    LogEntry::Record makeRecord(const uint32_t timestampMs, const LogEntry::Level level, const uint32_t value) {
+        LogEntry::Record record = {};
+        record.timestampMs = timestampMs;
+        record.level = level;
+        record.formatId = LogEntry::FMT_TILT;
+        record.args[0] = value;
+        return record;
+    }
+
+    void appendText(LogFlashStore& store, const uint32_t timestampMs, const char* text) {
+        LogEntry::Record record = {};
+        record.timestampMs = timestampMs;
+        record.level = LogEntry::WARNING;
+        record.formatId = LogEntry::FMT_TEXT;
+        record.args[1] = static_cast<uint32_t>(strlen(text));
+        store.append(record, text);
+    }
+
+    struct Stored {
+        uint32_t bootId;
+        LogEntry::Record record;
+        std::string text;
+    };
+
+    std::vector<Stored> queryAll(LogFlashStore& store, const uint32_t bootId,
+                                 const uint32_t fromMs = 0, const uint32_t toMs = UINT32_MAX) {
+        std::vector<Stored> out;
+        const size_t count = store.query(bootId, fromMs, toMs,
+            [&](const uint32_t boot, const LogEntry::Record& record, const char* text) {
+                out.push_back({boot, record, text ? text : ""});
+            });
+        TEST_ASSERT_EQUAL_UINT32(out.size(), count);
+        return out;
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_begin_fails_without_mounted_file_system() {
+    fs::FS flash(makeRoot());
+    flash.setMounted(false);
+    TEST_ASSERT_FALSE(LogFlashStore::getInstance().begin(flash));
+}
+
+void test_records_and_text_round_trip() {
+    fs::FS flash(makeRoot());
+    LogFlashStore& store = LogFlashStore::getInstance();
+    TEST_ASSERT_TRUE(store.begin(flash));
+    const uint32_t bootId = store.getBootId();
+
+    for (uint32_t i = 0; i < 100; ++i) {
+        if (i % 10 == 0) {
+            appendText(store, i, ("message " + std::to_string(i)).c_str());
+        } else {
+            store.append(makeRecord(i, LogEntry::INFO, i), nullptr);
+        }
+        // the page buffers hold about 80 records, the drain task flushes long before that
+        if (i % 32 == 0) {
+            store.writePending(true);
+        }
+    }
+    store.writePending(true);
+
+    const std::vector<Stored> stored = queryAll(store, bootId);
+    TEST_ASSERT_EQUAL_UINT32(100, stored.size());
+    for (uint32_t i = 0; i < stored.size(); ++i) {
+        TEST_ASSERT_EQUAL_UINT32(bootId, stored[i].bootId);
+        TEST_ASSERT_EQUAL_UINT32(i, stored[i].record.timestampMs);
+        if (i % 10 == 0) {
+            TEST_ASSERT_EQUAL_STRING(("message " + std::to_string(i)).c_str(), stored[i].text.c_str());
+        } else {
+            TEST_ASSERT_EQUAL_UINT32(i, stored[i].record.args[0]);
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(11, queryAll(store, bootId, 40, 50).size());
+}
+
+void test_previous_boot_survives_reboot() {
+    fs::FS flash(makeRoot());
+    LogFlashStore& store = LogFlashStore::getInstance();
+    TEST_ASSERT_TRUE(store.begin(flash));
+    const uint32_t firstBoot = store.getBootId();
+    for (uint32_t i = 0; i < 20; ++i) {
+        store.append(makeRecord(i, LogEntry::ERROR, i), nullptr);
+    }
+    store.writePending(true);
+
+    TEST_ASSERT_TRUE(store.begin(flash));
+    TEST_ASSERT_EQUAL_UINT32(firstBoot + 1, store.getBootId());
+    store.append(makeRecord(5, LogEntry::INFO, 1000), nullptr);
+    store.writePending(true);
+
+    TEST_ASSERT_EQUAL_UINT32(20, queryAll(store, firstBoot).size());
+    const std::vector<Stored> current = queryAll(store, store.getBootId());
+    TEST_ASSERT_EQUAL_UINT32(1, current.size());
+    TEST_ASSERT_EQUAL_UINT32(1000, current[0].record.args[0]);
+}
+
+void test_rotation_keeps_newest_segments() {
+    fs::FS flash(makeRoot());
+    LogFlashStore& store = LogFlashStore::getInstance();
+    TEST_ASSERT_TRUE(store.begin(flash));
+    const uint32_t bootId = store.getBootId();
+    const uint32_t dropped = store.getDroppedRecords();
+
+    // 24 byte records, about ten segments worth
+    const uint32_t total = 7000;
+    for (uint32_t i = 0; i < total; ++i) {
+        store.append(makeRecord(i, LogEntry::INFO, i), nullptr);
+        if (i % 32 == 0) {
+            store.writePending(true);
+        }
+    }
+    store.writePending(true);
+    TEST_ASSERT_EQUAL_UINT32(dropped, store.getDroppedRecords());
+
+    const std::vector<Stored> stored = queryAll(store, bootId);
+    TEST_ASSERT_TRUE(stored.size() > 0 && stored.size() < total);
+    // the oldest records are gone, the rest is complete and in order
+    for (size_t i = 0; i < stored.size(); ++i) {
+        TEST_ASSERT_EQUAL_UINT32(total - stored.size() + i, stored[i].record.args[0]);
+    }
+}
+
+void test_query_does_not_block_writer() {
+    fs::FS flash(makeRoot());
+    LogFlashStore& store = LogFlashStore::getInstance();
+    TEST_ASSERT_TRUE(store.begin(flash));
+    for (uint32_t i = 0; i < 50; ++i) {
+        store.append(makeRecord(i, LogEntry::INFO, i), nullptr);
+    }
+    store.writePending(true);
+
+    // a slow HTTP client is simulated by a visitor that waits for a forced flush
+    bool flushed = true;
+    store.query(store.getBootId(), 0, UINT32_MAX, [&](uint32_t, const LogEntry::Record& record, const char*) {
+        if (record.timestampMs != 10) {
+            return;
+        }
+        store.append(makeRecord(100, LogEntry::ERROR, 100), nullptr);
+        std::future<void> writer = std::async(std::launch::async, [&] { store.writePending(true); });
+        flushed = writer.wait_for(std::chrono::seconds(2)) == std::future_status::ready;
+    });
+    TEST_ASSERT_TRUE(flushed);
+    TEST_ASSERT_EQUAL_UINT32(51, queryAll(store, store.getBootId()).size());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_begin_fails_without_mounted_file_system);
+    RUN_TEST(test_records_and_text_round_trip);
+    RUN_TEST(test_previous_boot_survives_reboot);
+    RUN_TEST(test_rotation_keeps_newest_segments);
+    RUN_TEST(test_query_does_not_block_writer);
+    return UNITY_END();
+}
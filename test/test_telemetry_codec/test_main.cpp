@@ -0,0 +1,259 @@
+/**
+ * @file test_main.cpp
+ * @author Niclas Jost, Marius Busalt
+ * @brief Host tests of TelemetryEncoder and TelemetryDecoder: round trips, lost keyframes,
+ *        sender restarts, keyframe eviction, and the compression ratio on a recorded-like
+ *        sensor trace compared to sending every frame as a keyframe.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <unity.h>
+#include <shared/TelemetryCodec.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+    const uint8_t MAC[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x01};
+
+    // a bot driving around: slow light and heap drift, noisy IMU, motors switching now and then
+    SensorMessage sample(uint32_t counter)
+    {
+        SensorMessage msg = {};
+        msg.magic = MSG_MAGIC;
+        msg.counter = counter;
+        msg.uptimeMs = 1000 + counter * 100;
+        msg.ambientLight = 250.0f + 20.0f * sinf(counter * 0.05f);
+        msg.colorR = 1200 + counter % 7;
+        msg.colorG = 1800 + counter % 5;
+        msg.colorB = 900 + counter % 3;
+        msg.colorW = 4000 + (counter / 10) % 20;
+        msg.irFront = 30 + counter % 2;
+        msg.irLeft = 28;
+        msg.irRight = 31;
+        msg.irBack = 29;
+        msg.dlBottom = 512 + (counter / 4) % 8;
+        msg.dlFront = 640;
+        msg.motorLeft = (counter / 50) % 2 ? 3900 : 0;
+        msg.motorRight = (counter / 50) % 2 ? 3900 : 0;
+        msg.accelX = (int16_t)(counter * 37 % 64 - 32);
+        msg.accelY = (int16_t)(counter * 53 % 64 - 32);
+        msg.accelZ = (int16_t)(2048 + counter * 11 % 16);
+        msg.gyroX = (int16_t)(counter * 13 % 20 - 10);
+        msg.gyroY = (int16_t)(counter * 17 % 20 - 10);
+        msg.gyroZ = (int16_t)(counter * 19 % 20 - 10);
+        msg.temperature = 31.5f + (counter / 100) * 0.01f;
+        msg.whoAmI = 0x47;
+        msg.tiltX = 2;
+        msg.tiltY = -1;
+        msg.tiltDirection = 1;
+        msg.freeHeap = 180000 - (counter % 16) * 64;
+        msg.minFreeHeap = 170000;
+        msg.taskCount = 14;
+        msg.chipTemp = 42.0f + (counter / 200) * 0.5f;
+        msg.estimatedPowerMw = 850 + counter % 11;
+        return msg;
+    }
+
+    // what the receiver should see: the values after one trip through a keyframe
+    SensorMessage quantized(const SensorMessage &msg, uint8_t groups)
+    {
+        uint8_t frame[TELEMETRY_MAX_FRAME];
+        size_t length = TelemetryFrame::encode(msg, groups, frame, sizeof(frame));
+        TEST_ASSERT_TRUE(TelemetryFrame::checkCrc(frame, length));
+        SensorMessage decoded;
+        uint8_t decodedGroups;
+        TEST_ASSERT_TRUE(TelemetryFrame::decode(frame, length, decoded, decodedGroups));
+        SensorMessage out = {};
+        TelemetryFrame::merge(out, decoded, decodedGroups);
+        return out;
+    }
+
+    bool receive(TelemetryDecoder &decoder, const uint8_t *mac, const uint8_t *frame, size_t length,
+                 SensorMessage &out, uint8_t &groups)
+    {
+        TEST_ASSERT_TRUE(TelemetryFrame::checkCrc(frame, length));
+        SensorMessage msg;
+        if (!decoder.decode(mac, frame, length, msg, groups))
+            return false;
+        out = {};
+        TelemetryFrame::merge(out, msg, groups);
+        return true;
+    }
+
+    void assertSameMessage(const SensorMessage &expected, const SensorMessage &actual)
+    {
+        TEST_ASSERT_EQUAL_UINT32(expected.counter, actual.counter);
+        TEST_ASSERT_EQUAL_MEMORY(&expected, &actual, sizeof(SensorMessage));
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_round_trip_of_keyframes_and_deltas()
+{
+    TelemetryEncoder encoder;
+    TelemetryDecoder decoder;
+    size_t deltas = 0;
+    for (uint32_t counter = 0; counter < 3 * TELEMETRY_KEYFRAME_INTERVAL; counter++)
+    {
+        const SensorMessage msg = sample(counter);
+        uint8_t frame[TELEMETRY_MAX_FRAME];
+        const size_t length = encoder.encode(msg, TELEMETRY_GROUPS_ALL, frame, sizeof(frame));
+        TEST_ASSERT_GREATER_THAN(0, length);
+
+        uint32_t keyCounter;
+        if (TelemetryFrame::deltaKeyCounter(frame, length, keyCounter))
+            deltas++;
+
+        SensorMessage received;
+        uint8_t groups;
+        TEST_ASSERT_TRUE(receive(decoder, MAC, frame, length, received, groups));
+        TEST_ASSERT_EQUAL_UINT8(TELEMETRY_GROUPS_ALL, groups);
+        assertSameMessage(quantized(msg, TELEMETRY_GROUPS_ALL), received);
+    }
+    TEST_ASSERT_GREATER_THAN(0, deltas);
+    TEST_ASSERT_EQUAL_UINT32(0, decoder.getMissingKeyframes());
+}
+
+void test_lost_keyframe_drops_deltas_until_the_next_one()
+{
+    TelemetryEncoder encoder;
+    TelemetryDecoder decoder;
+    uint32_t dropped = 0;
+    bool recovered = false;
+    for (uint32_t counter = 0; counter < 2 * TELEMETRY_KEYFRAME_INTERVAL + 1; counter++)
+    {
+        uint8_t frame[TELEMETRY_MAX_FRAME];
+        const size_t length = encoder.encode(sample(counter), TELEMETRY_GROUPS_ALL, frame, sizeof(frame));
+        uint32_t keyCounter;
+        const bool isDelta = TelemetryFrame::deltaKeyCounter(frame, length, keyCounter);
+        // the very first keyframe never arrives
+        if (counter == 0)
+        {
+            TEST_ASSERT_FALSE(isDelta);
+            continue;
+        }
+
+        SensorMessage received;
+        uint8_t groups;
+        const bool decoded = receive(decoder, MAC, frame, length, received, groups);
+        if (!recovered && isDelta)
+        {
+            TEST_ASSERT_FALSE(decoded);
+            dropped++;
+            continue;
+        }
+        TEST_ASSERT_TRUE(decoded);
+        recovered = true;
+        assertSameMessage(quantized(sample(counter), TELEMETRY_GROUPS_ALL), received);
+    }
+    TEST_ASSERT_TRUE(recovered);
+    TEST_ASSERT_EQUAL_UINT32(TELEMETRY_KEYFRAME_INTERVAL - 1, dropped);
+    TEST_ASSERT_EQUAL_UINT32(dropped, decoder.getMissingKeyframes());
+}
+
+void test_sender_restart_starts_with_a_keyframe()
+{
+    TelemetryEncoder encoder;
+    TelemetryDecoder decoder;
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    SensorMessage received;
+    uint8_t groups;
+    for (uint32_t counter = 0; counter < 5; counter++)
+    {
+        const size_t length = encoder.encode(sample(counter + 500), TELEMETRY_GROUPS_ALL, frame, sizeof(frame));
+        TEST_ASSERT_TRUE(receive(decoder, MAC, frame, length, received, groups));
+    }
+
+    // after a reset the counters start over, deltas must refer to the new keyframe only
+    TelemetryEncoder restarted;
+    for (uint32_t counter = 0; counter < TELEMETRY_KEYFRAME_INTERVAL; counter++)
+    {
+        const size_t length = restarted.encode(sample(counter), TELEMETRY_GROUPS_ALL, frame, sizeof(frame));
+        uint32_t keyCounter;
+        TEST_ASSERT_EQUAL(counter > 0, TelemetryFrame::deltaKeyCounter(frame, length, keyCounter));
+        TEST_ASSERT_TRUE(receive(decoder, MAC, frame, length, received, groups));
+        assertSameMessage(quantized(sample(counter), TELEMETRY_GROUPS_ALL), received);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, decoder.getMissingKeyframes());
+}
+
+void test_new_sender_evicts_the_longest_silent_keyframe()
+{
+    TelemetryDecoder decoder;
+    TelemetryEncoder encoders[TELEMETRY_DECODER_DEVICES + 1];
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    SensorMessage received;
+    uint8_t groups;
+    uint8_t mac[6] = {0x24, 0x6F, 0x28, 0x00, 0x00, 0x00};
+
+    // every sender sends a keyframe, then all but sender 0 keep talking
+    for (uint32_t counter = 0; counter < 3; counter++)
+    {
+        for (int sender = counter == 0 ? 0 : 1; sender < TELEMETRY_DECODER_DEVICES; sender++)
+        {
+            mac[5] = (uint8_t)sender;
+            const size_t length = encoders[sender].encode(sample(counter), TELEMETRY_GROUPS_ALL, frame, sizeof(frame));
+            TEST_ASSERT_TRUE(receive(decoder, mac, frame, length, received, groups));
+        }
+    }
+
+    // a new sender arrives, its deltas decode because sender 0 made room
+    mac[5] = TELEMETRY_DECODER_DEVICES;
+    for (uint32_t counter = 0; counter < 3; counter++)
+    {
+        const size_t length = encoders[TELEMETRY_DECODER_DEVICES].encode(sample(counter), TELEMETRY_GROUPS_ALL,
+                                                                          frame, sizeof(frame));
+        TEST_ASSERT_TRUE(receive(decoder, mac, frame, length, received, groups));
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, decoder.getEvictedKeyframes());
+
+    // the evicted sender loses its deltas until its next keyframe
+    mac[5] = 0;
+    const size_t length = encoders[0].encode(sample(1), TELEMETRY_GROUPS_ALL, frame, sizeof(frame));
+    TEST_ASSERT_FALSE(receive(decoder, mac, frame, length, received, groups));
+    TEST_ASSERT_EQUAL_UINT32(1, decoder.getMissingKeyframes());
+}
+
+void test_compression_ratio()
+{
+    const uint32_t frames = 1000;
+    const uint8_t groupSets[] = {TELEMETRY_GROUPS_ALL, GROUP_IMU, GROUP_COLOR | GROUP_IR | GROUP_MOTOR};
+    for (uint8_t groups : groupSets)
+    {
+        TelemetryEncoder encoder;
+        size_t coded = 0;
+        size_t keyframes = 0;
+        for (uint32_t counter = 0; counter < frames; counter++)
+        {
+            uint8_t frame[TELEMETRY_MAX_FRAME];
+            coded += encoder.encode(sample(counter), groups, frame, sizeof(frame));
+            keyframes += TelemetryFrame::encode(sample(counter), groups, frame, sizeof(frame));
+        }
+
+        char line[128];
+        snprintf(line, sizeof(line), "groups 0x%02X: %u bytes/frame as keyframes, %u with deltas, ratio %.2f",
+                 groups, (unsigned)(keyframes / frames), (unsigned)(coded / frames), (double)coded / keyframes);
+        TEST_MESSAGE(line);
+        TEST_ASSERT_TRUE(coded < keyframes);
+    }
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_of_keyframes_and_deltas);
+    RUN_TEST(test_lost_keyframe_drops_deltas_until_the_next_one);
+    RUN_TEST(test_sender_restart_starts_with_a_keyframe);
+    RUN_TEST(test_new_sender_evicts_the_longest_silent_keyframe);
+    RUN_TEST(test_compression_ratio);
+    return UNITY_END();
+}
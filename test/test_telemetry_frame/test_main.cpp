@@ -0,0 +1,148 @@
+/**
+ * @file test_main.cpp
+ * @author Niclas Jost, Marius Busalt
+ * @brief Host tests of the fixed-point wire encodings of TelemetryFrame. Every scaled field has
+ *        to come back within half a step of its scale, out of range values saturate, and the
+ *        delta path reproduces the keyframe quantization exactly.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <unity.h>
+#include <shared/TelemetryFrame.h>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+    SensorMessage roundTrip(const SensorMessage &msg, uint8_t groups)
+    {
+        uint8_t frame[TELEMETRY_MAX_FRAME];
+        size_t length = TelemetryFrame::encode(msg, groups, frame, sizeof(frame));
+        TEST_ASSERT_GREATER_THAN(0, length);
+        TEST_ASSERT_TRUE(TelemetryFrame::checkCrc(frame, length));
+        SensorMessage decoded;
+        uint8_t decodedGroups;
+        TEST_ASSERT_TRUE(TelemetryFrame::decode(frame, length, decoded, decodedGroups));
+        TEST_ASSERT_EQUAL_UINT8(groups, decodedGroups);
+        return decoded;
+    }
+
+    /**
+     * @brief Sweep a float field over [minimum, maximum] and check the decoded value against the
+     *        quantization step 1 / scale of its wire encoding.
+     */
+    void checkScaledField(float SensorMessage::*field, uint8_t group, float scale, float minimum, float maximum)
+    {
+        const float tolerance = 0.5f / scale + fabsf(maximum) * 1e-6f;
+        const int steps = 2000;
+        for (int i = 0; i <= steps; i++)
+        {
+            SensorMessage msg = {};
+            msg.*field = minimum + (maximum - minimum) * i / steps + 0.37f / scale;
+            if (msg.*field > maximum)
+                msg.*field = maximum;
+            const SensorMessage decoded = roundTrip(msg, group);
+            TEST_ASSERT_FLOAT_WITHIN(tolerance, msg.*field, decoded.*field);
+        }
+
+        // beyond the range the value saturates instead of wrapping around
+        SensorMessage msg = {};
+        msg.*field = maximum * 4 + 1000.0f;
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, maximum, roundTrip(msg, group).*field);
+        msg.*field = minimum < 0 ? minimum * 4 - 1000.0f : -1000.0f;
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, minimum, roundTrip(msg, group).*field);
+        msg.*field = NAN;
+        TEST_ASSERT_FLOAT_WITHIN(tolerance, 0.0f, roundTrip(msg, group).*field);
+    }
+}
+
+void setUp() {}
+
+void tearDown() {}
+
+void test_ambient_light_within_quarter_lux()
+{
+    checkScaledField(&SensorMessage::ambientLight, GROUP_COLOR, 4.0f, 0.0f, 65535 / 4.0f);
+}
+
+void test_temperature_within_centi_degree()
+{
+    checkScaledField(&SensorMessage::temperature, GROUP_IMU, 100.0f, -327.68f, 327.67f);
+}
+
+void test_chip_temperature_within_centi_degree()
+{
+    checkScaledField(&SensorMessage::chipTemp, GROUP_SYSTEM, 100.0f, -327.68f, 327.67f);
+}
+
+void test_tilt_is_exact_and_clamped()
+{
+    for (int32_t tilt = -180; tilt <= 180; tilt++)
+    {
+        SensorMessage msg = {};
+        msg.tiltX = tilt;
+        msg.tiltY = -tilt;
+        const SensorMessage decoded = roundTrip(msg, GROUP_IMU);
+        TEST_ASSERT_EQUAL_INT32(tilt, decoded.tiltX);
+        TEST_ASSERT_EQUAL_INT32(-tilt, decoded.tiltY);
+    }
+
+    SensorMessage msg = {};
+    msg.tiltX = 100000;
+    msg.tiltY = -100000;
+    const SensorMessage decoded = roundTrip(msg, GROUP_IMU);
+    TEST_ASSERT_EQUAL_INT32(INT16_MAX, decoded.tiltX);
+    TEST_ASSERT_EQUAL_INT32(INT16_MIN, decoded.tiltY);
+}
+
+void test_delta_frames_match_keyframe_quantization()
+{
+    SensorMessage key = {};
+    key.counter = 1;
+    key.ambientLight = 100.0f;
+    key.temperature = 25.0f;
+    key.chipTemp = 40.0f;
+    const uint8_t groups = GROUP_COLOR | GROUP_IMU | GROUP_SYSTEM;
+
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    size_t length = TelemetryFrame::encode(key, groups, frame, sizeof(frame));
+    TEST_ASSERT_TRUE(TelemetryFrame::checkCrc(frame, length));
+    SensorMessage decodedKey;
+    uint8_t keyGroups;
+    TEST_ASSERT_TRUE(TelemetryFrame::decode(frame, length, decodedKey, keyGroups));
+
+    for (int i = 1; i < 500; i++)
+    {
+        SensorMessage msg = key;
+        msg.counter = key.counter + i;
+        msg.ambientLight = key.ambientLight + i * 0.113f;
+        msg.temperature = key.temperature - i * 0.0271f;
+        msg.chipTemp = key.chipTemp + i * 0.0437f;
+
+        length = TelemetryFrame::encodeDelta(msg, groups, key, key.counter, frame, sizeof(frame));
+        TEST_ASSERT_TRUE(TelemetryFrame::checkCrc(frame, length));
+        SensorMessage delta;
+        uint8_t deltaGroups;
+        TEST_ASSERT_TRUE(TelemetryFrame::decodeDelta(frame, length, decodedKey, keyGroups, delta, deltaGroups));
+
+        const SensorMessage expected = roundTrip(msg, groups);
+        TEST_ASSERT_EQUAL_MEMORY(&expected.ambientLight, &delta.ambientLight, sizeof(float));
+        TEST_ASSERT_EQUAL_MEMORY(&expected.temperature, &delta.temperature, sizeof(float));
+        TEST_ASSERT_EQUAL_MEMORY(&expected.chipTemp, &delta.chipTemp, sizeof(float));
+    }
+}
+
+int main(int, char **)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_ambient_light_within_quarter_lux);
+    RUN_TEST(test_temperature_within_centi_degree);
+    RUN_TEST(test_chip_temperature_within_centi_degree);
+    RUN_TEST(test_tilt_is_exact_and_clamped);
+    RUN_TEST(test_delta_frames_match_keyframe_quantization);
+    return UNITY_END();
+}
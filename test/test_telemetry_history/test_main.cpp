@@ -0,0 +1,89 @@
+/**
+ * @file test_main.cpp
+ * @author Niclas Jost, Marius Busalt
+ * @brief Host tests of TelemetryHistory. The rollups have to report min/max/mean of the samples
+ *        in each bucket, fields without rollups only come back from the raw ring, and a
+ *        history stays smaller than two raw rings.
+ * @version 1.0
+ * @date 2026-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include <unity.h>
+#include <shared/TelemetryHistory.h>
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+    TelemetryHistory history;
+
+    SensorMessage sample(uint32_t uptimeMs, float ambientLight, int16_t accelX)
+    {
+        SensorMessage msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.uptimeMs = uptimeMs;
+        msg.ambientLight = ambientLight;
+        msg.accelX = accelX;
+        return msg;
+    }
+}
+
+void setUp()
+{
+    history.clear();
+}
+
+void tearDown()
+{
+}
+
+void test_rollup_keeps_min_max_mean_per_bucket()
+{
+    // one bucket of 10 s with 1, 2 ... 10 lux, the next one with 20 lux only
+    for (uint32_t i = 0; i < 10; i++)
+        TEST_ASSERT_TRUE(history.add(sample(i * 1000, (float)(i + 1), 0)));
+    TEST_ASSERT_TRUE(history.add(sample(10000, 20.0f, 0)));
+
+    TEST_ASSERT_EQUAL(2, history.size(1));
+    TEST_ASSERT_EQUAL_UINT32(0, history.timestampAt(1, 0));
+    TEST_ASSERT_EQUAL_UINT32(10000, history.timestampAt(1, 1));
+    TEST_ASSERT_FLOAT_WITHIN(0.25f, 1.0f, history.valueAt(HISTORY_AMBIENT_LIGHT, 1, 0, HISTORY_MIN));
+    TEST_ASSERT_FLOAT_WITHIN(0.25f, 10.0f, history.valueAt(HISTORY_AMBIENT_LIGHT, 1, 0, HISTORY_MAX));
+    TEST_ASSERT_FLOAT_WITHIN(0.25f, 5.5f, history.valueAt(HISTORY_AMBIENT_LIGHT, 1, 0, HISTORY_MEAN));
+    TEST_ASSERT_FLOAT_WITHIN(0.25f, 20.0f, history.valueAt(HISTORY_AMBIENT_LIGHT, 1, 1, HISTORY_MEAN));
+
+    // all eleven samples fall into the first minute
+    TEST_ASSERT_EQUAL(1, history.size(2));
+    TEST_ASSERT_FLOAT_WITHIN(0.25f, 20.0f, history.valueAt(HISTORY_AMBIENT_LIGHT, 2, 0, HISTORY_MAX));
+}
+
+void test_field_without_rollups_is_raw_only()
+{
+    TEST_ASSERT_TRUE(TelemetryHistory::hasRollups(HISTORY_AMBIENT_LIGHT));
+    TEST_ASSERT_TRUE(TelemetryHistory::hasRollups(HISTORY_FREE_HEAP));
+    TEST_ASSERT_FALSE(TelemetryHistory::hasRollups(HISTORY_ACCEL_X));
+    TEST_ASSERT_FALSE(TelemetryHistory::hasRollups(HISTORY_COLOR_R));
+
+    TEST_ASSERT_TRUE(history.add(sample(0, 0.0f, -1234)));
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, -1234.0f, history.valueAt(HISTORY_ACCEL_X, 0, 0));
+    TEST_ASSERT_TRUE(isnan(history.valueAt(HISTORY_ACCEL_X, 1, 0)));
+    TEST_ASSERT_TRUE(isnan(history.valueAt(HISTORY_ACCEL_X, 2, 0, HISTORY_MAX)));
+}
+
+void test_rollups_take_less_than_the_raw_ring()
+{
+    const size_t raw = TELEMETRY_HISTORY_SAMPLES * (sizeof(uint32_t) + HISTORY_FIELD_COUNT * sizeof(uint16_t));
+    TEST_ASSERT_LESS_THAN(2 * raw, sizeof(TelemetryHistory));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_rollup_keeps_min_max_mean_per_bucket);
+    RUN_TEST(test_field_without_rollups_is_raw_only);
+    RUN_TEST(test_rollups_take_less_than_the_raw_ring);
+    return UNITY_END();
+}
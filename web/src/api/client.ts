@@ -5,11 +5,33 @@ export interface SwarmDevice {
   lastSeen: number;
   online: boolean;
   powerMw: number;
+  received: number;
+  dropped: number;
+  duplicates: number;
+  reordered: number;
+  crcErrors: number;
 }
 
 export interface SensorValue {
   name: string;
   value: string;
+  /** Comma separated history fields behind value, in value order. Only set for remote devices. */
+  fields?: string;
+}
+
+export interface SensorHistory {
+  /** Sender uptime of the newest stored sample in milliseconds, 0 without history. */
+  latest: number;
+  /** Bucket width of the returned entries, 0 for raw samples. */
+  resolutionMs: number;
+  /** Sender uptime of every returned sample, or start of every bucket, in milliseconds. */
+  t: number[];
+  /** One value per entry of t for every requested field, the bucket mean for rollups. */
+  fields: Record<string, number[]>;
+  /** Bucket minimums, only for rollups. */
+  min?: Record<string, number[]>;
+  /** Bucket maximums, only for rollups. */
+  max?: Record<string, number[]>;
 }
 
 export interface LogEntry {
@@ -46,24 +68,58 @@ export async function fetchSensorValues(mac?: string): Promise<SensorValue[]> {
   return res.json();
 }
 
-function buildLogsQuery(level: LogLevel, mac?: string): string {
+export async function fetchHistory(
+  mac: string,
+  fields: string,
+  points: number,
+  since?: number,
+): Promise<SensorHistory> {
+  const params = new URLSearchParams({ mac, field: fields, points: points.toString() });
+  if (since !== undefined) {
+    params.set("since", since.toString());
+  }
+  const res = await fetch(`/getHistory?${params.toString()}`);
+  if (!res.ok) throw new Error("Failed to fetch history");
+  return res.json();
+}
+
+export interface LogPage {
+  logs: LogEntry[];
+  /** Cursor for the next fetchNewLogs call, from the X-Log-Seq header. */
+  seq: number;
+}
+
+function buildLogsQuery(level: LogLevel, mac?: string, since?: number): string {
   const params = new URLSearchParams({ level });
   if (mac) {
     params.set("mac", mac);
   }
+  if (since !== undefined) {
+    params.set("since", since.toString());
+  }
   return params.toString();
 }
 
-export async function fetchLogs(level: LogLevel, mac?: string): Promise<LogEntry[]> {
+async function readLogPage(res: Response, fallbackSeq: number): Promise<LogPage> {
+  const header = res.headers.get("X-Log-Seq");
+  const seq = header !== null ? Number(header) : fallbackSeq;
+  return { logs: await res.json(), seq: Number.isFinite(seq) ? seq : fallbackSeq };
+}
+
+export async function fetchLogs(level: LogLevel, mac?: string): Promise<LogPage> {
   const res = await fetch(`/logging/getLogs?${buildLogsQuery(level, mac)}`);
   if (!res.ok) throw new Error("Failed to fetch logs");
-  return res.json();
+  return readLogPage(res, 0);
 }
 
-export async function fetchNewLogs(level: LogLevel, mac?: string): Promise<LogEntry[]> {
-  const res = await fetch(`/logging/getNewLogs?${buildLogsQuery(level, mac)}`);
+export async function fetchNewLogs(
+  level: LogLevel,
+  since: number,
+  mac?: string,
+): Promise<LogPage> {
+  const res = await fetch(`/logging/getNewLogs?${buildLogsQuery(level, mac, since)}`);
   if (!res.ok) throw new Error("Failed to fetch new logs");
-  return res.json();
+  return readLogPage(res, since);
 }
 
 export async function fetchSensorSettings(): Promise<SensorGroup[]> {
@@ -72,31 +128,72 @@ export async function fetchSensorSettings(): Promise<SensorGroup[]> {
   return res.json();
 }
 
-export async function locateDevice(mac: string): Promise<void> {
-  const res = await fetch("/command/locate", {
-    method: "POST",
-    headers: { "Content-Type": "application/x-www-form-urlencoded" },
-    body: `mac=${encodeURIComponent(mac)}`,
-  });
-  if (!res.ok) throw new Error("Failed to send locate command");
+export interface CommandResult {
+  attempts: number;
+  /** From the last transmission to the acknowledgement, in microseconds. */
+  rttUs: number;
+  /** From the first transmission to the acknowledgement. */
+  totalUs: number;
 }
 
-export async function forwardDevice(mac: string): Promise<void> {
-  const res = await fetch("/command/forward", {
+async function sendCommand(path: string, mac: string, name: string): Promise<CommandResult> {
+  const res = await fetch(path, {
     method: "POST",
     headers: { "Content-Type": "application/x-www-form-urlencoded" },
     body: `mac=${encodeURIComponent(mac)}`,
   });
-  if (!res.ok) throw new Error("Failed to send forward command");
+  if (!res.ok) {
+    const body = await res.json().catch(() => ({}));
+    if (body.error === "no ack")
+      throw new Error(`${name} command not acknowledged after ${body.attempts} attempts`);
+    throw new Error(`Failed to send ${name} command`);
+  }
+  return res.json();
+}
+
+export function locateDevice(mac: string): Promise<CommandResult> {
+  return sendCommand("/command/locate", mac, "locate");
+}
+
+export function forwardDevice(mac: string): Promise<CommandResult> {
+  return sendCommand("/command/forward", mac, "forward");
 }
 
-export async function stopDevice(mac: string): Promise<void> {
-  const res = await fetch("/command/stop", {
+export function stopDevice(mac: string): Promise<CommandResult> {
+  return sendCommand("/command/stop", mac, "stop");
+}
+
+export type CommandName = "locate" | "forward" | "stop";
+
+export interface BatchCommandResult {
+  attempts: number;
+  /** Until the slower transport finished, both send at the same time. */
+  totalUs: number;
+  /** Time each transport took, 0 if it had nobody to address. */
+  espNowUs: number;
+  bleUs: number;
+  acked: string[];
+  /** Devices that were expected to acknowledge but did not. */
+  missing: string[];
+}
+
+/** One frame for many devices: all of them, a group mask or a list of MACs. */
+export async function sendBatchCommand(
+  command: CommandName,
+  target: { macs?: string[]; groups?: number } = {},
+): Promise<BatchCommandResult> {
+  const params = new URLSearchParams({ command });
+  if (target.macs) params.set("macs", target.macs.join(","));
+  if (target.groups !== undefined) params.set("groups", String(target.groups));
+  const res = await fetch("/command/batch", {
     method: "POST",
     headers: { "Content-Type": "application/x-www-form-urlencoded" },
-    body: `mac=${encodeURIComponent(mac)}`,
+    body: params.toString(),
   });
-  if (!res.ok) throw new Error("Failed to send stop command");
+  // 504 still lists who acknowledged and who did not
+  if (!res.ok && res.status !== 504)
+    throw new Error(`Failed to send ${command} command`);
+  return res.json();
 }
 
 export async function toggleSensorFunction(
@@ -9,6 +9,7 @@ import {
   Legend,
   Tooltip,
 } from "chart.js";
+import { fetchHistory } from "@/api/client";
 
 Chart.register(
   LineController,
@@ -24,6 +25,10 @@ interface SensorChartProps {
   name: string;
   value: string;
   chartLimit: number;
+  /** With fields set, the chart is filled from the receiver's history of this device. */
+  mac?: string;
+  /** Comma separated history fields, in the order of the values in value. */
+  fields?: string;
 }
 
 const COLORS = [
@@ -106,6 +111,48 @@ export function SensorChart(props: SensorChartProps) {
     chart.update("none");
   }
 
+  // remote devices: load the stored window once, then only the samples newer than the last one
+  let lastTimestamp: number | undefined;
+  let loading = false;
+
+  async function loadHistory(mac: string, fields: string, limit: number) {
+    if (!chart || loading) return;
+    loading = true;
+    try {
+      // the first request covers as much as the receiver keeps, long ranges come as rollups
+      const history = await fetchHistory(mac, fields, limit, lastTimestamp);
+      if (lastTimestamp !== undefined && history.latest < lastTimestamp) {
+        // the sender restarted, start over with its new uptime
+        dataStore.forEach((data) => data.splice(0));
+        lastTimestamp = undefined;
+        return;
+      }
+      const columns = fields.split(",").map((field) => history.fields[field] ?? []);
+      history.t.forEach((timestamp, j) => {
+        columns.forEach((column, i) => {
+          dataStore[i]?.push({ x: timestamp / 1000, y: column[j] });
+        });
+        lastTimestamp = timestamp;
+      });
+      dataStore.forEach((data) => {
+        if (data.length > limit) data.splice(0, data.length - limit);
+      });
+      chart?.update("none");
+    } catch {
+      // keep the current points, the next update tries again
+    } finally {
+      loading = false;
+    }
+  }
+
+  function update(value: string, limit: number) {
+    if (props.mac && props.fields) {
+      void loadHistory(props.mac, props.fields, limit);
+    } else {
+      addDataPoint(value, limit);
+    }
+  }
+
   onMount(() => {
     const { labels } = parseValue(props.value);
     const datasets = labels.map((label, i) => {
@@ -149,7 +196,7 @@ export function SensorChart(props: SensorChartProps) {
       },
     });
 
-    addDataPoint(props.value, props.chartLimit);
+    update(props.value, props.chartLimit);
     setReady(true);
   });
 
@@ -161,7 +208,7 @@ export function SensorChart(props: SensorChartProps) {
     const value = props.value;
     const limit = props.chartLimit;
     if (!ready()) return;
-    addDataPoint(value, limit);
+    update(value, limit);
   });
 
   return (
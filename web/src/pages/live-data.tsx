@@ -87,6 +87,8 @@ export default function LiveDataPage() {
                     name={sensor().name}
                     value={sensor().value}
                     chartLimit={chartLimit()}
+                    mac={mac()}
+                    fields={sensor().fields}
                   />
                 </div>
               )}
@@ -81,6 +81,7 @@ export default function LoggingPage() {
       : ALL_SENDERS,
   );
   const [allLogs, setAllLogs] = createSignal<LogEntry[]>([]);
+  const [cursor, setCursor] = createSignal<number | undefined>(undefined);
   const [isExporting, setIsExporting] = createSignal(false);
 
   const selectedMac = () =>
@@ -111,6 +112,7 @@ export default function LoggingPage() {
         if (nextSender !== sender()) {
           setSender(nextSender);
           setAllLogs([]);
+          setCursor(undefined);
         }
       },
     ),
@@ -126,14 +128,18 @@ export default function LoggingPage() {
     on(
       () => initialQuery.data,
       (data) => {
-        if (data) setAllLogs(data);
+        if (data) {
+          setAllLogs(data.logs);
+          setCursor(data.seq);
+        }
       },
     ),
   );
 
   const newLogsQuery = useQuery(() => ({
     queryKey: ["newLogs", level(), sender()],
-    queryFn: () => fetchNewLogs(level(), selectedMac()),
+    queryFn: () => fetchNewLogs(level(), cursor() ?? 0, selectedMac()),
+    enabled: cursor() !== undefined,
     refetchInterval: 1000,
     refetchOnWindowFocus: false,
   }));
@@ -142,8 +148,10 @@ export default function LoggingPage() {
     on(
       () => newLogsQuery.data,
       (newData) => {
-        if (newData && newData.length > 0) {
-          setAllLogs((prev) => [...prev, ...newData]);
+        if (!newData) return;
+        setCursor(newData.seq);
+        if (newData.logs.length > 0) {
+          setAllLogs((prev) => [...prev, ...newData.logs]);
         }
       },
     ),
@@ -151,6 +159,7 @@ export default function LoggingPage() {
 
   function handleRefresh() {
     setAllLogs([]);
+    setCursor(undefined);
     initialQuery.refetch();
   }
 
@@ -158,6 +167,7 @@ export default function LoggingPage() {
     if (value) {
       setLevel(value);
       setAllLogs([]);
+      setCursor(undefined);
     }
   }
 
@@ -177,6 +187,7 @@ export default function LoggingPage() {
 
     setSender(value);
     setAllLogs([]);
+    setCursor(undefined);
 
     if (value === ALL_SENDERS) {
       if (currentMac) {
@@ -197,7 +208,7 @@ export default function LoggingPage() {
 
     setIsExporting(true);
     try {
-      const logs = await fetchLogs(level(), selectedMac());
+      const { logs } = await fetchLogs(level(), selectedMac());
       const csvContent = buildCsv(logs);
       const blob = new Blob([csvContent], { type: "text/csv;charset=utf-8" });
       const url = URL.createObjectURL(blob);
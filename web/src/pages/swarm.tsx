@@ -1,7 +1,17 @@
 import { useNavigate } from "@solidjs/router";
 import { useQuery } from "@tanstack/solid-query";
-import { For, Show } from "solid-js";
-import { fetchSwarmData, locateDevice, forwardDevice, stopDevice } from "@/api/client";
+import { createSignal, For, Show } from "solid-js";
+import {
+  fetchSwarmData,
+  locateDevice,
+  forwardDevice,
+  stopDevice,
+  sendBatchCommand,
+  type BatchCommandResult,
+  type CommandName,
+  type CommandResult,
+  type SwarmDevice,
+} from "@/api/client";
 import { Badge } from "@/components/ui/badge";
 import { Button } from "@/components/ui/button";
 import {
@@ -23,14 +33,53 @@ function formatUptime(ms: number): string {
   return `${sec}s`;
 }
 
+function formatLoss(device: SwarmDevice): string {
+  const expected = device.received + device.dropped;
+  if (expected === 0) return "—";
+  return `${((device.dropped / expected) * 100).toFixed(1)}%`;
+}
+
 function formatLastSeen(ms: number): string {
   if (ms < 1000) return "just now";
   if (ms < 60000) return `${Math.floor(ms / 1000)}s ago`;
   return `${Math.floor(ms / 60000)}m ago`;
 }
 
+function formatCommandResult(result: CommandResult): string {
+  const rtt = (result.rttUs / 1000).toFixed(1);
+  const attempts = result.attempts === 1 ? "1 attempt" : `${result.attempts} attempts`;
+  return `acknowledged in ${rtt} ms (${attempts}, ${(result.totalUs / 1000).toFixed(1)} ms total)`;
+}
+
+function formatBatchResult(result: BatchCommandResult): string {
+  const total = (result.totalUs / 1000).toFixed(1);
+  const attempts = result.attempts === 1 ? "1 attempt" : `${result.attempts} attempts`;
+  const perTransport = [
+    result.espNowUs > 0 ? `ESP-NOW ${(result.espNowUs / 1000).toFixed(1)} ms` : undefined,
+    result.bleUs > 0 ? `BLE ${(result.bleUs / 1000).toFixed(1)} ms` : undefined,
+  ].filter((part) => part !== undefined);
+  const summary = `${result.acked.length} acknowledged in ${total} ms (${[attempts, ...perTransport].join(", ")})`;
+  if (result.missing.length === 0) return summary;
+  return `${summary}, no answer from ${result.missing.join(", ")}`;
+}
+
 export default function SwarmPage() {
   const navigate = useNavigate();
+  const [commandStatus, setCommandStatus] = createSignal<string>();
+
+  const runCommand = (
+    name: string,
+    mac: string,
+    send: (mac: string) => Promise<CommandResult>,
+  ) => {
+    send(mac)
+      .then((result) =>
+        setCommandStatus(`${name} ${mac}: ${formatCommandResult(result)}`),
+      )
+      .catch((err: Error) =>
+        setCommandStatus(`${name} ${mac}: ${err.message}`),
+      );
+  };
 
   const query = useQuery(() => ({
     queryKey: ["swarm"],
@@ -43,15 +92,18 @@ export default function SwarmPage() {
 
   const onlineCount = () => devices().filter((d) => d.online).length;
 
-  const onlineDevices = () => devices().filter((d) => d.online);
-
-  const handleForwardAll = () => {
-    onlineDevices().forEach((d) => forwardDevice(d.mac));
+  // the whole swarm in one request and one broadcast frame
+  const runBatchCommand = (name: string, command: CommandName) => {
+    sendBatchCommand(command)
+      .then((result) =>
+        setCommandStatus(`${name} all: ${formatBatchResult(result)}`),
+      )
+      .catch((err: Error) => setCommandStatus(`${name} all: ${err.message}`));
   };
 
-  const handleStopAll = () => {
-    onlineDevices().forEach((d) => stopDevice(d.mac));
-  };
+  const handleForwardAll = () => runBatchCommand("Forward", "forward");
+
+  const handleStopAll = () => runBatchCommand("Stop", "stop");
 
   return (
     <div class="max-w-4xl mx-auto space-y-4">
@@ -72,6 +124,10 @@ export default function SwarmPage() {
         </div>
       </div>
 
+      <Show when={commandStatus()}>
+        <p class="text-sm text-muted-foreground">{commandStatus()}</p>
+      </Show>
+
       <Show
         when={!query.isPending}
         fallback={<p class="text-muted-foreground">Loading...</p>}
@@ -91,6 +147,7 @@ export default function SwarmPage() {
                 <TableHead>Uptime</TableHead>
                 <TableHead>Last Seen</TableHead>
                 <TableHead>Power</TableHead>
+                <TableHead>Loss</TableHead>
                 <TableHead class="w-[220px]">Actions</TableHead>
               </TableRow>
             </TableHeader>
@@ -136,6 +193,12 @@ export default function SwarmPage() {
                           : `${device.powerMw} mW`
                         : "—"}
                     </TableCell>
+                    <TableCell
+                      class="font-mono text-xs"
+                      title={`${device.received} received, ${device.dropped} lost, ${device.duplicates} duplicates, ${device.reordered} reordered, ${device.crcErrors} CRC errors`}
+                    >
+                      {formatLoss(device)}
+                    </TableCell>
                     <TableCell>
                       <div class="flex items-center gap-2">
                         <Button
@@ -156,7 +219,7 @@ export default function SwarmPage() {
                           size="sm"
                           onClick={(e: MouseEvent) => {
                             e.stopPropagation();
-                            locateDevice(device.mac);
+                            runCommand("Locate", device.mac, locateDevice);
                           }}
                         >
                           Locate
@@ -166,7 +229,7 @@ export default function SwarmPage() {
                           size="sm"
                           onClick={(e: MouseEvent) => {
                             e.stopPropagation();
-                            forwardDevice(device.mac);
+                            runCommand("Forward", device.mac, forwardDevice);
                           }}
                         >
                           Forward
@@ -176,7 +239,7 @@ export default function SwarmPage() {
                           size="sm"
                           onClick={(e: MouseEvent) => {
                             e.stopPropagation();
-                            stopDevice(device.mac);
+                            runCommand("Stop", device.mac, stopDevice);
                           }}
                         >
                           Stop